@@ -0,0 +1,272 @@
+/*
+ * alias.c - MyShell 别名
+ *
+ * 功能：维护别名表（alias、unalias 命令）。别名在语法分析时展开
+ *       （见 parser.c），每条命令只展开一次，循环体等重复执行的
+ *       语法树不再查找别名
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+
+/* 哈希表桶数（2 的幂） */
+#define ALIAS_BUCKETS 64
+
+/**
+ * Alias 结构体 - 一个别名
+ *
+ * 字段说明：
+ *   name   - 别名
+ *   value  - 替换文本
+ *   next   - 同一个桶中的下一个别名
+ */
+typedef struct Alias {
+    char *name;
+    char *value;
+    struct Alias *next;
+} Alias;
+
+/* 别名哈希表 */
+static Alias *alias_table[ALIAS_BUCKETS];
+
+/* 别名个数，为 0 时语法分析不查表 */
+static int alias_count = 0;
+
+/* ========== 别名表 ========== */
+
+/**
+ * alias_hash - 计算别名的哈希值（FNV-1a）
+ */
+static unsigned int alias_hash(const char *name) {
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0') {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash & (ALIAS_BUCKETS - 1);
+}
+
+/**
+ * alias_find - 在哈希表中查找别名
+ *
+ * 参数：name - 别名，link - 输出参数，保存指向该别名的链接（可为 NULL）
+ * 返回：别名，不存在返回 NULL
+ */
+static Alias* alias_find(const char *name, Alias ***link) {
+    Alias **p;
+
+    for (p = &alias_table[alias_hash(name)]; *p != NULL; p = &(*p)->next) {
+        if (strcmp((*p)->name, name) == 0) {
+            break;
+        }
+    }
+    if (link != NULL) {
+        *link = p;
+    }
+    return *p;
+}
+
+/**
+ * alias_valid_name - 检查别名是否合法
+ *
+ * 功能：别名不能为空，不能含有 =、引号、$、反斜杠、空白和 ;&|<>() 等符号
+ */
+static int alias_valid_name(const char *name) {
+    return name[0] != '\0' && strpbrk(name, "=\"'$`\\ \t\n;&|<>()") == NULL;
+}
+
+/**
+ * alias_get - 获取别名的替换文本
+ *
+ * 参数：name - 别名
+ * 返回：替换文本，不是别名返回 NULL
+ */
+const char* alias_get(const char *name) {
+    Alias *alias;
+
+    if (alias_count == 0) {
+        return NULL;
+    }
+    alias = alias_find(name, NULL);
+    return alias != NULL ? alias->value : NULL;
+}
+
+/**
+ * alias_set - 定义或重新定义别名
+ *
+ * 参数：name - 别名，value - 替换文本
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int alias_set(const char *name, const char *value) {
+    Alias **link;
+    Alias *alias = alias_find(name, &link);
+    char *copy = strdup(value);
+
+    if (copy == NULL) {
+        perror("alias");
+        return -1;
+    }
+    if (alias != NULL) {
+        free(alias->value);
+        alias->value = copy;
+        return 0;
+    }
+
+    alias = malloc(sizeof(Alias));
+    if (alias == NULL || (alias->name = strdup(name)) == NULL) {
+        perror("alias");
+        free(alias);
+        free(copy);
+        return -1;
+    }
+    alias->value = copy;
+    alias->next = NULL;
+    *link = alias;
+    alias_count++;
+    return 0;
+}
+
+/**
+ * alias_remove - 删除别名
+ *
+ * 参数：name - 别名
+ * 返回：0 表示成功，-1 表示别名不存在
+ */
+static int alias_remove(const char *name) {
+    Alias **link;
+    Alias *alias = alias_find(name, &link);
+
+    if (alias == NULL) {
+        return -1;
+    }
+    *link = alias->next;
+    free(alias->name);
+    free(alias->value);
+    free(alias);
+    alias_count--;
+    return 0;
+}
+
+/* ========== 内部命令 ========== */
+
+/**
+ * alias_print - 以可重新输入的形式输出一个别名
+ *
+ * 功能：替换文本加单引号，其中的单引号写作 '\''
+ */
+static void alias_print(const Alias *alias) {
+    const char *s;
+
+    printf("alias %s='", alias->name);
+    for (s = alias->value; *s != '\0'; s++) {
+        if (*s == '\'') {
+            printf("'\\''");
+        } else {
+            putchar(*s);
+        }
+    }
+    printf("'\n");
+}
+
+/**
+ * compare_alias - 按名字排序别名
+ */
+static int compare_alias(const void *a, const void *b) {
+    return strcmp((*(const Alias **)a)->name, (*(const Alias **)b)->name);
+}
+
+/**
+ * cmd_alias - 定义或显示别名
+ *
+ * 功能：alias 按名字顺序列出所有别名；alias 名字=值 定义别名；
+ *       alias 名字 显示该别名
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示有别名不存在或不合法
+ */
+int cmd_alias(Command *cmd) {
+    Alias **list;
+    Alias *alias;
+    char *eq;
+    int result = 0;
+    int n = 0;
+    int i;
+
+    if (cmd->argc == 1) {
+        list = malloc((alias_count + 1) * sizeof(Alias *));
+        if (list == NULL) {
+            perror("alias");
+            return -1;
+        }
+        for (i = 0; i < ALIAS_BUCKETS; i++) {
+            for (alias = alias_table[i]; alias != NULL; alias = alias->next) {
+                list[n++] = alias;
+            }
+        }
+        qsort(list, n, sizeof(Alias *), compare_alias);
+        for (i = 0; i < n; i++) {
+            alias_print(list[i]);
+        }
+        free(list);
+        return 0;
+    }
+
+    for (i = 1; i < cmd->argc; i++) {
+        eq = strchr(cmd->args[i], '=');
+        if (eq == NULL) {
+            alias = alias_count ? alias_find(cmd->args[i], NULL) : NULL;
+            if (alias == NULL) {
+                fprintf(stderr, "alias: %s: 未找到\n", cmd->args[i]);
+                result = -1;
+            } else {
+                alias_print(alias);
+            }
+            continue;
+        }
+
+        *eq = '\0';
+        if (!alias_valid_name(cmd->args[i])) {
+            fprintf(stderr, "alias: '%s': 不是合法的别名\n", cmd->args[i]);
+            result = -1;
+        } else if (alias_set(cmd->args[i], eq + 1) < 0) {
+            result = -1;
+        }
+        *eq = '=';
+    }
+    return result;
+}
+
+/**
+ * cmd_unalias - 删除别名
+ *
+ * 功能：unalias 名字... 删除指定别名，unalias -a 删除所有别名
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示有别名不存在
+ */
+int cmd_unalias(Command *cmd) {
+    Alias *alias;
+    int result = 0;
+    int i;
+
+    if (cmd->argc == 1) {
+        fprintf(stderr, "用法: unalias [-a] 名字...\n");
+        return -1;
+    }
+
+    if (strcmp(cmd->args[1], "-a") == 0) {
+        for (i = 0; i < ALIAS_BUCKETS; i++) {
+            while ((alias = alias_table[i]) != NULL) {
+                alias_remove(alias->name);
+            }
+        }
+        return 0;
+    }
+
+    for (i = 1; i < cmd->argc; i++) {
+        if (alias_remove(cmd->args[i]) < 0) {
+            fprintf(stderr, "unalias: %s: 未找到\n", cmd->args[i]);
+            result = -1;
+        }
+    }
+    return result;
+}
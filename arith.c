@@ -0,0 +1,489 @@
+/*
+ * arith.c - MyShell 算术求值
+ *
+ * 功能：在 shell 进程内计算 $(( 表达式 )) 和 let 命令的 64 位整数表达式，
+ *       不需要为 expr 创建进程。采用优先级爬升法分析二元运算符，
+ *       支持变量、赋值运算符、自增自减、逻辑短路和条件运算符
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <ctype.h>
+
+/**
+ * Arith 结构体 - 表达式求值状态
+ *
+ * 字段说明：
+ *   s      - 当前扫描位置
+ *   skip   - 大于 0 时处于短路未求值的分支中，不执行赋值、不报除零错误
+ *   error  - 遇到错误
+ */
+typedef struct {
+    const char *s;
+    int skip;
+    int error;
+} Arith;
+
+/**
+ * Operator 结构体 - 二元运算符
+ *
+ * 字段说明：
+ *   text  - 运算符文本
+ *   prec  - 优先级，数值越大结合越紧
+ */
+typedef struct {
+    const char *text;
+    int prec;
+} Operator;
+
+/* 二元运算符表：较长的运算符排在前面，保证最长匹配 */
+static const Operator operators[] = {
+    { "**", 11 },
+    { "||", 1 }, { "&&", 2 },
+    { "==", 6 }, { "!=", 6 }, { "<=", 7 }, { ">=", 7 },
+    { "<<", 8 }, { ">>", 8 },
+    { "|", 3 },  { "^", 4 },  { "&", 5 },
+    { "<", 7 },  { ">", 7 },
+    { "+", 9 },  { "-", 9 },
+    { "*", 10 }, { "/", 10 }, { "%", 10 },
+    { NULL, 0 }
+};
+
+static long long parse_comma(Arith *a);
+static long long parse_assign(Arith *a);
+
+/* ========== 词法辅助 ========== */
+
+/**
+ * skip_space - 跳过空白
+ */
+static void skip_space(Arith *a) {
+    while (isspace((unsigned char)*a->s)) {
+        a->s++;
+    }
+}
+
+/**
+ * arith_error - 报告错误（只报告第一个）
+ *
+ * 参数：a - 求值状态，message - 错误信息
+ */
+static void arith_error(Arith *a, const char *message) {
+    if (!a->error) {
+        fprintf(stderr, "arith: %s\n", message);
+        a->error = 1;
+    }
+}
+
+/**
+ * accept - 若当前位置是指定文本则跳过它
+ *
+ * 返回：1 表示匹配并跳过，0 表示不匹配
+ */
+static int accept(Arith *a, const char *text) {
+    size_t len = strlen(text);
+
+    skip_space(a);
+    if (strncmp(a->s, text, len) == 0) {
+        a->s += len;
+        return 1;
+    }
+    return 0;
+}
+
+/* ========== 变量 ========== */
+
+/**
+ * read_name - 读取变量名
+ *
+ * 参数：a - 求值状态，name - 输出缓冲区，size - 缓冲区大小
+ * 返回：1 表示读到变量名，0 表示当前位置不是变量名
+ */
+static int read_name(Arith *a, char *name, size_t size) {
+    size_t len = 0;
+
+    skip_space(a);
+    if (!(isalpha((unsigned char)*a->s) || *a->s == '_')) {
+        return 0;
+    }
+    while (isalnum((unsigned char)a->s[len]) || a->s[len] == '_') {
+        len++;
+    }
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(name, a->s, len);
+    name[len] = '\0';
+    while (isalnum((unsigned char)*a->s) || *a->s == '_') {
+        a->s++;
+    }
+    return 1;
+}
+
+/**
+ * var_value - 读取变量的整数值
+ *
+ * 功能：未定义或为空的变量值为 0
+ * 参数：a - 求值状态，name - 变量名
+ * 返回：变量值
+ */
+static long long var_value(Arith *a, const char *name) {
+    const char *text = var_get(name);
+    char *end;
+    long long value;
+
+    if (text == NULL || *text == '\0') {
+        return 0;
+    }
+    value = strtoll(text, &end, 0);
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (*end != '\0') {
+        arith_error(a, "变量的值不是整数");
+        return 0;
+    }
+    return value;
+}
+
+/**
+ * var_store - 把整数值写入变量
+ *
+ * 功能：处于短路分支中时不写入
+ * 参数：a - 求值状态，name - 变量名，value - 值
+ * 返回：写入的值
+ */
+static long long var_store(Arith *a, const char *name, long long value) {
+    char text[32];
+
+    if (a->skip == 0 && !a->error) {
+        snprintf(text, sizeof(text), "%lld", value);
+        if (var_set(name, text) < 0) {
+            a->error = 1;
+        }
+    }
+    return value;
+}
+
+/* ========== 表达式 ========== */
+
+/**
+ * apply_binary - 计算二元运算
+ *
+ * 参数：a - 求值状态，op - 运算符，left - 左操作数，right - 右操作数
+ * 返回：运算结果
+ */
+static long long apply_binary(Arith *a, const char *op, long long left, long long right) {
+    switch (op[0]) {
+    case '+': return (long long)((unsigned long long)left + (unsigned long long)right);
+    case '-': return (long long)((unsigned long long)left - (unsigned long long)right);
+    case '*':
+        if (op[1] == '*') {
+            unsigned long long result = 1, base = (unsigned long long)left;
+            if (right < 0) {
+                if (a->skip == 0) {
+                    arith_error(a, "指数小于 0");
+                }
+                return 0;
+            }
+            for (; right > 0; right >>= 1, base *= base) {
+                if (right & 1) {
+                    result *= base;
+                }
+            }
+            return (long long)result;
+        }
+        return (long long)((unsigned long long)left * (unsigned long long)right);
+    case '/':
+    case '%':
+        if (right == 0) {
+            if (a->skip == 0) {
+                arith_error(a, "除数为 0");
+            }
+            return 0;
+        }
+        if (left == (-9223372036854775807LL - 1) && right == -1) {
+            return op[0] == '/' ? left : 0;
+        }
+        return op[0] == '/' ? left / right : left % right;
+    case '<':
+        if (op[1] == '<') {
+            return (long long)((unsigned long long)left << (right & 63));
+        }
+        return op[1] == '=' ? left <= right : left < right;
+    case '>':
+        if (op[1] == '>') {
+            return left >> (right & 63);
+        }
+        return op[1] == '=' ? left >= right : left > right;
+    case '=': return left == right;
+    case '!': return left != right;
+    case '&': return left & right;
+    case '^': return left ^ right;
+    case '|': return left | right;
+    }
+    return 0;
+}
+
+/**
+ * parse_primary - 解析数字、变量、括号和一元运算
+ *
+ * 参数：a - 求值状态
+ * 返回：值
+ */
+static long long parse_primary(Arith *a) {
+    char name[256];
+    long long value;
+    char *end;
+
+    skip_space(a);
+    if (a->error) {
+        return 0;
+    }
+
+    if (accept(a, "(")) {
+        value = parse_comma(a);
+        if (!accept(a, ")")) {
+            arith_error(a, "缺少 ')'");
+        }
+        return value;
+    }
+
+    /* 前置自增自减 */
+    if (accept(a, "++") || accept(a, "--")) {
+        int delta = a->s[-1] == '+' ? 1 : -1;
+        if (!read_name(a, name, sizeof(name))) {
+            arith_error(a, "++/-- 需要变量");
+            return 0;
+        }
+        return var_store(a, name, var_value(a, name) + delta);
+    }
+
+    if (accept(a, "+")) {
+        return parse_primary(a);
+    }
+    if (accept(a, "-")) {
+        return (long long)(0ULL - (unsigned long long)parse_primary(a));
+    }
+    if (accept(a, "!")) {
+        return !parse_primary(a);
+    }
+    if (accept(a, "~")) {
+        return ~parse_primary(a);
+    }
+
+    if (isdigit((unsigned char)*a->s)) {
+        value = (long long)strtoull(a->s, &end, 0);
+        if (isalnum((unsigned char)*end) || *end == '_') {
+            arith_error(a, "无效的数字");
+            return 0;
+        }
+        a->s = end;
+        return value;
+    }
+
+    if (read_name(a, name, sizeof(name))) {
+        value = var_value(a, name);
+
+        /* 后置自增自减 */
+        skip_space(a);
+        if (strncmp(a->s, "++", 2) == 0 || strncmp(a->s, "--", 2) == 0) {
+            var_store(a, name, value + (a->s[0] == '+' ? 1 : -1));
+            a->s += 2;
+        }
+        return value;
+    }
+
+    arith_error(a, *a->s ? "语法错误" : "表达式不完整");
+    return 0;
+}
+
+/**
+ * match_operator - 识别当前位置的二元运算符
+ *
+ * 功能：不把赋值运算符（如 +=、<<=）和单独的 = 识别为二元运算符
+ * 参数：a - 求值状态
+ * 返回：运算符表项，不是二元运算符返回 NULL
+ */
+static const Operator* match_operator(Arith *a) {
+    const Operator *op;
+    size_t len;
+
+    skip_space(a);
+    for (op = operators; op->text != NULL; op++) {
+        len = strlen(op->text);
+        if (strncmp(a->s, op->text, len) != 0) {
+            continue;
+        }
+        /* x += 1、x <<= 1 是赋值，不是二元运算 */
+        if (a->s[len] == '=' && strcmp(op->text, "==") != 0 &&
+            strcmp(op->text, "!=") != 0 && strcmp(op->text, "<=") != 0 &&
+            strcmp(op->text, ">=") != 0) {
+            return NULL;
+        }
+        return op;
+    }
+    return NULL;
+}
+
+/**
+ * parse_binary - 优先级爬升解析二元运算
+ *
+ * 功能：** 右结合，其余左结合。&& 和 || 短路：不需要求值的一侧
+ *       在 skip 状态下解析
+ * 参数：a - 求值状态，min_prec - 本层接受的最低优先级
+ * 返回：值
+ */
+static long long parse_binary(Arith *a, int min_prec) {
+    long long left = parse_primary(a);
+    long long right;
+    const Operator *op;
+    int skip_right;
+
+    while (!a->error && (op = match_operator(a)) != NULL && op->prec >= min_prec) {
+        a->s += strlen(op->text);
+
+        skip_right = (op->prec == 1 && left != 0) || (op->prec == 2 && left == 0);
+        a->skip += skip_right;
+        right = parse_binary(a, op->prec == 11 ? op->prec : op->prec + 1);
+        a->skip -= skip_right;
+
+        if (op->prec == 1) {
+            left = left != 0 || right != 0;
+        } else if (op->prec == 2) {
+            left = left != 0 && right != 0;
+        } else {
+            left = apply_binary(a, op->text, left, right);
+        }
+    }
+    return left;
+}
+
+/**
+ * parse_conditional - 解析条件运算 a ? b : c
+ *
+ * 参数：a - 求值状态
+ * 返回：值
+ */
+static long long parse_conditional(Arith *a) {
+    long long cond = parse_binary(a, 1);
+    long long yes, no;
+
+    if (!accept(a, "?")) {
+        return cond;
+    }
+
+    a->skip += cond == 0;
+    yes = parse_assign(a);
+    a->skip -= cond == 0;
+
+    if (!accept(a, ":")) {
+        arith_error(a, "缺少 ':'");
+        return 0;
+    }
+
+    a->skip += cond != 0;
+    no = parse_conditional(a);
+    a->skip -= cond != 0;
+
+    return cond ? yes : no;
+}
+
+/**
+ * parse_assign - 解析赋值 name op= 表达式（右结合）
+ *
+ * 参数：a - 求值状态
+ * 返回：值
+ */
+static long long parse_assign(Arith *a) {
+    static const char *assign_ops[] = {
+        "**=", "<<=", ">>=", "+=", "-=", "*=", "/=", "%=", "&=", "^=", "|=", "=", NULL
+    };
+    const char *start;
+    char name[256];
+    long long value;
+    int i;
+
+    skip_space(a);
+    start = a->s;
+    if (read_name(a, name, sizeof(name))) {
+        skip_space(a);
+        for (i = 0; assign_ops[i] != NULL; i++) {
+            size_t len = strlen(assign_ops[i]);
+            if (strncmp(a->s, assign_ops[i], len) == 0 && !(len == 1 && a->s[1] == '=')) {
+                a->s += len;
+                value = parse_assign(a);
+                if (len > 1) {
+                    char op[3];
+                    snprintf(op, sizeof(op), "%.*s", (int)len - 1, assign_ops[i]);
+                    value = apply_binary(a, op, var_value(a, name), value);
+                }
+                return var_store(a, name, value);
+            }
+        }
+        a->s = start;   /* 不是赋值，回退 */
+    }
+    return parse_conditional(a);
+}
+
+/**
+ * parse_comma - 解析逗号表达式，值为最后一项
+ *
+ * 参数：a - 求值状态
+ * 返回：值
+ */
+static long long parse_comma(Arith *a) {
+    long long value = parse_assign(a);
+
+    while (!a->error && accept(a, ",")) {
+        value = parse_assign(a);
+    }
+    return value;
+}
+
+/**
+ * arith_eval - 计算整数表达式
+ *
+ * 功能：空表达式的值为 0
+ * 参数：expr - 表达式文本（变量替换已完成），value - 输出参数，保存结果
+ * 返回：0 表示成功，-1 表示表达式错误
+ */
+int arith_eval(const char *expr, long long *value) {
+    Arith a;
+
+    a.s = expr;
+    a.skip = 0;
+    a.error = 0;
+
+    skip_space(&a);
+    *value = *a.s == '\0' ? 0 : parse_comma(&a);
+    skip_space(&a);
+    if (!a.error && *a.s != '\0') {
+        arith_error(&a, "语法错误");
+    }
+    return a.error ? -1 : 0;
+}
+
+/**
+ * cmd_let - 计算算术表达式
+ *
+ * 功能：let 表达式...，依次计算每个参数
+ * 参数：cmd - Command 结构体指针
+ * 返回：最后一个表达式的值非 0 时返回 0，否则返回 -1
+ */
+int cmd_let(Command *cmd) {
+    long long value = 0;
+    int i;
+
+    if (cmd->argc < 2) {
+        fprintf(stderr, "用法: let 表达式...\n");
+        return -1;
+    }
+    for (i = 1; i < cmd->argc; i++) {
+        if (arith_eval(cmd->args[i], &value) < 0) {
+            return -1;
+        }
+    }
+    return value != 0 ? 0 : -1;
+}
@@ -0,0 +1,935 @@
+/*
+ * builtins.c - MyShell 常用内部命令
+ *
+ * 功能：在 shell 进程内实现 test/[、printf、true、false、:、read、
+ *       export、unset、pwd 和 env。这些命令在脚本中使用频繁，作为内部命令
+ *       执行时不需要 fork 和 exec，输入输出重定向与外部命令相同
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <ctype.h>
+#include <sys/stat.h>
+
+/* 外部环境变量数组 */
+extern char **environ;
+
+/**
+ * TestState 结构体 - test 表达式的解析状态
+ *
+ * 字段说明：
+ *   args   - 表达式参数（不含命令名和结尾的 ]）
+ *   count  - 参数个数
+ *   pos    - 当前位置
+ *   error  - 语法错误
+ */
+typedef struct {
+    char **args;
+    int count;
+    int pos;
+    int error;
+} TestState;
+
+static int test_or(TestState *t);
+
+/* ========== true / false ========== */
+
+/**
+ * cmd_true - 什么也不做，返回成功（true 和 :）
+ *
+ * 参数：cmd - Command 结构体指针
+ * 返回：0
+ */
+int cmd_true(Command *cmd) {
+    (void)cmd;
+    return 0;
+}
+
+/**
+ * cmd_false - 什么也不做，返回失败
+ *
+ * 参数：cmd - Command 结构体指针
+ * 返回：-1
+ */
+int cmd_false(Command *cmd) {
+    (void)cmd;
+    return -1;
+}
+
+/* ========== test / [ ========== */
+
+/**
+ * test_integer - 把 test 的参数转换为整数
+ *
+ * 参数：t - 解析状态，text - 参数，value - 输出参数，保存整数值
+ * 返回：0 表示成功，-1 表示不是整数
+ */
+static int test_integer(TestState *t, const char *text, long long *value) {
+    char *end;
+
+    errno = 0;
+    *value = strtoll(text, &end, 10);
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    if (end == text || *end != '\0' || errno != 0) {
+        fprintf(stderr, "test: %s: 需要整数表达式\n", text);
+        t->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * test_is_binary - 判断是否为二元运算符
+ */
+static int test_is_binary(const char *op) {
+    static const char *ops[] = {
+        "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt", "-ge",
+        "-nt", "-ot", "-ef", NULL
+    };
+    int i;
+
+    for (i = 0; ops[i] != NULL; i++) {
+        if (strcmp(op, ops[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * test_is_unary - 判断是否为一元运算符
+ */
+static int test_is_unary(const char *op) {
+    return op[0] == '-' && op[1] != '\0' && op[2] == '\0' &&
+           strchr("bcdefghkLnOGprsStuwxz", op[1]) != NULL;
+}
+
+/**
+ * test_binary - 计算二元测试
+ *
+ * 参数：t - 解析状态，left - 左操作数，op - 运算符，right - 右操作数
+ * 返回：1 表示真，0 表示假
+ */
+static int test_binary(TestState *t, const char *left, const char *op, const char *right) {
+    struct stat sl, sr;
+    long long a, b;
+    int have_l, have_r;
+
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) {
+        return strcmp(left, right) == 0;
+    }
+    if (strcmp(op, "!=") == 0) {
+        return strcmp(left, right) != 0;
+    }
+    if (strcmp(op, "<") == 0) {
+        return strcmp(left, right) < 0;
+    }
+    if (strcmp(op, ">") == 0) {
+        return strcmp(left, right) > 0;
+    }
+
+    if (strcmp(op, "-nt") == 0 || strcmp(op, "-ot") == 0 || strcmp(op, "-ef") == 0) {
+        have_l = stat(left, &sl) == 0;
+        have_r = stat(right, &sr) == 0;
+        if (op[1] == 'e') {
+            return have_l && have_r && sl.st_dev == sr.st_dev && sl.st_ino == sr.st_ino;
+        }
+        if (!have_l || !have_r) {
+            /* 不存在的文件比任何存在的文件都旧 */
+            return op[1] == 'n' ? have_l : have_r;
+        }
+        if (sl.st_mtim.tv_sec != sr.st_mtim.tv_sec) {
+            return op[1] == 'n' ? sl.st_mtim.tv_sec > sr.st_mtim.tv_sec
+                                : sl.st_mtim.tv_sec < sr.st_mtim.tv_sec;
+        }
+        return op[1] == 'n' ? sl.st_mtim.tv_nsec > sr.st_mtim.tv_nsec
+                            : sl.st_mtim.tv_nsec < sr.st_mtim.tv_nsec;
+    }
+
+    if (test_integer(t, left, &a) < 0 || test_integer(t, right, &b) < 0) {
+        return 0;
+    }
+    if (strcmp(op, "-eq") == 0) return a == b;
+    if (strcmp(op, "-ne") == 0) return a != b;
+    if (strcmp(op, "-lt") == 0) return a < b;
+    if (strcmp(op, "-le") == 0) return a <= b;
+    if (strcmp(op, "-gt") == 0) return a > b;
+    return a >= b;
+}
+
+/**
+ * test_unary - 计算一元测试
+ *
+ * 参数：t - 解析状态，op - 运算符，arg - 操作数
+ * 返回：1 表示真，0 表示假
+ */
+static int test_unary(TestState *t, const char *op, const char *arg) {
+    struct stat st;
+    long long fd;
+
+    switch (op[1]) {
+    case 'n': return arg[0] != '\0';
+    case 'z': return arg[0] == '\0';
+    case 't':
+        if (test_integer(t, arg, &fd) < 0) {
+            return 0;
+        }
+        return isatty((int)fd);
+    case 'r': return access(arg, R_OK) == 0;
+    case 'w': return access(arg, W_OK) == 0;
+    case 'x': return access(arg, X_OK) == 0;
+    case 'h':
+    case 'L': return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+    }
+
+    if (stat(arg, &st) < 0) {
+        return 0;
+    }
+    switch (op[1]) {
+    case 'e': return 1;
+    case 'f': return S_ISREG(st.st_mode);
+    case 'd': return S_ISDIR(st.st_mode);
+    case 'b': return S_ISBLK(st.st_mode);
+    case 'c': return S_ISCHR(st.st_mode);
+    case 'p': return S_ISFIFO(st.st_mode);
+    case 'S': return S_ISSOCK(st.st_mode);
+    case 's': return st.st_size > 0;
+    case 'g': return (st.st_mode & S_ISGID) != 0;
+    case 'u': return (st.st_mode & S_ISUID) != 0;
+    case 'k': return (st.st_mode & S_ISVTX) != 0;
+    case 'O': return st.st_uid == geteuid();
+    case 'G': return st.st_gid == getegid();
+    }
+    return 0;
+}
+
+/**
+ * test_primary - 解析基本测试：( 表达式 )、一元测试、二元测试或字符串
+ *
+ * 功能：二元运算符优先于一元运算符识别，因此 [ -n = -n ] 是字符串比较
+ */
+static int test_primary(TestState *t) {
+    int remaining = t->count - t->pos;
+    char **a = t->args + t->pos;
+    int result;
+
+    if (remaining <= 0) {
+        fprintf(stderr, "test: 缺少参数\n");
+        t->error = 1;
+        return 0;
+    }
+
+    if (remaining >= 3 && test_is_binary(a[1])) {
+        t->pos += 3;
+        return test_binary(t, a[0], a[1], a[2]);
+    }
+    if (remaining >= 2 && test_is_unary(a[0])) {
+        t->pos += 2;
+        return test_unary(t, a[0], a[1]);
+    }
+    if (remaining >= 2 && strcmp(a[0], "(") == 0) {
+        t->pos++;
+        result = test_or(t);
+        if (t->pos >= t->count || strcmp(t->args[t->pos], ")") != 0) {
+            fprintf(stderr, "test: 缺少 ')'\n");
+            t->error = 1;
+            return 0;
+        }
+        t->pos++;
+        return result;
+    }
+
+    /* 单个字符串：非空为真 */
+    t->pos++;
+    return a[0][0] != '\0';
+}
+
+/**
+ * test_not - 解析 ! 表达式
+ */
+static int test_not(TestState *t) {
+    if (t->count - t->pos >= 2 && strcmp(t->args[t->pos], "!") == 0) {
+        t->pos++;
+        return !test_not(t);
+    }
+    return test_primary(t);
+}
+
+/**
+ * test_and - 解析 表达式 -a 表达式
+ */
+static int test_and(TestState *t) {
+    int result = test_not(t);
+
+    while (!t->error && t->pos < t->count && strcmp(t->args[t->pos], "-a") == 0) {
+        t->pos++;
+        result = test_not(t) && result;
+    }
+    return result;
+}
+
+/**
+ * test_or - 解析 表达式 -o 表达式
+ */
+static int test_or(TestState *t) {
+    int result = test_and(t);
+
+    while (!t->error && t->pos < t->count && strcmp(t->args[t->pos], "-o") == 0) {
+        t->pos++;
+        result = test_and(t) || result;
+    }
+    return result;
+}
+
+/**
+ * cmd_test - 条件测试（test 和 [）
+ *
+ * 功能：支持文件测试（-e -f -d -r -w -x -s -L 等）、字符串比较
+ *       （= != < > -n -z）、整数比较（-eq -ne -lt -le -gt -ge）、
+ *       文件比较（-nt -ot -ef），以及 ! -a -o 和括号
+ * 参数：cmd - Command 结构体指针
+ * 返回：条件为真返回 0，为假返回 -1（退出状态 1）；
+ *       表达式错误返回 -1，退出状态为 2，与条件为假区分
+ */
+int cmd_test(Command *cmd) {
+    TestState t;
+    int result;
+
+    t.args = cmd->args + 1;
+    t.count = cmd->argc - 1;
+    t.pos = 0;
+    t.error = 0;
+
+    if (strcmp(cmd->args[0], "[") == 0) {
+        if (t.count == 0 || strcmp(t.args[t.count - 1], "]") != 0) {
+            fprintf(stderr, "[: 缺少 ']'\n");
+            status_set(2);
+            return -1;
+        }
+        t.count--;
+    }
+
+    /* 没有参数为假 */
+    if (t.count == 0) {
+        return -1;
+    }
+
+    result = test_or(&t);
+    if (!t.error && t.pos < t.count) {
+        fprintf(stderr, "test: %s: 多余的参数\n", t.args[t.pos]);
+        t.error = 1;
+    }
+    if (t.error) {
+        status_set(2);
+        return -1;
+    }
+    return result ? 0 : -1;
+}
+
+/* ========== printf ========== */
+
+/**
+ * printf_escape - 解析一个反斜杠转义序列
+ *
+ * 功能：支持 \\ \a \b \f \n \r \t \v \" \' \NNN（八进制）\xHH（十六进制），
+ *       in_arg 为 1（%b 的参数）时八进制写作 \0NNN，并支持 \c
+ * 参数：s - 指向反斜杠后的字符，out - 输出参数，保存字符，
+ *       in_arg - 是否为 %b 参数，stop - 输出参数，遇到 \c 时置 1
+ * 返回：转义序列之后的位置
+ */
+static const char* printf_escape(const char *s, char *out, int in_arg, int *stop) {
+    int value = 0;
+    int digits = 0;
+
+    switch (*s) {
+    case '\\': *out = '\\'; return s + 1;
+    case 'a':  *out = '\a'; return s + 1;
+    case 'b':  *out = '\b'; return s + 1;
+    case 'f':  *out = '\f'; return s + 1;
+    case 'n':  *out = '\n'; return s + 1;
+    case 'r':  *out = '\r'; return s + 1;
+    case 't':  *out = '\t'; return s + 1;
+    case 'v':  *out = '\v'; return s + 1;
+    case '"':  *out = '"';  return s + 1;
+    case '\'': *out = '\''; return s + 1;
+    case 'c':
+        if (in_arg) {
+            *stop = 1;
+            *out = '\0';
+            return s + 1;
+        }
+        break;
+    case 'x':
+        for (s++; digits < 2 && isxdigit((unsigned char)*s); s++, digits++) {
+            value = value * 16 + (isdigit((unsigned char)*s) ? *s - '0' : (tolower((unsigned char)*s) - 'a' + 10));
+        }
+        if (digits > 0) {
+            *out = (char)value;
+            return s;
+        }
+        *out = '\\';
+        return s - 1;
+    }
+
+    if (*s >= '0' && *s <= '7') {
+        if (in_arg && *s == '0') {
+            s++;
+        }
+        for (; digits < 3 && *s >= '0' && *s <= '7'; s++, digits++) {
+            value = value * 8 + (*s - '0');
+        }
+        *out = (char)value;
+        return s;
+    }
+
+    /* 不认识的转义保留反斜杠 */
+    *out = '\\';
+    return s;
+}
+
+/**
+ * printf_number - 转换 printf 的数值参数
+ *
+ * 功能：'c 或 "c 形式取字符的编码
+ * 参数：text - 参数，value - 输出参数，保存数值
+ * 返回：0 表示成功，-1 表示不是有效的数字（value 为已转换的部分）
+ */
+static int printf_number(const char *text, long long *value) {
+    char *end;
+
+    if (text[0] == '\'' || text[0] == '"') {
+        *value = (unsigned char)text[1];
+        return 0;
+    }
+    errno = 0;
+    *value = strtoll(text, &end, 0);
+    if (*text != '\0' && (*end != '\0' || errno != 0)) {
+        fprintf(stderr, "printf: %s: 无效的数字\n", text);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * printf_string_b - 输出 %b 参数：先解释其中的转义序列
+ *
+ * 参数：spec - 转换说明（以 s 结尾），arg - 参数，stop - 输出参数，遇到 \c 时置 1
+ */
+static void printf_string_b(const char *spec, const char *arg, int *stop) {
+    char *text = malloc(strlen(arg) + 1);
+    int len = 0;
+    char c;
+
+    if (text == NULL) {
+        perror("printf");
+        return;
+    }
+    while (*arg != '\0' && !*stop) {
+        if (*arg == '\\' && arg[1] != '\0') {
+            arg = printf_escape(arg + 1, &c, 1, stop);
+            if (!*stop) {
+                text[len++] = c;
+            }
+        } else {
+            text[len++] = *arg++;
+        }
+    }
+    text[len] = '\0';
+    printf(spec, text);
+    free(text);
+}
+
+/**
+ * cmd_printf - 格式化输出
+ *
+ * 功能：printf 格式 [参数...]。支持 %s %b %c %d %i %o %u %x %X
+ *       %e %E %f %F %g %G %%，以及标志、宽度（可为 *）和精度。
+ *       参数多于格式中的转换时重复使用格式，不足时按空串或 0 处理
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数或格式错误
+ */
+int cmd_printf(Command *cmd) {
+    const char *format;
+    const char *p;
+    const char *arg;
+    char spec[64];
+    char flags[8];
+    char conv;
+    long long number;
+    int width, precision;
+    int next = 2;
+    int start;
+    int result = 0;
+    int stop = 0;
+    int len;
+    char c;
+
+    if (cmd->argc < 2) {
+        fprintf(stderr, "用法: printf 格式 [参数...]\n");
+        return -1;
+    }
+    format = cmd->args[1];
+
+    do {
+        start = next;
+        for (p = format; *p != '\0' && !stop; ) {
+            if (*p == '\\' && p[1] != '\0') {
+                p = printf_escape(p + 1, &c, 0, &stop);
+                putchar(c);
+                continue;
+            }
+            if (*p != '%') {
+                putchar(*p++);
+                continue;
+            }
+            if (p[1] == '%') {
+                putchar('%');
+                p += 2;
+                continue;
+            }
+
+            /* 解析 %[标志][宽度][.精度]转换字符 */
+            p++;
+            for (len = 0; *p != '\0' && strchr("-+ #0", *p) != NULL; p++) {
+                if (len < (int)sizeof(flags) - 1) {
+                    flags[len++] = *p;
+                }
+            }
+            flags[len] = '\0';
+
+            width = -1;
+            if (*p == '*') {
+                if (printf_number(next < cmd->argc ? cmd->args[next++] : "0", &number) < 0) {
+                    result = -1;
+                }
+                width = (int)number;
+                p++;
+            } else if (isdigit((unsigned char)*p)) {
+                width = (int)strtol(p, (char **)&p, 10);
+            }
+
+            precision = -1;
+            if (*p == '.') {
+                p++;
+                if (*p == '*') {
+                    if (printf_number(next < cmd->argc ? cmd->args[next++] : "0", &number) < 0) {
+                        result = -1;
+                    }
+                    precision = number < 0 ? -1 : (int)number;
+                    p++;
+                } else {
+                    precision = (int)strtol(p, (char **)&p, 10);
+                }
+            }
+
+            conv = *p;
+            if (conv == '\0' || strchr("sbcdiouxXeEfFgG", conv) == NULL) {
+                fprintf(stderr, "printf: '%c': 无效的格式字符\n", conv ? conv : '%');
+                return -1;
+            }
+            p++;
+
+            len = snprintf(spec, sizeof(spec), "%%%s", flags);
+            if (width >= 0 || width < -1) {
+                len += snprintf(spec + len, sizeof(spec) - len, "%d", width);
+            }
+            if (precision >= 0) {
+                len += snprintf(spec + len, sizeof(spec) - len, ".%d", precision);
+            }
+            arg = next < cmd->argc ? cmd->args[next++] : NULL;
+
+            switch (conv) {
+            case 's':
+            case 'b':
+                snprintf(spec + len, sizeof(spec) - len, "s");
+                if (conv == 'b') {
+                    printf_string_b(spec, arg ? arg : "", &stop);
+                } else {
+                    printf(spec, arg ? arg : "");
+                }
+                break;
+            case 'c':
+                snprintf(spec + len, sizeof(spec) - len, "c");
+                printf(spec, arg ? arg[0] : '\0');
+                break;
+            case 'd':
+            case 'i':
+                snprintf(spec + len, sizeof(spec) - len, "lld");
+                if (printf_number(arg ? arg : "0", &number) < 0) {
+                    result = -1;
+                }
+                printf(spec, number);
+                break;
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                snprintf(spec + len, sizeof(spec) - len, "ll%c", conv);
+                if (printf_number(arg ? arg : "0", &number) < 0) {
+                    result = -1;
+                }
+                printf(spec, (unsigned long long)number);
+                break;
+            default:
+                snprintf(spec + len, sizeof(spec) - len, "%c", conv);
+                printf(spec, arg ? strtod(arg, NULL) : 0.0);
+                break;
+            }
+        }
+    } while (!stop && next > start && next < cmd->argc);
+
+    return result;
+}
+
+/* ========== read ========== */
+
+/**
+ * read_is_ifs - 判断字符是否为字段分隔符
+ *
+ * 参数：c - 字符，ifs - 分隔符集合，literal - 该字符是否经反斜杠转义
+ */
+static int read_is_ifs(char c, const char *ifs, int literal) {
+    return !literal && c != '\0' && strchr(ifs, c) != NULL;
+}
+
+/**
+ * cmd_read - 从标准输入读取一行并赋给变量
+ *
+ * 功能：read [-r] [-p 提示] [变量...]。按 IFS（默认空白）分割，
+ *       最后一个变量得到剩余部分，没有变量名时存入 REPLY。
+ *       不加 -r 时反斜杠转义下一个字符，行尾的反斜杠表示续行。
+ *       逐字节读取标准输入，不会多读属于后续命令的数据
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示遇到文件结束或参数错误
+ */
+int cmd_read(Command *cmd) {
+    const char *prompt = NULL;
+    const char *ifs;
+    char *line = NULL;
+    char *literal = NULL;
+    char *grown, *grown_literal;
+    char *default_name[] = { "REPLY" };
+    char **names;
+    int name_count;
+    int raw = 0;
+    int len = 0, size = 0;
+    int result = 0;
+    int escaped = 0;
+    int i, pos, end, last;
+    char c;
+    ssize_t n;
+
+    for (i = 1; i < cmd->argc && cmd->args[i][0] == '-' && cmd->args[i][1] != '\0'; i++) {
+        if (strcmp(cmd->args[i], "-r") == 0) {
+            raw = 1;
+        } else if (strcmp(cmd->args[i], "-p") == 0 && i + 1 < cmd->argc) {
+            prompt = cmd->args[++i];
+        } else if (strcmp(cmd->args[i], "--") == 0) {
+            i++;
+            break;
+        } else {
+            fprintf(stderr, "用法: read [-r] [-p 提示] [变量...]\n");
+            return -1;
+        }
+    }
+    names = i < cmd->argc ? cmd->args + i : default_name;
+    name_count = i < cmd->argc ? cmd->argc - i : 1;
+    for (i = 0; i < name_count; i++) {
+        if (!var_valid_name(names[i], -1)) {
+            fprintf(stderr, "read: '%s': 不是合法的变量名\n", names[i]);
+            return -1;
+        }
+    }
+
+    if (prompt != NULL && isatty(STDIN_FILENO)) {
+        fprintf(stderr, "%s", prompt);
+    }
+
+    /* 逐字节读取一行，literal[k] 记录第 k 个字符是否经反斜杠转义 */
+    for (;;) {
+        n = read(STDIN_FILENO, &c, 1);
+        if (n < 0 && errno == EINTR && !job_interrupted()) {
+            continue;
+        }
+        if (n <= 0) {
+            result = -1;
+            break;
+        }
+        if (escaped) {
+            escaped = 0;
+            if (c == '\n') {
+                continue;   /* 续行 */
+            }
+            escaped = 2;
+        } else if (c == '\\' && !raw) {
+            escaped = 1;
+            continue;
+        } else if (c == '\n') {
+            break;
+        }
+
+        if (len + 2 > size) {
+            size = size ? size * 2 : 128;
+            grown = realloc(line, size);
+            if (grown != NULL) {
+                line = grown;
+            }
+            grown_literal = realloc(literal, size);
+            if (grown_literal != NULL) {
+                literal = grown_literal;
+            }
+            if (grown == NULL || grown_literal == NULL) {
+                perror("read");
+                free(line);
+                free(literal);
+                return -1;
+            }
+        }
+        literal[len] = escaped == 2;
+        line[len++] = c;
+        escaped = 0;
+    }
+
+    /* 读到文件结束时仍然为变量赋值（可能为空），但返回失败 */
+    ifs = var_get("IFS");
+    if (ifs == NULL) {
+        ifs = " \t\n";
+    }
+
+    pos = 0;
+    for (i = 0; i < name_count; i++) {
+        char *value;
+
+        /* 跳过前导空白分隔符 */
+        while (pos < len && isspace((unsigned char)line[pos]) && read_is_ifs(line[pos], ifs, literal[pos])) {
+            pos++;
+        }
+
+        if (i == name_count - 1) {
+            /* 最后一个变量：剩余部分去掉结尾的空白分隔符 */
+            end = len;
+            while (end > pos && isspace((unsigned char)line[end - 1]) &&
+                   read_is_ifs(line[end - 1], ifs, literal[end - 1])) {
+                end--;
+            }
+            last = end;
+        } else {
+            for (end = pos; end < len && !read_is_ifs(line[end], ifs, literal[end]); end++) {
+            }
+            last = end;
+            /* 跳过字段后的分隔符：空白，加上至多一个非空白分隔符 */
+            while (last < len && isspace((unsigned char)line[last]) && read_is_ifs(line[last], ifs, literal[last])) {
+                last++;
+            }
+            if (last < len && !isspace((unsigned char)line[last]) && read_is_ifs(line[last], ifs, literal[last])) {
+                last++;
+            }
+        }
+
+        value = strndup(len > 0 ? line + pos : "", end - pos);
+        if (value == NULL || var_set(names[i], value) < 0) {
+            result = -1;
+        }
+        free(value);
+        pos = last;
+    }
+
+    free(line);
+    free(literal);
+    return result;
+}
+
+/* ========== export / unset / pwd ========== */
+
+/**
+ * cmd_export - 把变量放入环境
+ *
+ * 功能：export 名字[=值]...，使子进程能看到该变量。
+ *       没有参数或使用 -p 时列出所有环境变量
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示有变量名不合法
+ */
+int cmd_export(Command *cmd) {
+    const char *eq;
+    char *name;
+    int result = 0;
+    int i;
+
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->args[1], "-p") == 0)) {
+        for (i = 0; environ[i] != NULL; i++) {
+            eq = strchr(environ[i], '=');
+            if (eq != NULL) {
+                printf("export %.*s='%s'\n", (int)(eq - environ[i]), environ[i], eq + 1);
+            }
+        }
+        return 0;
+    }
+
+    for (i = 1; i < cmd->argc; i++) {
+        eq = strchr(cmd->args[i], '=');
+        name = eq ? strndup(cmd->args[i], eq - cmd->args[i]) : strdup(cmd->args[i]);
+        if (name == NULL) {
+            perror("export");
+            return -1;
+        }
+        if (var_export(name, eq ? eq + 1 : NULL) < 0) {
+            result = -1;
+        }
+        free(name);
+    }
+    return result;
+}
+
+/**
+ * cmd_unset - 删除变量或函数
+ *
+ * 功能：unset [-v] 名字... 删除变量，unset -f 名字... 删除函数
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示有名字不合法
+ */
+int cmd_unset(Command *cmd) {
+    int functions = 0;
+    int result = 0;
+    int i = 1;
+
+    if (i < cmd->argc && strcmp(cmd->args[i], "-f") == 0) {
+        functions = 1;
+        i++;
+    } else if (i < cmd->argc && strcmp(cmd->args[i], "-v") == 0) {
+        i++;
+    }
+
+    for (; i < cmd->argc; i++) {
+        if (functions) {
+            function_unset(cmd->args[i]);
+        } else if (var_valid_name(cmd->args[i], -1)) {
+            var_unset(cmd->args[i]);
+        } else {
+            fprintf(stderr, "unset: '%s': 不是合法的变量名\n", cmd->args[i]);
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/**
+ * cmd_pwd - 显示当前工作目录
+ *
+ * 功能：pwd [-L|-P]。默认（-L）在 PWD 仍指向当前目录时显示 PWD，
+ *       保留经过的符号链接；-P 显示解析符号链接后的物理路径
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_pwd(Command *cmd) {
+    char path[MAX_PATH];
+    const char *pwd = getenv("PWD");
+    struct stat logical, physical;
+    int use_physical = 0;
+    int i;
+
+    for (i = 1; i < cmd->argc; i++) {
+        if (strcmp(cmd->args[i], "-P") == 0) {
+            use_physical = 1;
+        } else if (strcmp(cmd->args[i], "-L") == 0) {
+            use_physical = 0;
+        } else {
+            fprintf(stderr, "用法: pwd [-L|-P]\n");
+            return -1;
+        }
+    }
+
+    if (!use_physical && pwd != NULL && pwd[0] == '/' &&
+        stat(pwd, &logical) == 0 && stat(".", &physical) == 0 &&
+        logical.st_dev == physical.st_dev && logical.st_ino == physical.st_ino) {
+        printf("%s\n", pwd);
+        return 0;
+    }
+
+    if (getcwd(path, sizeof(path)) == NULL) {
+        perror("pwd");
+        return -1;
+    }
+    printf("%s\n", path);
+    return 0;
+}
+
+/* ========== env ========== */
+
+/**
+ * env_print - 显示修改后的环境
+ *
+ * 功能：重定向已由 run_builtin_redirected 应用，这里只逐行输出
+ * 参数：run - 含修改的 Command
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int env_print(Command *run) {
+    char **envp;
+    int i;
+
+    envp = env_build(run);
+    if (envp == NULL) {
+        return -1;
+    }
+    for (i = 0; envp[i] != NULL; i++) {
+        printf("%s\n", envp[i]);
+    }
+    free(envp);
+    return 0;
+}
+
+/**
+ * cmd_env - 在修改后的环境中执行命令
+ *
+ * 功能：env [-i] [-u 名字]... [名字=值]... [命令 [参数...]]
+ *       -i 从空环境开始，-u 删除变量，名字=值 设置变量。修改只放入
+ *       子进程的环境（与 VAR=val 前缀相同），shell 自己的环境不变；
+ *       没有命令时显示修改后的环境
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_env(Command *cmd) {
+    Command run = *cmd;
+    int i = 1;
+    int j;
+
+    for (; i < cmd->argc; i++) {
+        if (run.env_count == MAX_ARGS) {
+            fprintf(stderr, "env: 变量过多（最多 %d 个）\n", MAX_ARGS);
+            return -1;
+        }
+        if (strcmp(cmd->args[i], "-i") == 0 || strcmp(cmd->args[i], "-") == 0) {
+            /* 之前的 VAR=val 前缀也一并丢弃 */
+            run.env_clear = 1;
+            run.env_count = 0;
+        } else if (strcmp(cmd->args[i], "-u") == 0 && i + 1 < cmd->argc) {
+            run.env[run.env_count++] = cmd->args[++i];
+        } else if (strcmp(cmd->args[i], "--") == 0) {
+            i++;
+            break;
+        } else if (cmd->args[i][0] == '-') {
+            fprintf(stderr, "用法: env [-i] [-u 名字]... [名字=值]... [命令 [参数...]]\n");
+            return -1;
+        } else if (strchr(cmd->args[i], '=') != NULL && cmd->args[i][0] != '=') {
+            run.env[run.env_count++] = cmd->args[i];
+        } else {
+            break;
+        }
+    }
+
+    if (i == cmd->argc) {
+        return env_print(&run);
+    }
+
+    /* 参数指向 cmd 中的字符串，run 不需要释放；
+     * 重定向已在 shell 进程中应用，子进程直接继承 */
+    run.input_file = NULL;
+    run.output_file = NULL;
+    for (j = i; j <= cmd->argc; j++) {
+        run.args[j - i] = cmd->args[j];
+    }
+    run.argc = cmd->argc - i;
+    return execute_external(&run);
+}
@@ -0,0 +1,817 @@
+/*
+ * cache.c - MyShell 命令结果缓存
+ *
+ * 功能：cache 前缀执行外部程序时，用命令行、当前目录、相关环境变量和
+ *       输入文件的内容计算键；键已在缓存中时直接恢复保存的标准输出和
+ *       退出状态，不再执行程序。适用于批处理中结果只取决于参数和输入的命令。
+ *       缓存目录按内容寻址：objects/ 中的输出以内容的 SHA-256 命名，相同的
+ *       输出只保存一份；keys/ 中的文件把键映射到退出状态和输出。键和输出
+ *       都用 SHA-256 计算，查找时不会因为哈希碰撞取到其他命令的结果。
+ *       总大小超过上限时淘汰最久没有使用的输出
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <stdint.h>
+
+/* 默认缓存目录（相对于 HOME）和大小上限 */
+#define CACHE_DIR           ".cache/myshell"
+#define CACHE_DEFAULT_MAX   (256LL * 1024 * 1024)
+
+/* 计算文件哈希时每次读取的字节数 */
+#define CACHE_READ_SIZE     (64 * 1024)
+
+/* SHA-256 摘要的十六进制文本长度（含结尾的 '\0'） */
+#define DIGEST_HEX          65
+
+/* 总是参与计算键的环境变量，其他变量用 -e 声明 */
+static const char *cache_env[] = { "PATH", "LANG", "LC_ALL", NULL };
+
+/* 缓存目录，第一次使用时确定；留出子目录和文件名的长度 */
+static char cache_dir[MAX_PATH - 96];
+
+/* 大小上限（字节） */
+static long long cache_max = CACHE_DEFAULT_MAX;
+
+/* objects/ 的总大小：第一次需要时扫描一次，之后随保存和淘汰增减，
+ * -1 表示还没有扫描 */
+static long long cache_total = -1;
+
+/* 本次运行的统计 */
+static long cache_hits = 0;
+static long cache_misses = 0;
+static long cache_stores = 0;
+static long cache_evictions = 0;
+
+/**
+ * CacheObject 结构体 - 淘汰时的一个输出文件
+ *
+ * 字段说明：
+ *   name   - 文件名（内容的 SHA-256）
+ *   size   - 大小
+ *   mtime  - 最后一次使用的时间（命中时更新）
+ */
+typedef struct {
+    char name[DIGEST_HEX];
+    long long size;
+    time_t mtime;
+} CacheObject;
+
+/* ========== 哈希 ========== */
+
+/**
+ * Digest 结构体 - SHA-256 的计算状态
+ *
+ * 字段说明：
+ *   state   - 中间结果
+ *   length  - 已加入的字节数
+ *   block   - 未满 64 字节的数据块
+ *   used    - block 中的字节数
+ */
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    unsigned char block[64];
+    size_t used;
+} Digest;
+
+/* SHA-256 轮常数 */
+static const uint32_t digest_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/**
+ * digest_init - 开始计算 SHA-256
+ */
+static void digest_init(Digest *d) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    memcpy(d->state, initial, sizeof(initial));
+    d->length = 0;
+    d->used = 0;
+}
+
+/**
+ * digest_block - 处理一个 64 字节的数据块
+ */
+static void digest_block(Digest *d, const unsigned char *p) {
+    uint32_t w[64];
+    uint32_t a, b, c, e, f, g, h, dd, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 |
+               (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        w[i] = w[i - 16] + (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+               w[i - 7] + (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+    a = d->state[0]; b = d->state[1]; c = d->state[2]; dd = d->state[3];
+    e = d->state[4]; f = d->state[5]; g = d->state[6]; h = d->state[7];
+    for (i = 0; i < 64; i++) {
+        t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) +
+             digest_k[i] + w[i];
+        t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = dd + t1;
+        dd = c; c = b; b = a; a = t1 + t2;
+    }
+    d->state[0] += a; d->state[1] += b; d->state[2] += c; d->state[3] += dd;
+    d->state[4] += e; d->state[5] += f; d->state[6] += g; d->state[7] += h;
+}
+
+/**
+ * hash_update - 把数据加入 SHA-256
+ */
+static void hash_update(Digest *d, const void *data, size_t len) {
+    const unsigned char *p = data;
+    size_t n;
+
+    d->length += len;
+    while (len > 0) {
+        n = 64 - d->used < len ? 64 - d->used : len;
+        memcpy(d->block + d->used, p, n);
+        d->used += n;
+        p += n;
+        len -= n;
+        if (d->used == 64) {
+            digest_block(d, d->block);
+            d->used = 0;
+        }
+    }
+}
+
+/**
+ * hash_string - 把字符串连同结尾的 '\0' 加入哈希，相邻的字符串不会混淆
+ */
+static void hash_string(Digest *d, const char *s) {
+    hash_update(d, s, strlen(s) + 1);
+}
+
+/**
+ * hash_final - 结束计算，输出十六进制摘要
+ *
+ * 参数：d - 计算状态，hex - 输出参数（DIGEST_HEX 字节）
+ */
+static void hash_final(Digest *d, char *hex) {
+    unsigned char pad[72] = { 0x80 };
+    uint64_t bits = d->length * 8;
+    size_t n = (d->used < 56 ? 56 : 120) - d->used;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        pad[n + i] = (unsigned char)(bits >> (56 - i * 8));
+    }
+    hash_update(d, pad, n + 8);
+    for (i = 0; i < 8; i++) {
+        sprintf(hex + i * 8, "%08x", d->state[i]);
+    }
+}
+
+/**
+ * hash_file - 计算文件内容的哈希
+ *
+ * 参数：path - 文件路径，hex - 输出参数（DIGEST_HEX 字节）
+ * 返回：0 表示成功，-1 表示无法读取
+ */
+static int hash_file(const char *path, char *hex) {
+    char buffer[CACHE_READ_SIZE];
+    Digest d;
+    ssize_t n;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        return -1;
+    }
+    digest_init(&d);
+    while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return -1;
+        }
+        hash_update(&d, buffer, n);
+    }
+    close(fd);
+    hash_final(&d, hex);
+    return 0;
+}
+
+/**
+ * cache_key - 计算命令的键
+ *
+ * 功能：键由当前目录、全部参数、VAR=val 前缀、cache_env 和 -e 声明的
+ *       环境变量、< 输入文件和 -i 声明的文件的内容组成。标准输入来自
+ *       管道或没有重定向的文件时内容无法计入键，不使用缓存；终端和
+ *       /dev/null 等字符设备不计入键
+ * 参数：cmd - 去掉 cache 前缀后的命令，inputs/input_count - -i 声明的文件，
+ *       envs/env_count - -e 声明的变量，key - 输出参数（DIGEST_HEX 字节）
+ * 返回：0 表示成功，-1 表示有输入文件无法读取或标准输入不能缓存
+ */
+static int cache_key(Command *cmd, char **inputs, int input_count,
+                     char **envs, int env_count, char *key) {
+    Digest hash;
+    char content[DIGEST_HEX];
+    char cwd[MAX_PATH];
+    const char *value;
+    struct stat st;
+    int i;
+
+    digest_init(&hash);
+    hash_string(&hash, "myshell-cache 2");
+    hash_string(&hash, getcwd(cwd, sizeof(cwd)) != NULL ? cwd : "");
+    for (i = 0; i < cmd->argc; i++) {
+        hash_string(&hash, cmd->args[i]);
+    }
+
+    hash_string(&hash, cmd->env_clear ? "env -i" : "env");
+    for (i = 0; i < cmd->env_count; i++) {
+        hash_string(&hash, cmd->env[i]);
+    }
+    for (i = 0; cache_env[i] != NULL; i++) {
+        value = getenv(cache_env[i]);
+        hash_string(&hash, cache_env[i]);
+        hash_string(&hash, value != NULL ? value : "");
+    }
+    for (i = 0; i < env_count; i++) {
+        value = getenv(envs[i]);
+        hash_string(&hash, envs[i]);
+        hash_string(&hash, value != NULL ? value : "");
+    }
+
+    hash_string(&hash, "input");
+    if (cmd->input_file != NULL) {
+        if (stat(cmd->input_file, &st) < 0 ||
+            (S_ISREG(st.st_mode) && hash_file(cmd->input_file, content) < 0)) {
+            fprintf(stderr, "cache: %s: %s，不使用缓存\n", cmd->input_file, strerror(errno));
+            return -1;
+        }
+        if (!S_ISREG(st.st_mode) && !S_ISCHR(st.st_mode)) {
+            fprintf(stderr, "cache: %s: 不是普通文件，不使用缓存\n", cmd->input_file);
+            return -1;
+        }
+        hash_string(&hash, S_ISREG(st.st_mode) ? content : cmd->input_file);
+    } else if (fstat(STDIN_FILENO, &st) == 0 && !S_ISCHR(st.st_mode)) {
+        /* 继承的标准输入是管道或文件时内容未知，不能只凭参数判断结果 */
+        fprintf(stderr, "cache: 标准输入来自管道或文件，不使用缓存\n");
+        return -1;
+    }
+    for (i = 0; i < input_count; i++) {
+        if (hash_file(inputs[i], content) < 0) {
+            fprintf(stderr, "cache: %s: %s，不使用缓存\n", inputs[i], strerror(errno));
+            return -1;
+        }
+        hash_string(&hash, inputs[i]);
+        hash_string(&hash, content);
+    }
+
+    hash_final(&hash, key);
+    return 0;
+}
+
+/* ========== 缓存目录 ========== */
+
+/**
+ * make_dir - 创建目录，已存在时不算错误
+ */
+static int make_dir(const char *path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST ? 0 : -1;
+}
+
+/**
+ * cache_init - 确定并创建缓存目录
+ *
+ * 功能：目录为环境变量 MYSHELL_CACHE_DIR，未设置时为 ~/.cache/myshell
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int cache_init() {
+    char path[MAX_PATH];
+    const char *env = getenv("MYSHELL_CACHE_DIR");
+    const char *home;
+
+    if (env != NULL && env[0] != '\0') {
+        snprintf(cache_dir, sizeof(cache_dir), "%s", env);
+    } else if ((home = getenv("HOME")) != NULL) {
+        snprintf(path, sizeof(path), "%s/.cache", home);
+        make_dir(path);
+        snprintf(cache_dir, sizeof(cache_dir), "%s/" CACHE_DIR, home);
+    } else {
+        fprintf(stderr, "cache: 没有设置 HOME 或 MYSHELL_CACHE_DIR\n");
+        return -1;
+    }
+
+    if (make_dir(cache_dir) < 0) {
+        fprintf(stderr, "cache: 无法创建 %s: %s\n", cache_dir, strerror(errno));
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/objects", cache_dir);
+    if (make_dir(path) < 0) {
+        fprintf(stderr, "cache: 无法创建 %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/keys", cache_dir);
+    if (make_dir(path) < 0) {
+        fprintf(stderr, "cache: 无法创建 %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * cache_scan - 列出缓存中的所有输出文件
+ *
+ * 参数：objects - 输出参数，数组由调用者释放（可为 NULL，只统计），
+ *       total - 输出参数，总大小
+ * 返回：文件个数，失败返回 -1
+ */
+static int cache_scan(CacheObject **objects, long long *total) {
+    char path[MAX_PATH];
+    CacheObject *list = NULL;
+    CacheObject *grown;
+    struct dirent *entry;
+    struct stat st;
+    int count = 0, size = 0;
+    DIR *dir;
+
+    snprintf(path, sizeof(path), "%s/objects", cache_dir);
+    dir = opendir(path);
+    if (dir == NULL) {
+        return -1;
+    }
+
+    *total = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || strlen(entry->d_name) >= sizeof(list->name) ||
+            fstatat(dirfd(dir), entry->d_name, &st, 0) < 0) {
+            continue;
+        }
+        *total += st.st_size;
+        if (objects == NULL) {
+            count++;
+            continue;
+        }
+        if (count == size) {
+            size = size ? size * 2 : 64;
+            grown = realloc(list, size * sizeof(CacheObject));
+            if (grown == NULL) {
+                perror("cache");
+                free(list);
+                closedir(dir);
+                return -1;
+            }
+            list = grown;
+        }
+        strcpy(list[count].name, entry->d_name);
+        list[count].size = st.st_size;
+        list[count].mtime = st.st_mtime;
+        count++;
+    }
+    closedir(dir);
+
+    if (objects != NULL) {
+        *objects = list;
+    }
+    return count;
+}
+
+/**
+ * compare_object - 按最后使用时间排序，最久没有使用的在前
+ */
+static int compare_object(const void *a, const void *b) {
+    const CacheObject *x = a;
+    const CacheObject *y = b;
+
+    return x->mtime < y->mtime ? -1 : x->mtime > y->mtime;
+}
+
+/**
+ * cache_evict - 总大小超过上限时淘汰最久没有使用的输出
+ *
+ * 功能：只删除 objects/ 中的输出；指向已删除输出的键在下次查找时
+ *       视为未命中并删除。平时只比较 cache_total，超过上限时才扫描
+ *       目录并按使用时间排序，扫描结果同时校正 cache_total
+ *       （其他 shell 共用缓存目录时它会有偏差）
+ */
+static void cache_evict() {
+    char path[MAX_PATH];
+    CacheObject *objects;
+    long long total;
+    int count, i;
+
+    if (cache_total < 0 && cache_scan(NULL, &cache_total) < 0) {
+        cache_total = -1;
+        return;
+    }
+    if (cache_total <= cache_max) {
+        return;
+    }
+
+    count = cache_scan(&objects, &total);
+    if (count < 0) {
+        return;
+    }
+    if (total > cache_max) {
+        qsort(objects, count, sizeof(CacheObject), compare_object);
+        for (i = 0; i < count && total > cache_max; i++) {
+            snprintf(path, sizeof(path), "%s/objects/%s", cache_dir, objects[i].name);
+            if (unlink(path) == 0) {
+                total -= objects[i].size;
+                cache_evictions++;
+            }
+        }
+    }
+    cache_total = total;
+    free(objects);
+}
+
+/**
+ * cache_clear_dir - 删除缓存子目录中的所有文件
+ */
+static void cache_clear_dir(const char *name) {
+    char path[MAX_PATH];
+    struct dirent *entry;
+    DIR *dir;
+
+    snprintf(path, sizeof(path), "%s/%s", cache_dir, name);
+    dir = opendir(path);
+    if (dir == NULL) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            unlinkat(dirfd(dir), entry->d_name, 0);
+        }
+    }
+    closedir(dir);
+}
+
+/* ========== 查找和保存 ========== */
+
+/**
+ * output_open - 打开命令的输出目标
+ *
+ * 功能：有 > 或 >> 重定向时按相同的方式打开文件，否则为标准输出
+ * 返回：描述符，失败返回 -1
+ */
+static int output_open(Command *cmd) {
+    int fd;
+
+    if (cmd->output_file == NULL) {
+        fflush(stdout);
+        return STDOUT_FILENO;
+    }
+    fd = open(cmd->output_file, O_WRONLY | O_CREAT | O_CLOEXEC |
+              (cmd->append_mode ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0) {
+        perror("输出重定向");
+    }
+    return fd;
+}
+
+/**
+ * output_copy - 把输出文件复制到命令的输出目标
+ *
+ * 参数：in - 输出文件的描述符（从头读取），cmd - 命令
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int output_copy(int in, Command *cmd) {
+    int out = output_open(cmd);
+    int result;
+
+    if (out < 0) {
+        return -1;
+    }
+    result = copy_fd(in, out, -1);
+    if (result < 0) {
+        perror("cache");
+    }
+    if (out != STDOUT_FILENO) {
+        close(out);
+    }
+    return result;
+}
+
+/**
+ * cache_lookup - 查找键并恢复保存的输出
+ *
+ * 功能：命中时把输出写到命令的输出目标，记录退出状态，并更新键和输出的
+ *       修改时间作为最后使用时间。输出目标无法打开或写入时退出状态为 1。
+ *       键存在但输出已被淘汰时删除键
+ * 参数：key - 键，cmd - 命令
+ * 返回：1 表示命中，0 表示未命中
+ */
+static int cache_lookup(const char *key, Command *cmd) {
+    char path[MAX_PATH];
+    char line[128];
+    char object[DIGEST_HEX];
+    int status, fd, n;
+
+    snprintf(path, sizeof(path), "%s/keys/%s", cache_dir, key);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+    n = read(fd, line, sizeof(line) - 1);
+    close(fd);
+    if (n <= 0) {
+        return 0;
+    }
+    line[n] = '\0';
+    if (sscanf(line, "%d %64s", &status, object) != 2 || strlen(object) != DIGEST_HEX - 1) {
+        unlink(path);
+        return 0;
+    }
+    utimensat(AT_FDCWD, path, NULL, 0);
+
+    snprintf(path, sizeof(path), "%s/objects/%s", cache_dir, object);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        snprintf(path, sizeof(path), "%s/keys/%s", cache_dir, key);
+        unlink(path);
+        return 0;
+    }
+    futimens(fd, NULL);
+    if (output_copy(fd, cmd) < 0) {
+        status = 1;
+    }
+    close(fd);
+
+    status_set(status);
+    return 1;
+}
+
+/**
+ * cache_store - 保存一次执行的输出和退出状态
+ *
+ * 功能：输出按内容的哈希移入 objects/，已有相同内容时只更新使用时间；
+ *       键文件先写入临时文件再改名，中途失败不会留下不完整的键
+ * 参数：key - 键，output - 保存输出的临时文件，status - 退出状态
+ */
+static void cache_store(const char *key, const char *output, int status) {
+    char object_path[MAX_PATH];
+    char key_path[MAX_PATH];
+    char temp[MAX_PATH];
+    char object[DIGEST_HEX];
+    struct stat st;
+    int fd;
+
+    if (hash_file(output, object) < 0 || stat(output, &st) < 0) {
+        unlink(output);
+        return;
+    }
+    snprintf(object_path, sizeof(object_path), "%s/objects/%s", cache_dir, object);
+    if (access(object_path, F_OK) == 0) {
+        unlink(output);
+        utimensat(AT_FDCWD, object_path, NULL, 0);
+    } else if (rename(output, object_path) < 0) {
+        perror("cache");
+        unlink(output);
+        return;
+    } else if (cache_total >= 0) {
+        cache_total += st.st_size;
+    }
+
+    snprintf(temp, sizeof(temp), "%s/keys/tmp.XXXXXX", cache_dir);
+    fd = mkstemp(temp);
+    if (fd < 0) {
+        perror("cache");
+        return;
+    }
+    snprintf(key_path, sizeof(key_path), "%s/keys/%s", cache_dir, key);
+    if (dprintf(fd, "%d %s\n", status, object) < 0 || close(fd) < 0 ||
+        rename(temp, key_path) < 0) {
+        perror("cache");
+        unlink(temp);
+        return;
+    }
+
+    cache_stores++;
+    cache_evict();
+}
+
+/**
+ * cache_run - 执行命令并保存结果
+ *
+ * 功能：标准输出先写入缓存目录中的临时文件，执行完后复制到命令的输出目标。
+ *       只保存退出状态为 0 的结果：标准错误不保存，失败的命令再次执行时
+ *       才能重新输出错误信息；被 Ctrl-C 中断的结果也不保存。输出目标
+ *       无法打开或写入时退出状态为 1，结果不保存
+ * 参数：key - 键，cmd - 命令
+ * 返回：命令的执行结果
+ */
+static int cache_run(const char *key, Command *cmd) {
+    char temp[MAX_PATH];
+    char *output_file = cmd->output_file;
+    int append_mode = cmd->append_mode;
+    int result, status;
+    int fd;
+
+    snprintf(temp, sizeof(temp), "%s/tmp.XXXXXX", cache_dir);
+    fd = mkstemp(temp);
+    if (fd < 0) {
+        perror("cache");
+        return execute_external(cmd);
+    }
+
+    /* 程序没有运行（如 fork 失败）时状态保持为 126，不保存 */
+    status_set(126);
+    cmd->output_file = temp;
+    cmd->append_mode = 0;
+    result = execute_external(cmd);
+    cmd->output_file = output_file;
+    cmd->append_mode = append_mode;
+    status = status_get();
+
+    lseek(fd, 0, SEEK_SET);
+    if (output_copy(fd, cmd) < 0 && result != -999) {
+        status_set(1);
+        status = 1;
+        result = -1;
+    }
+    close(fd);
+
+    if (result != -999 && status == 0 && !job_interrupted()) {
+        cache_store(key, temp, status);
+    } else {
+        unlink(temp);
+    }
+    return result;
+}
+
+/**
+ * cache_command - 查找缓存，未命中时执行命令并保存结果
+ *
+ * 参数：cmd - 去掉 cache 前缀后的命令，inputs/input_count - -i 声明的文件，
+ *       envs/env_count - -e 声明的变量
+ * 返回：命令的执行结果
+ */
+static int cache_command(Command *cmd, char **inputs, int input_count,
+                         char **envs, int env_count) {
+    char key[DIGEST_HEX];
+
+    if (function_find(cmd->args[0]) != NULL || find_builtin(cmd->args[0]) != NULL) {
+        fprintf(stderr, "cache: %s: 只缓存外部程序，直接执行\n", cmd->args[0]);
+        return execute_command(cmd);
+    }
+    if (cmd->background ||
+        cache_key(cmd, inputs, input_count, envs, env_count, key) < 0) {
+        return execute_external(cmd);
+    }
+
+    if (cache_lookup(key, cmd)) {
+        cache_hits++;
+        return status_get() == 0 ? 0 : -1;
+    }
+    cache_misses++;
+    return cache_run(key, cmd);
+}
+
+/* ========== 内部命令 ========== */
+
+/**
+ * parse_size - 解析大小，可以带 K、M、G 后缀
+ *
+ * 返回：字节数，格式错误返回 -1
+ */
+static long long parse_size(const char *text) {
+    char *end;
+    long long value = strtoll(text, &end, 10);
+
+    if (end == text || value < 0) {
+        return -1;
+    }
+    switch (*end) {
+    case '\0':
+        return value;
+    case 'k':
+    case 'K':
+        value <<= 10;
+        break;
+    case 'm':
+    case 'M':
+        value <<= 20;
+        break;
+    case 'g':
+    case 'G':
+        value <<= 30;
+        break;
+    default:
+        return -1;
+    }
+    return end[1] == '\0' ? value : -1;
+}
+
+/**
+ * cache_stats - 输出缓存目录的大小和本次运行的命中统计
+ */
+static void cache_stats() {
+    long long total = 0;
+    long lookups = cache_hits + cache_misses;
+    int count = cache_scan(NULL, &total);
+
+    if (count >= 0) {
+        cache_total = total;
+    }
+
+    printf("目录: %s\n", cache_dir);
+    printf("输出: %d 个，%.1f MB / %.1f MB\n", count < 0 ? 0 : count,
+           total / 1048576.0, cache_max / 1048576.0);
+    printf("命中: %ld，未命中: %ld，命中率: %ld%%\n", cache_hits, cache_misses,
+           lookups ? cache_hits * 100 / lookups : 0);
+    printf("保存: %ld，淘汰: %ld\n", cache_stores, cache_evictions);
+}
+
+/**
+ * cmd_cache - 缓存外部程序的执行结果
+ *
+ * 功能：cache [-i 文件]... [-e 变量]... command [args...]
+ *       键命中时恢复保存的标准输出（或 > >> 重定向的输出）和退出状态，
+ *       否则执行程序并保存结果。-i 声明程序读取的输入文件，-e 声明
+ *       影响结果的环境变量，都参与计算键；
+ *       cache 显示统计，cache -c 清空缓存，cache -m 大小 设置大小上限
+ * 参数：cmd - Command 结构体指针
+ * 返回：命令的执行结果，参数错误返回 -1
+ */
+int cmd_cache(Command *cmd) {
+    char *inputs[MAX_ARGS];
+    char *envs[MAX_ARGS];
+    char *prefix[MAX_ARGS];
+    int input_count = 0, env_count = 0;
+    long long size;
+    int shift = 1;
+    int result, i;
+
+    if (cache_dir[0] == '\0' && cache_init() < 0) {
+        return -1;
+    }
+
+    if (cmd->argc == 1) {
+        cache_stats();
+        return 0;
+    }
+    if (cmd->argc == 2 && strcmp(cmd->args[1], "-c") == 0) {
+        cache_clear_dir("keys");
+        cache_clear_dir("objects");
+        cache_total = -1;
+        return 0;
+    }
+    if (cmd->argc == 3 && strcmp(cmd->args[1], "-m") == 0) {
+        size = parse_size(cmd->args[2]);
+        if (size < 0) {
+            fprintf(stderr, "cache: 无效的大小 '%s'\n", cmd->args[2]);
+            return -1;
+        }
+        cache_max = size;
+        cache_evict();
+        return 0;
+    }
+
+    while (shift + 1 < cmd->argc) {
+        if (strcmp(cmd->args[shift], "-i") == 0) {
+            inputs[input_count++] = cmd->args[shift + 1];
+        } else if (strcmp(cmd->args[shift], "-e") == 0) {
+            envs[env_count++] = cmd->args[shift + 1];
+        } else {
+            break;
+        }
+        shift += 2;
+    }
+    if (shift >= cmd->argc || cmd->args[shift][0] == '-') {
+        fprintf(stderr, "用法: cache [-i 文件]... [-e 变量]... command [args...]\n"
+                        "      cache [-c | -m 大小]\n");
+        return -1;
+    }
+
+    /* 去掉 cache 及其参数，剩下的就是要执行的命令。去掉的单词由
+     * build_command 分配，inputs、envs 还指向其中的字符串，执行完再释放 */
+    for (i = 0; i < shift; i++) {
+        prefix[i] = cmd->args[i];
+    }
+    memmove(cmd->args, cmd->args + shift,
+            (cmd->argc - shift + 1) * sizeof(char *));
+    cmd->argc -= shift;
+
+    result = cache_command(cmd, inputs, input_count, envs, env_count);
+    for (i = 0; i < shift; i++) {
+        free(prefix[i]);
+    }
+    return result;
+}
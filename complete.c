@@ -0,0 +1,742 @@
+/*
+ * complete.c - MyShell Tab 补全
+ *
+ * 功能：为行编辑器提供 Tab 补全。命令名（内部命令和 PATH 中的可执行文件）
+ *       保存在字典树中，首次补全时才建立；之后每次补全只 stat 一遍 PATH
+ *       中的目录，仅重新扫描修改时间变化的目录，并增量更新字典树。
+ *       文件路径和环境变量名在补全时直接枚举
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/stat.h>
+
+/* 一次最多列出的候选项数量 */
+#define MAX_LISTED 200
+
+/* 外部环境变量数组 */
+extern char **environ;
+
+/**
+ * TrieNode 结构体 - 字典树节点
+ *
+ * 字段说明：
+ *   child    - 第一个子节点，兄弟节点按字符升序排列
+ *   sibling  - 下一个兄弟节点
+ *   words    - 以该节点为前缀的不同单词数量
+ *   refs     - 以该节点结尾的单词的引用计数（同名命令可能出现在多个目录中）
+ *   c        - 节点字符
+ */
+typedef struct TrieNode {
+    struct TrieNode *child;
+    struct TrieNode *sibling;
+    int words;
+    int refs;
+    unsigned char c;
+} TrieNode;
+
+/**
+ * PathDir 结构体 - PATH 中一个目录的扫描结果
+ *
+ * 字段说明：
+ *   path     - 目录路径
+ *   mtime    - 上次扫描时目录的修改时间
+ *   names    - 目录中的可执行文件名
+ *   count    - 可执行文件数量
+ *   seen     - 本次刷新中是否仍在 PATH 中
+ */
+typedef struct {
+    char *path;
+    struct timespec mtime;
+    char **names;
+    int count;
+    int seen;
+} PathDir;
+
+/**
+ * Candidates 结构体 - 文件名或变量名补全的候选集合
+ *
+ * 字段说明：
+ *   items    - 候选项（目录以 '/' 结尾）
+ *   count    - 候选项数量
+ *   capacity - 数组容量
+ */
+typedef struct {
+    char **items;
+    int count;
+    int capacity;
+} Candidates;
+
+/* 命令名字典树，root 为 NULL 表示尚未建立 */
+static TrieNode *command_trie = NULL;
+
+/* PATH 目录缓存 */
+static PathDir *path_dirs = NULL;
+static int path_dir_count = 0;
+
+/* ========== 字典树 ========== */
+
+/**
+ * trie_new_node - 分配字典树节点
+ *
+ * 参数：c - 节点字符
+ * 返回：新节点，内存不足时返回 NULL
+ */
+static TrieNode* trie_new_node(unsigned char c) {
+    TrieNode *node = calloc(1, sizeof(TrieNode));
+
+    if (node != NULL) {
+        node->c = c;
+    }
+    return node;
+}
+
+/**
+ * trie_free - 释放以 node 为根的子树
+ *
+ * 参数：node - 子树根
+ */
+static void trie_free(TrieNode *node) {
+    TrieNode *next;
+
+    while (node != NULL) {
+        next = node->sibling;
+        trie_free(node->child);
+        free(node);
+        node = next;
+    }
+}
+
+/**
+ * trie_find - 查找与前缀对应的节点
+ *
+ * 参数：root - 根节点，prefix - 前缀，len - 前缀长度
+ * 返回：节点，不存在时返回 NULL
+ */
+static TrieNode* trie_find(TrieNode *root, const char *prefix, int len) {
+    TrieNode *node = root;
+    TrieNode *child;
+    int i;
+
+    for (i = 0; i < len && node != NULL; i++) {
+        for (child = node->child; child != NULL; child = child->sibling) {
+            if (child->c >= (unsigned char)prefix[i]) {
+                break;
+            }
+        }
+        node = (child != NULL && child->c == (unsigned char)prefix[i]) ? child : NULL;
+    }
+    return node;
+}
+
+/**
+ * trie_insert - 插入单词（已存在时增加引用计数）
+ *
+ * 参数：root - 根节点，word - 单词
+ */
+static void trie_insert(TrieNode *root, const char *word) {
+    TrieNode *path[256];
+    TrieNode *node = root;
+    TrieNode **link;
+    TrieNode *child;
+    int len = strlen(word);
+    int i;
+
+    if (len == 0 || len >= (int)(sizeof(path) / sizeof(path[0]))) {
+        return;
+    }
+
+    path[0] = root;
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)word[i];
+
+        /* 在有序兄弟链表中找到插入位置 */
+        for (link = &node->child; *link != NULL && (*link)->c < c;
+             link = &(*link)->sibling) {
+        }
+        if (*link == NULL || (*link)->c != c) {
+            child = trie_new_node(c);
+            if (child == NULL) {
+                return;
+            }
+            child->sibling = *link;
+            *link = child;
+        }
+        node = *link;
+        path[i + 1] = node;
+    }
+
+    if (node->refs++ == 0) {
+        for (i = 0; i <= len; i++) {
+            path[i]->words++;
+        }
+    }
+}
+
+/**
+ * trie_remove - 减少单词的引用计数，归零时删除
+ *
+ * 功能：删除后不再有单词的分支会被整体释放
+ * 参数：root - 根节点，word - 单词
+ */
+static void trie_remove(TrieNode *root, const char *word) {
+    TrieNode *node = trie_find(root, word, strlen(word));
+    TrieNode **link;
+    TrieNode *parent = root;
+    TrieNode *dead;
+    int i, len;
+
+    if (node == NULL || node->refs == 0 || --node->refs > 0) {
+        return;
+    }
+
+    /* 沿路径减少单词数量，第一个减到 0 的节点及其子树整体删除 */
+    root->words--;
+    len = strlen(word);
+    for (i = 0; i < len; i++) {
+        for (link = &parent->child; (*link)->c != (unsigned char)word[i];
+             link = &(*link)->sibling) {
+        }
+        if (--(*link)->words == 0) {
+            dead = *link;
+            *link = dead->sibling;
+            dead->sibling = NULL;
+            trie_free(dead);
+            return;
+        }
+        parent = *link;
+    }
+}
+
+/**
+ * trie_collect - 深度优先收集子树中的单词
+ *
+ * 参数：node - 子树根，word - 当前前缀缓冲区，len - 前缀长度，
+ *       out - 输出集合，limit - 最多收集的数量
+ */
+static void trie_collect(TrieNode *node, char *word, int len,
+                         Candidates *out, int limit);
+
+/* ========== 候选集合 ========== */
+
+/**
+ * candidates_add - 向候选集合中添加一项
+ *
+ * 参数：set - 候选集合，text - 内容，len - 长度，dir - 是否追加 '/'
+ */
+static void candidates_add(Candidates *set, const char *text, int len, int dir) {
+    char **grown;
+    char *item;
+
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : 32;
+        grown = realloc(set->items, capacity * sizeof(char *));
+        if (grown == NULL) {
+            return;
+        }
+        set->items = grown;
+        set->capacity = capacity;
+    }
+
+    item = malloc(len + 2);
+    if (item == NULL) {
+        return;
+    }
+    memcpy(item, text, len);
+    if (dir) {
+        item[len++] = '/';
+    }
+    item[len] = '\0';
+    set->items[set->count++] = item;
+}
+
+/**
+ * candidates_free - 释放候选集合
+ *
+ * 参数：set - 候选集合
+ */
+static void candidates_free(Candidates *set) {
+    int i;
+
+    for (i = 0; i < set->count; i++) {
+        free(set->items[i]);
+    }
+    free(set->items);
+    set->items = NULL;
+    set->count = set->capacity = 0;
+}
+
+/**
+ * compare_items - qsort 比较函数
+ */
+static int compare_items(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static void trie_collect(TrieNode *node, char *word, int len,
+                         Candidates *out, int limit) {
+    TrieNode *child;
+
+    if (out->count >= limit) {
+        return;
+    }
+    if (node->refs > 0) {
+        candidates_add(out, word, len, 0);
+    }
+    if (len >= MAX_LINE - 1) {
+        return;
+    }
+    for (child = node->child; child != NULL; child = child->sibling) {
+        word[len] = (char)child->c;
+        trie_collect(child, word, len + 1, out, limit);
+    }
+}
+
+/* ========== PATH 扫描 ========== */
+
+/**
+ * scan_path_dir - 扫描目录中的可执行文件
+ *
+ * 参数：dir - 目录缓存项，扫描结果保存在 names 中
+ */
+static void scan_path_dir(PathDir *dir) {
+    DIR *d;
+    struct dirent *entry;
+    struct stat st;
+    char **grown;
+    int capacity = 0;
+
+    dir->names = NULL;
+    dir->count = 0;
+
+    d = opendir(dir->path);
+    if (d == NULL) {
+        return;
+    }
+
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.' || entry->d_type == DT_DIR) {
+            continue;
+        }
+        if (faccessat(dirfd(d), entry->d_name, X_OK, 0) < 0) {
+            continue;
+        }
+        /* 符号链接或类型未知时排除目录 */
+        if (entry->d_type != DT_REG &&
+            (fstatat(dirfd(d), entry->d_name, &st, 0) < 0 || S_ISDIR(st.st_mode))) {
+            continue;
+        }
+
+        if (dir->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            grown = realloc(dir->names, capacity * sizeof(char *));
+            if (grown == NULL) {
+                break;
+            }
+            dir->names = grown;
+        }
+        dir->names[dir->count] = strdup(entry->d_name);
+        if (dir->names[dir->count] != NULL) {
+            trie_insert(command_trie, dir->names[dir->count]);
+            dir->count++;
+        }
+    }
+    closedir(d);
+}
+
+/**
+ * drop_path_dir - 从字典树中移除目录的所有命令并释放扫描结果
+ *
+ * 参数：dir - 目录缓存项
+ */
+static void drop_path_dir(PathDir *dir) {
+    int i;
+
+    for (i = 0; i < dir->count; i++) {
+        trie_remove(command_trie, dir->names[i]);
+        free(dir->names[i]);
+    }
+    free(dir->names);
+    dir->names = NULL;
+    dir->count = 0;
+}
+
+/**
+ * refresh_commands - 建立或增量更新命令字典树
+ *
+ * 功能：首次调用时插入内部命令；之后对 PATH 中每个目录 stat 一次，
+ *       新目录和修改时间变化的目录重新扫描，不再出现在 PATH 中的目录被移除
+ */
+static void refresh_commands() {
+    char path_copy[MAX_PATH * 4];
+    const char *path_env = getenv("PATH");
+    PathDir *grown;
+    struct stat st;
+    char *dir, *save;
+    int i;
+
+    if (command_trie == NULL) {
+        command_trie = trie_new_node(0);
+        if (command_trie == NULL) {
+            return;
+        }
+        for (i = 0; builtin_name(i) != NULL; i++) {
+            trie_insert(command_trie, builtin_name(i));
+        }
+    }
+
+    for (i = 0; i < path_dir_count; i++) {
+        path_dirs[i].seen = 0;
+    }
+
+    snprintf(path_copy, sizeof(path_copy), "%s", path_env ? path_env : "");
+    for (dir = strtok_r(path_copy, ":", &save); dir != NULL;
+         dir = strtok_r(NULL, ":", &save)) {
+        for (i = 0; i < path_dir_count; i++) {
+            if (strcmp(path_dirs[i].path, dir) == 0) {
+                break;
+            }
+        }
+
+        if (i < path_dir_count && path_dirs[i].seen) {
+            continue;   /* PATH 中重复出现的目录 */
+        }
+
+        if (stat(dir, &st) < 0) {
+            st.st_mtim.tv_sec = 0;
+            st.st_mtim.tv_nsec = 0;
+        }
+
+        if (i == path_dir_count) {
+            /* 新目录 */
+            grown = realloc(path_dirs, (path_dir_count + 1) * sizeof(PathDir));
+            if (grown == NULL) {
+                continue;
+            }
+            path_dirs = grown;
+            path_dirs[i].path = strdup(dir);
+            if (path_dirs[i].path == NULL) {
+                continue;
+            }
+            path_dir_count++;
+            scan_path_dir(&path_dirs[i]);
+        } else if (path_dirs[i].mtime.tv_sec != st.st_mtim.tv_sec ||
+                   path_dirs[i].mtime.tv_nsec != st.st_mtim.tv_nsec) {
+            /* 目录内容有变化，重新扫描 */
+            drop_path_dir(&path_dirs[i]);
+            scan_path_dir(&path_dirs[i]);
+        }
+
+        path_dirs[i].mtime = st.st_mtim;
+        path_dirs[i].seen = 1;
+    }
+
+    /* 移除已不在 PATH 中的目录 */
+    for (i = path_dir_count - 1; i >= 0; i--) {
+        if (!path_dirs[i].seen) {
+            drop_path_dir(&path_dirs[i]);
+            free(path_dirs[i].path);
+            path_dirs[i] = path_dirs[--path_dir_count];
+        }
+    }
+}
+
+/* ========== 补全上下文 ========== */
+
+/**
+ * is_word_break - 判断字符是否分隔单词
+ */
+static int is_word_break(char c) {
+    return c == ' ' || c == '\t' || strchr(";&|<>(){}", c) != NULL;
+}
+
+/**
+ * find_word - 找到光标所在单词，并判断补全类型
+ *
+ * 参数：line - 命令行，pos - 光标偏移，
+ *       command - 输出参数，1 表示单词处于命令位置
+ * 返回：单词起始偏移
+ */
+static int find_word(const char *line, int pos, int *command) {
+    int start = pos;
+    int i;
+
+    while (start > 0 && !is_word_break(line[start - 1])) {
+        start--;
+    }
+
+    /* 向前跳过空白，看前一个非空字符是否为命令分隔符 */
+    for (i = start - 1; i >= 0 && (line[i] == ' ' || line[i] == '\t'); i--) {
+    }
+    *command = i < 0 || strchr(";&|({", line[i]) != NULL;
+
+    return start;
+}
+
+/**
+ * gather_files - 收集与前缀匹配的文件名
+ *
+ * 功能：单词中最后一个 '/' 之前为目录部分（支持 ~ 表示 HOME），
+ *       之后为文件名前缀；以 '.' 开头的文件只在前缀以 '.' 开头时列出
+ * 参数：word - 单词，len - 单词长度，out - 输出集合，
+ *       base - 输出参数，文件名部分在单词中的偏移
+ */
+static void gather_files(const char *word, int len, Candidates *out, int *base) {
+    char dir_path[MAX_PATH];
+    char full[MAX_PATH * 2];
+    const char *slash = NULL;
+    const char *prefix;
+    const char *home;
+    struct dirent *entry;
+    struct stat st;
+    DIR *dir;
+    int prefix_len, is_dir, i;
+
+    for (i = len - 1; i >= 0; i--) {
+        if (word[i] == '/') {
+            slash = word + i;
+            break;
+        }
+    }
+
+    if (slash == NULL) {
+        snprintf(dir_path, sizeof(dir_path), ".");
+        prefix = word;
+    } else if (word[0] == '~' && (slash == word + 1) &&
+               (home = getenv("HOME")) != NULL) {
+        snprintf(dir_path, sizeof(dir_path), "%s/", home);
+        prefix = slash + 1;
+    } else {
+        snprintf(dir_path, sizeof(dir_path), "%.*s", (int)(slash - word + 1), word);
+        prefix = slash + 1;
+    }
+    prefix_len = len - (prefix - word);
+    *base = prefix - word;
+
+    dir = opendir(dir_path);
+    if (dir == NULL) {
+        return;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        if (entry->d_name[0] == '.' && (prefix_len == 0 || prefix[0] != '.')) {
+            continue;
+        }
+        if (strncmp(entry->d_name, prefix, prefix_len) != 0) {
+            continue;
+        }
+
+        is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+            snprintf(full, sizeof(full), "%s/%s", dir_path, entry->d_name);
+            is_dir = stat(full, &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        candidates_add(out, entry->d_name, strlen(entry->d_name), is_dir);
+    }
+    closedir(dir);
+}
+
+/**
+ * gather_variables - 收集与前缀匹配的环境变量名
+ *
+ * 参数：prefix - 变量名前缀，len - 前缀长度，out - 输出集合
+ */
+static void gather_variables(const char *prefix, int len, Candidates *out) {
+    const char *eq;
+    int i;
+
+    for (i = 0; environ[i] != NULL; i++) {
+        eq = strchr(environ[i], '=');
+        if (eq != NULL && eq - environ[i] >= len &&
+            strncmp(environ[i], prefix, len) == 0) {
+            candidates_add(out, environ[i], eq - environ[i], 0);
+        }
+    }
+}
+
+/**
+ * common_prefix - 计算候选集合的最长公共前缀长度
+ *
+ * 参数：set - 候选集合
+ * 返回：公共前缀长度
+ */
+static int common_prefix(Candidates *set) {
+    int len, i;
+
+    if (set->count == 0) {
+        return 0;
+    }
+    len = strlen(set->items[0]);
+    for (i = 1; i < set->count; i++) {
+        int j = 0;
+        while (j < len && set->items[i][j] == set->items[0][j]) {
+            j++;
+        }
+        len = j;
+    }
+    return len;
+}
+
+/**
+ * gather - 收集光标所在单词的候选项
+ *
+ * 功能：命令位置且不含 '/' 时从命令字典树补全，以 '$' 开头时补全环境变量名，
+ *       其余补全文件路径
+ * 参数：line - 命令行，pos - 光标偏移，out - 输出集合，limit - 最多收集数量，
+ *       typed - 输出参数，候选项中已经输入的长度，
+ *       total - 输出参数，匹配总数（命令补全时可能大于收集数量），
+ *       common - 输出参数，最长公共前缀（命令补全时由字典树直接得到）
+ */
+static void gather(const char *line, int pos, Candidates *out, int limit,
+                   int *typed, int *total, char *common) {
+    char word[MAX_LINE];
+    TrieNode *node;
+    int start, command, len, base;
+
+    start = find_word(line, pos, &command);
+    len = pos - start;
+    memcpy(word, line + start, len);
+    word[len] = '\0';
+    common[0] = '\0';
+
+    if (command && strchr(word, '/') == NULL && word[0] != '~') {
+        refresh_commands();
+        node = command_trie ? trie_find(command_trie, word, len) : NULL;
+        *typed = len;
+        *total = node ? node->words : 0;
+        if (node == NULL) {
+            return;
+        }
+
+        /* 沿唯一分支向下得到公共前缀，无需枚举全部候选 */
+        memcpy(common, word, len);
+        while (node->refs == 0 && node->child != NULL && node->child->sibling == NULL &&
+               len < MAX_LINE - 1) {
+            node = node->child;
+            common[len++] = (char)node->c;
+        }
+        common[len] = '\0';
+
+        if (limit > 0) {
+            memcpy(word, common, len);
+            trie_collect(node, word, len, out, limit);
+        }
+        return;
+    }
+
+    if (word[0] == '$') {
+        gather_variables(word + 1, len - 1, out);
+        *typed = len - 1;
+    } else {
+        gather_files(word, len, out, &base);
+        *typed = len - base;
+    }
+    *total = out->count;
+
+    if (out->count > 0) {
+        len = common_prefix(out);
+        memcpy(common, out->items[0], len);
+        common[len] = '\0';
+    }
+}
+
+/* ========== 对外接口 ========== */
+
+/**
+ * complete_add_command - 向命令字典树加入命令名
+ *
+ * 功能：供 enable -f 加载命令后调用；字典树尚未建立时在建立时加入
+ * 参数：name - 命令名
+ */
+void complete_add_command(const char *name) {
+    if (command_trie != NULL) {
+        trie_insert(command_trie, name);
+    }
+}
+
+/**
+ * complete_remove_command - 从命令字典树移除命令名
+ *
+ * 参数：name - 命令名
+ */
+void complete_remove_command(const char *name) {
+    if (command_trie != NULL) {
+        trie_remove(command_trie, name);
+    }
+}
+
+/**
+ * complete_word - 计算光标处应插入的补全内容
+ *
+ * 功能：唯一匹配时插入剩余部分，并追加空格（目录追加 '/' 后不加空格）；
+ *       多个匹配时插入最长公共前缀的剩余部分
+ * 参数：line - 命令行，pos - 光标偏移，insert - 输出参数，size - 缓冲区大小
+ * 返回：匹配数量
+ */
+int complete_word(const char *line, int pos, char *insert, size_t size) {
+    Candidates set = { NULL, 0, 0 };
+    char common[MAX_LINE];
+    int typed, total, len;
+
+    insert[0] = '\0';
+    gather(line, pos, &set, 0, &typed, &total, common);
+
+    len = strlen(common);
+    if (total > 0 && len >= typed) {
+        snprintf(insert, size, "%s%s", common + typed,
+                 (total == 1 && (len == 0 || common[len - 1] != '/')) ? " " : "");
+    }
+
+    candidates_free(&set);
+    return total;
+}
+
+/**
+ * complete_list - 列出光标处单词的所有候选项
+ *
+ * 功能：按终端宽度分列显示，最多显示 MAX_LISTED 项。
+ *       行编辑器处于原始模式，因此使用 "\r\n" 换行
+ * 参数：line - 命令行，pos - 光标偏移，cols - 终端列数
+ */
+void complete_list(const char *line, int pos, int cols) {
+    Candidates set = { NULL, 0, 0 };
+    char common[MAX_LINE];
+    int typed, total;
+    int width = 0, per_row, i, len;
+
+    gather(line, pos, &set, MAX_LISTED, &typed, &total, common);
+    if (set.count == 0) {
+        candidates_free(&set);
+        return;
+    }
+
+    qsort(set.items, set.count, sizeof(char *), compare_items);
+    for (i = 0; i < set.count && i < MAX_LISTED; i++) {
+        len = strlen(set.items[i]);
+        if (len > width) {
+            width = len;
+        }
+    }
+    width += 2;
+    per_row = cols / width > 0 ? cols / width : 1;
+
+    printf("\r\n");
+    for (i = 0; i < set.count && i < MAX_LISTED; i++) {
+        printf("%-*s", width, set.items[i]);
+        if ((i + 1) % per_row == 0) {
+            printf("\r\n");
+        }
+    }
+    if (i % per_row != 0) {
+        printf("\r\n");
+    }
+    if (total > i) {
+        printf("... 共 %d 项\r\n", total);
+    }
+    fflush(stdout);
+
+    candidates_free(&set);
+}
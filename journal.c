@@ -0,0 +1,367 @@
+/*
+ * journal.c - MyShell 批处理日志
+ *
+ * 功能：--journal 日志文件 运行批处理文件时，每条命令（一行，或跨越多行的
+ *       复合命令）执行完毕后向日志追加一条记录：命令在文件中的偏移、
+ *       命令文本的哈希、退出状态和耗时。--resume 重新运行时读入日志，
+ *       跳过已成功完成的命令，只执行剩余的部分；恢复前日志被压缩为
+ *       每条已完成的命令一条记录，重新执行的命令不会留下重复的记录。
+ *       每条记录都立即 write，shell 异常终止不会丢失；fdatasync 按条数和
+ *       时间分批进行，避免每条命令都等待磁盘
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/stat.h>
+
+/* 累计多少条记录或经过多少毫秒后同步一次日志 */
+#define JOURNAL_SYNC_ENTRIES 64
+#define JOURNAL_SYNC_MS      1000
+
+/* 日志文件的第一行 */
+#define JOURNAL_HEADER "# myshell journal: 偏移 哈希 状态 耗时(ms)\n"
+
+/**
+ * Done 结构体 - 日志中一条已成功完成的命令
+ *
+ * 字段说明：
+ *   offset  - 命令在批处理文件中的偏移
+ *   hash    - 命令文本的哈希，文件修改后偏移相同的命令不会被误跳过
+ *   status  - 退出状态，读入时同一命令的多条记录以最后一条为准
+ *   elapsed - 耗时（毫秒），压缩日志时原样写回
+ *   order   - 记录在日志中的行号，用于找出最后一条
+ */
+typedef struct {
+    long long offset;
+    unsigned long long hash;
+    int status;
+    long long elapsed;
+    int order;
+} Done;
+
+/* 日志文件描述符，-1 表示没有开启日志 */
+static int journal_fd = -1;
+
+/* --resume 时读入的已完成命令，按偏移排序 */
+static Done *done = NULL;
+static int done_count = 0;
+static int skipped = 0;
+
+/* 尚未同步的记录数和上次同步的时刻 */
+static int unsynced = 0;
+static struct timespec last_sync;
+
+/* 只改变 shell 自身状态的内部命令，--resume 时总是重新执行 */
+static const char *setup_commands[] = {
+    "cd", "export", "unset", "alias", "unalias", "set", "shift", "let",
+    "ulimit", "cgroup", "affinity", "prompt", "enable", NULL
+};
+
+/* ========== 已完成的命令 ========== */
+
+/**
+ * journal_hash - 计算命令文本的哈希（64 位 FNV-1a）
+ */
+static unsigned long long journal_hash(const char *text) {
+    unsigned long long hash = 14695981039346656037ULL;
+
+    while (*text != '\0') {
+        hash = (hash ^ (unsigned char)*text++) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * compare_done - 按偏移和哈希比较已完成的命令
+ */
+static int compare_done(const void *a, const void *b) {
+    const Done *x = a;
+    const Done *y = b;
+
+    if (x->offset != y->offset) {
+        return x->offset < y->offset ? -1 : 1;
+    }
+    if (x->hash != y->hash) {
+        return x->hash < y->hash ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * compare_record - 按偏移、哈希和行号排序日志记录
+ */
+static int compare_record(const void *a, const void *b) {
+    const Done *x = a;
+    const Done *y = b;
+    int result = compare_done(a, b);
+
+    if (result != 0) {
+        return result;
+    }
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+/**
+ * journal_load - 读入日志中已成功完成的命令
+ *
+ * 功能：以 # 开头的行和格式不正确的行（如写了一半的最后一行）被忽略；
+ *       同一命令有多条记录时以最后一条为准，状态不为 0 的命令不算完成，
+ *       恢复时重新执行。日志不存在时视为空
+ * 参数：path - 日志文件路径
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int journal_load(const char *path) {
+    FILE *fp = fopen(path, "r");
+    char line[256];
+    long long offset, elapsed;
+    unsigned long long hash;
+    int status, size = 0;
+    int i, count = 0;
+    Done *grown;
+
+    if (fp == NULL) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        fprintf(stderr, "myshell: 无法读取日志 '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '#' || strchr(line, '\n') == NULL ||
+            sscanf(line, "%lld %llx %d %lld", &offset, &hash, &status, &elapsed) != 4) {
+            continue;
+        }
+        if (done_count == size) {
+            size = size ? size * 2 : 256;
+            grown = realloc(done, size * sizeof(Done));
+            if (grown == NULL) {
+                perror("myshell: journal");
+                fclose(fp);
+                return -1;
+            }
+            done = grown;
+        }
+        done[done_count].offset = offset;
+        done[done_count].hash = hash;
+        done[done_count].status = status;
+        done[done_count].elapsed = elapsed;
+        done[done_count].order = done_count;
+        done_count++;
+    }
+    fclose(fp);
+
+    /* 每组相同的命令只留下最后一条记录，且只留成功的 */
+    qsort(done, done_count, sizeof(Done), compare_record);
+    for (i = 0; i < done_count; i++) {
+        if (i + 1 < done_count && compare_done(&done[i], &done[i + 1]) == 0) {
+            continue;
+        }
+        if (done[i].status == 0) {
+            done[count++] = done[i];
+        }
+    }
+    done_count = count;
+    return 0;
+}
+
+/**
+ * journal_compact - 把日志改写为只含已完成命令的记录
+ *
+ * 功能：先写入临时文件再 rename 替换，中途失败时原日志不变。
+ *       失败的命令恢复时重新执行并追加新的记录，日志中不会有重复的偏移
+ * 参数：path - 日志文件路径
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int journal_compact(const char *path) {
+    char temp[MAX_PATH];
+    char entry[128];
+    int fd, len, i, ok;
+
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp)) {
+        fprintf(stderr, "myshell: 日志路径过长: %s\n", path);
+        return -1;
+    }
+    fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "myshell: 无法压缩日志 '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    len = strlen(JOURNAL_HEADER);
+    ok = write(fd, JOURNAL_HEADER, len) == len;
+    for (i = 0; ok && i < done_count; i++) {
+        len = snprintf(entry, sizeof(entry), "%lld %016llx 0 %lld\n",
+                       done[i].offset, done[i].hash, done[i].elapsed);
+        ok = write(fd, entry, len) == len;
+    }
+    ok = ok && fdatasync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp, path) < 0) {
+        fprintf(stderr, "myshell: 无法压缩日志 '%s': %s\n", path, strerror(errno));
+        unlink(temp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * is_setup - 判断命令列表是否只改变 shell 自身的状态
+ *
+ * 功能：函数定义、变量赋值和 cd、export 等内部命令执行代价很小，
+ *       但后面的命令依赖它们设置的状态，恢复时总是重新执行
+ */
+static int is_setup(Node *list) {
+    Node *item;
+    const char *eq;
+    int i;
+
+    for (item = list; item != NULL; item = item->next) {
+        if (item->type == NODE_FUNCTION) {
+            continue;
+        }
+        if (item->type != NODE_SIMPLE || item->background || item->word_count == 0) {
+            return 0;
+        }
+        eq = strchr(item->words[0], '=');
+        if (eq != NULL && var_valid_name(item->words[0], eq - item->words[0])) {
+            continue;
+        }
+        for (i = 0; setup_commands[i] != NULL; i++) {
+            if (strcmp(item->words[0], setup_commands[i]) == 0) {
+                break;
+            }
+        }
+        if (setup_commands[i] == NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ========== 日志 ========== */
+
+/**
+ * journal_open - 开启批处理日志
+ *
+ * 功能：resume 为 0 时清空日志重新记录；为 1 时先读入已完成的命令并
+ *       压缩日志，新的记录追加在后面
+ * 参数：path - 日志文件路径，resume - 是否从日志恢复
+ * 返回：0 表示成功，-1 表示失败
+ */
+int journal_open(const char *path, int resume) {
+    struct stat st;
+
+    if (resume && (journal_load(path) < 0 || journal_compact(path) < 0)) {
+        return -1;
+    }
+
+    journal_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC |
+                      (resume ? 0 : O_TRUNC), 0644);
+    if (journal_fd < 0) {
+        fprintf(stderr, "myshell: 无法打开日志 '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (fstat(journal_fd, &st) == 0 && st.st_size == 0 &&
+        write(journal_fd, JOURNAL_HEADER, strlen(JOURNAL_HEADER)) < 0) {
+        perror("myshell: journal");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &last_sync);
+    return 0;
+}
+
+/**
+ * journal_active - 判断是否开启了批处理日志
+ *
+ * 返回：1 表示开启，0 表示没有
+ */
+int journal_active() {
+    return journal_fd >= 0;
+}
+
+/**
+ * journal_skip - 判断命令是否已在上次运行中成功完成
+ *
+ * 参数：offset - 命令在批处理文件中的偏移，text - 命令文本，tree - 解析后的命令
+ * 返回：1 表示应跳过，0 表示需要执行
+ */
+int journal_skip(long long offset, const char *text, Node *tree) {
+    Done key;
+
+    if (done_count == 0 || is_setup(tree)) {
+        return 0;
+    }
+    key.offset = offset;
+    key.hash = journal_hash(text);
+    if (bsearch(&key, done, done_count, sizeof(Done), compare_done) == NULL) {
+        return 0;
+    }
+    skipped++;
+    return 1;
+}
+
+/**
+ * journal_record - 记录一条已执行的命令
+ *
+ * 功能：记录立即写入日志；累计 JOURNAL_SYNC_ENTRIES 条或距上次同步
+ *       超过 JOURNAL_SYNC_MS 毫秒时同步到磁盘。写入失败时停止记录。
+ *       恢复时总是重新执行的命令再次成功时，日志中已有它的记录，不再追加
+ * 参数：offset - 命令在批处理文件中的偏移，text - 命令文本，
+ *       status - 退出状态，elapsed_ms - 耗时（毫秒）
+ */
+void journal_record(long long offset, const char *text, int status, long long elapsed_ms) {
+    char entry[128];
+    struct timespec now;
+    Done key;
+    int len;
+
+    if (journal_fd < 0) {
+        return;
+    }
+
+    key.offset = offset;
+    key.hash = journal_hash(text);
+    if (status == 0 && done_count > 0 &&
+        bsearch(&key, done, done_count, sizeof(Done), compare_done) != NULL) {
+        return;
+    }
+
+    len = snprintf(entry, sizeof(entry), "%lld %016llx %d %lld\n",
+                   offset, key.hash, status, elapsed_ms);
+    if (write(journal_fd, entry, len) != len) {
+        perror("myshell: journal");
+        close(journal_fd);
+        journal_fd = -1;
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (++unsynced >= JOURNAL_SYNC_ENTRIES ||
+        (now.tv_sec - last_sync.tv_sec) * 1000LL +
+        (now.tv_nsec - last_sync.tv_nsec) / 1000000 >= JOURNAL_SYNC_MS) {
+        fdatasync(journal_fd);
+        unsynced = 0;
+        last_sync = now;
+    }
+}
+
+/**
+ * journal_close - 同步并关闭日志
+ *
+ * 功能：恢复运行时报告跳过的命令数
+ */
+void journal_close() {
+    if (journal_fd < 0) {
+        return;
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "myshell: 从日志恢复，跳过了 %d 条已完成的命令\n", skipped);
+    }
+    fdatasync(journal_fd);
+    close(journal_fd);
+    journal_fd = -1;
+    free(done);
+    done = NULL;
+    done_count = 0;
+}
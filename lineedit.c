@@ -0,0 +1,808 @@
+/*
+ * lineedit.c - MyShell 行编辑器
+ *
+ * 功能：交互模式下在终端原始模式中读取命令行，支持光标移动、
+ *       删除与粘贴（kill/yank）、历史浏览和 Ctrl-R 增量反向搜索。
+ *       每次刷新都先在内存中拼好整屏内容，再用一次 write 输出
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <termios.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+
+/* 控制键编码 */
+#define CTRL_KEY(c) ((c) & 0x1f)
+
+/* 方向键等转义序列解码后的键值（不与普通字节冲突） */
+#define KEY_LEFT   1000
+#define KEY_RIGHT  1001
+#define KEY_UP     1002
+#define KEY_DOWN   1003
+#define KEY_HOME   1004
+#define KEY_END    1005
+#define KEY_DELETE 1006
+#define KEY_WORD_LEFT  1007
+#define KEY_WORD_RIGHT 1008
+#define KEY_ESCAPE 1009
+
+/**
+ * LineState 结构体 - 一次行编辑的状态
+ *
+ * 字段说明：
+ *   buf           - 编辑中的内容（UTF-8）
+ *   len           - 内容字节数
+ *   pos           - 光标所在的字节偏移
+ *   prompt        - 提示符
+ *   prompt_width  - 提示符的显示宽度
+ *   cols          - 终端列数
+ *   cursor_row    - 上次刷新后光标相对于首行的行号
+ *   history_index - 正在浏览的历史序号，等于历史数量时表示当前编辑行
+ *   saved         - 开始浏览历史前正在编辑的内容
+ */
+typedef struct {
+    char buf[MAX_LINE];
+    int len;
+    int pos;
+    const char *prompt;
+    int prompt_width;
+    int cols;
+    int cursor_row;
+    int history_index;
+    char saved[MAX_LINE];
+} LineState;
+
+/* 进入原始模式前的终端设置 */
+static struct termios saved_termios;
+
+/* 正在编辑的状态，以及编辑行是否已被 line_edit_clear 清除 */
+static LineState *editing = NULL;
+static int edit_cleared = 0;
+
+/* 最近一次删除的内容，Ctrl-Y 粘贴 */
+static char kill_buffer[MAX_LINE] = "";
+
+/* ========== UTF-8 与显示宽度 ========== */
+
+/**
+ * utf8_decode - 解码一个 UTF-8 字符
+ *
+ * 参数：s - 字符起始位置，len - 剩余字节数，cp - 输出参数，码点
+ * 返回：该字符占用的字节数（非法序列按 1 字节处理）
+ */
+static int utf8_decode(const char *s, int len, unsigned int *cp) {
+    unsigned char c = (unsigned char)s[0];
+    int n, i;
+
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    } else if ((c & 0xe0) == 0xc0) {
+        n = 2;
+        *cp = c & 0x1f;
+    } else if ((c & 0xf0) == 0xe0) {
+        n = 3;
+        *cp = c & 0x0f;
+    } else if ((c & 0xf8) == 0xf0) {
+        n = 4;
+        *cp = c & 0x07;
+    } else {
+        *cp = c;
+        return 1;
+    }
+
+    if (n > len) {
+        *cp = c;
+        return 1;
+    }
+    for (i = 1; i < n; i++) {
+        if (((unsigned char)s[i] & 0xc0) != 0x80) {
+            *cp = c;
+            return 1;
+        }
+        *cp = (*cp << 6) | ((unsigned char)s[i] & 0x3f);
+    }
+    return n;
+}
+
+/**
+ * char_width - 计算码点的显示宽度
+ *
+ * 功能：中日韩文字、全角符号和常见表情按 2 列计算，其余按 1 列
+ * 参数：cp - 码点
+ * 返回：显示宽度
+ */
+static int char_width(unsigned int cp) {
+    if (cp >= 0x0300 && cp <= 0x036f) {
+        return 0;   /* 组合附加符号 */
+    }
+    if ((cp >= 0x1100 && cp <= 0x115f) ||
+        (cp >= 0x2e80 && cp <= 0xa4cf && cp != 0x303f) ||
+        (cp >= 0xac00 && cp <= 0xd7a3) ||
+        (cp >= 0xf900 && cp <= 0xfaff) ||
+        (cp >= 0xfe30 && cp <= 0xfe6f) ||
+        (cp >= 0xff00 && cp <= 0xff60) ||
+        (cp >= 0xffe0 && cp <= 0xffe6) ||
+        (cp >= 0x1f300 && cp <= 0x1f64f) ||
+        (cp >= 0x1f900 && cp <= 0x1f9ff) ||
+        (cp >= 0x20000 && cp <= 0x3fffd)) {
+        return 2;
+    }
+    return 1;
+}
+
+/**
+ * str_width - 计算字符串的显示宽度
+ *
+ * 功能：跳过 ANSI 转义序列（提示符中可能包含颜色）
+ * 参数：s - 字符串，len - 字节数
+ * 返回：显示宽度
+ */
+static int str_width(const char *s, int len) {
+    unsigned int cp;
+    int width = 0;
+    int i = 0;
+
+    while (i < len) {
+        if (s[i] == '\033' && i + 1 < len && s[i + 1] == '[') {
+            /* CSI 序列以 0x40-0x7e 范围内的字节结束 */
+            i += 2;
+            while (i < len && (s[i] < 0x40 || s[i] > 0x7e)) {
+                i++;
+            }
+            i++;
+            continue;
+        }
+        i += utf8_decode(s + i, len - i, &cp);
+        width += char_width(cp);
+    }
+    return width;
+}
+
+/**
+ * prev_char - 计算前一个字符的起始偏移
+ *
+ * 参数：ls - 编辑状态，pos - 当前偏移
+ * 返回：前一个字符的起始偏移
+ */
+static int prev_char(LineState *ls, int pos) {
+    if (pos > 0) {
+        pos--;
+        while (pos > 0 && ((unsigned char)ls->buf[pos] & 0xc0) == 0x80) {
+            pos--;
+        }
+    }
+    return pos;
+}
+
+/**
+ * next_char - 计算后一个字符的起始偏移
+ *
+ * 参数：ls - 编辑状态，pos - 当前偏移
+ * 返回：后一个字符的起始偏移
+ */
+static int next_char(LineState *ls, int pos) {
+    if (pos < ls->len) {
+        pos++;
+        while (pos < ls->len && ((unsigned char)ls->buf[pos] & 0xc0) == 0x80) {
+            pos++;
+        }
+    }
+    return pos;
+}
+
+/* ========== 终端控制 ========== */
+
+/**
+ * enable_raw_mode - 进入原始模式
+ *
+ * 功能：关闭回显、行缓冲和信号键，由编辑器自行处理 Ctrl-C 等按键
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int enable_raw_mode() {
+    struct termios raw;
+
+    if (tcgetattr(STDIN_FILENO, &saved_termios) < 0) {
+        return -1;
+    }
+
+    raw = saved_termios;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+
+    /* TCSADRAIN 不丢弃已输入（例如粘贴）的内容 */
+    return tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+}
+
+/**
+ * disable_raw_mode - 恢复进入原始模式前的终端设置
+ */
+static void disable_raw_mode() {
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &saved_termios);
+}
+
+/**
+ * terminal_columns - 获取终端列数
+ *
+ * 返回：列数，无法获取时返回 80
+ */
+static int terminal_columns() {
+    struct winsize ws;
+
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0 || ws.ws_col == 0) {
+        return 80;
+    }
+    return ws.ws_col;
+}
+
+/**
+ * write_all - 完整写出缓冲区
+ *
+ * 参数：buf - 数据，len - 长度
+ */
+static void write_all(const char *buf, size_t len) {
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(STDOUT_FILENO, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+/**
+ * read_key - 读取一个按键
+ *
+ * 功能：把方向键等转义序列解码为 KEY_* 键值
+ * 返回：键值，读取失败或输入结束返回 -1
+ */
+static int read_key() {
+    char c, seq[3];
+
+    if (read(STDIN_FILENO, &c, 1) != 1) {
+        return -1;
+    }
+    if (c != '\033') {
+        return (unsigned char)c;
+    }
+
+    if (read(STDIN_FILENO, &seq[0], 1) != 1) {
+        return KEY_ESCAPE;
+    }
+    if (seq[0] == 'b') {
+        return KEY_WORD_LEFT;      /* Alt-b */
+    }
+    if (seq[0] == 'f') {
+        return KEY_WORD_RIGHT;     /* Alt-f */
+    }
+    if (seq[0] != '[' && seq[0] != 'O') {
+        return KEY_ESCAPE;
+    }
+    if (read(STDIN_FILENO, &seq[1], 1) != 1) {
+        return KEY_ESCAPE;
+    }
+
+    if (seq[1] >= '0' && seq[1] <= '9') {
+        /* 形如 ESC [ 3 ~ 的扩展序列 */
+        if (read(STDIN_FILENO, &seq[2], 1) != 1 || seq[2] != '~') {
+            return KEY_ESCAPE;
+        }
+        switch (seq[1]) {
+        case '1':
+        case '7':
+            return KEY_HOME;
+        case '3':
+            return KEY_DELETE;
+        case '4':
+        case '8':
+            return KEY_END;
+        }
+        return KEY_ESCAPE;
+    }
+
+    switch (seq[1]) {
+    case 'A':
+        return KEY_UP;
+    case 'B':
+        return KEY_DOWN;
+    case 'C':
+        return KEY_RIGHT;
+    case 'D':
+        return KEY_LEFT;
+    case 'H':
+        return KEY_HOME;
+    case 'F':
+        return KEY_END;
+    }
+    return KEY_ESCAPE;
+}
+
+/* ========== 编辑操作 ========== */
+
+/**
+ * refresh_line - 重绘提示符和编辑内容
+ *
+ * 功能：支持超过一行的内容：先回到上次绘制的首行，清除到屏幕末尾，
+ *       重新输出，再把光标移到对应位置。所有输出合并为一次 write
+ * 参数：ls - 编辑状态
+ */
+static void refresh_line(LineState *ls) {
+    char out[MAX_LINE * 2 + 256];
+    int len = 0;
+    int total, cursor, end_row, row;
+    int plen = strlen(ls->prompt);
+
+    ls->cols = terminal_columns();
+    total = ls->prompt_width + str_width(ls->buf, ls->len);
+    cursor = ls->prompt_width + str_width(ls->buf, ls->pos);
+
+    /* 回到首行行首并清除旧内容 */
+    if (ls->cursor_row > 0) {
+        len += snprintf(out + len, sizeof(out) - len, "\033[%dA", ls->cursor_row);
+    }
+    len += snprintf(out + len, sizeof(out) - len, "\r\033[J");
+
+    /* 输出提示符和内容 */
+    if (plen > (int)sizeof(out) - len - 64) {
+        plen = sizeof(out) - len - 64;
+    }
+    memcpy(out + len, ls->prompt, plen);
+    len += plen;
+    memcpy(out + len, ls->buf, ls->len);
+    len += ls->len;
+
+    /* 内容恰好写满一行时终端光标停在行尾，手动换行 */
+    if (total > 0 && total % ls->cols == 0) {
+        len += snprintf(out + len, sizeof(out) - len, "\r\n");
+    }
+    end_row = total / ls->cols;
+
+    /* 从末尾移动到光标所在位置 */
+    row = cursor / ls->cols;
+    if (end_row > row) {
+        len += snprintf(out + len, sizeof(out) - len, "\033[%dA", end_row - row);
+    }
+    len += snprintf(out + len, sizeof(out) - len, "\r");
+    if (cursor % ls->cols > 0) {
+        len += snprintf(out + len, sizeof(out) - len, "\033[%dC", cursor % ls->cols);
+    }
+    ls->cursor_row = row;
+
+    write_all(out, len);
+}
+
+/**
+ * set_line - 用指定内容替换编辑内容，光标移到末尾
+ *
+ * 参数：ls - 编辑状态，text - 新内容，len - 长度
+ */
+static void set_line(LineState *ls, const char *text, int len) {
+    if (len > MAX_LINE - 1) {
+        len = MAX_LINE - 1;
+    }
+    memcpy(ls->buf, text, len);
+    ls->buf[len] = '\0';
+    ls->len = len;
+    ls->pos = len;
+}
+
+/**
+ * insert_text - 在光标处插入文本
+ *
+ * 参数：ls - 编辑状态，text - 文本，len - 长度
+ */
+static void insert_text(LineState *ls, const char *text, int len) {
+    if (ls->len + len > MAX_LINE - 1) {
+        return;
+    }
+    memmove(ls->buf + ls->pos + len, ls->buf + ls->pos, ls->len - ls->pos + 1);
+    memcpy(ls->buf + ls->pos, text, len);
+    ls->pos += len;
+    ls->len += len;
+}
+
+/**
+ * delete_range - 删除 [from, to) 范围的内容
+ *
+ * 参数：ls - 编辑状态，from - 起始偏移，to - 结束偏移，save - 是否存入 kill 缓冲区
+ */
+static void delete_range(LineState *ls, int from, int to, int save) {
+    if (from >= to) {
+        return;
+    }
+    if (save) {
+        memcpy(kill_buffer, ls->buf + from, to - from);
+        kill_buffer[to - from] = '\0';
+    }
+    memmove(ls->buf + from, ls->buf + to, ls->len - to + 1);
+    ls->len -= to - from;
+    ls->pos = from;
+}
+
+/**
+ * word_left - 计算光标左侧一个单词的起始偏移
+ *
+ * 参数：ls - 编辑状态
+ * 返回：偏移
+ */
+static int word_left(LineState *ls) {
+    int pos = ls->pos;
+
+    while (pos > 0 && ls->buf[pos - 1] == ' ') {
+        pos--;
+    }
+    while (pos > 0 && ls->buf[pos - 1] != ' ') {
+        pos--;
+    }
+    return pos;
+}
+
+/**
+ * word_right - 计算光标右侧一个单词的结束偏移
+ *
+ * 参数：ls - 编辑状态
+ * 返回：偏移
+ */
+static int word_right(LineState *ls) {
+    int pos = ls->pos;
+
+    while (pos < ls->len && ls->buf[pos] == ' ') {
+        pos++;
+    }
+    while (pos < ls->len && ls->buf[pos] != ' ') {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * history_step - 浏览上一条或下一条历史
+ *
+ * 参数：ls - 编辑状态，dir - -1 表示更早，1 表示更新
+ */
+static void history_step(LineState *ls, int dir) {
+    const char *text;
+    int count = history_count();
+    int index = ls->history_index + dir;
+    int len;
+
+    if (index < 0 || index > count) {
+        return;
+    }
+
+    /* 离开当前编辑行时先保存 */
+    if (ls->history_index == count) {
+        memcpy(ls->saved, ls->buf, ls->len + 1);
+    }
+    ls->history_index = index;
+
+    if (index == count) {
+        set_line(ls, ls->saved, strlen(ls->saved));
+    } else {
+        text = history_get(index, &len);
+        set_line(ls, text, len);
+    }
+}
+
+/**
+ * reverse_search - Ctrl-R 增量反向搜索
+ *
+ * 功能：每输入一个字符就从当前匹配处继续向前搜索；再按 Ctrl-R 查找
+ *       更早的匹配；Ctrl-G 取消并恢复原内容；其他按键接受当前匹配，
+ *       并交回给主循环处理（例如回车直接执行）
+ * 参数：ls - 编辑状态
+ * 返回：结束搜索的按键，取消时返回 0
+ */
+static int reverse_search(LineState *ls) {
+    char query[128] = "";
+    char search_prompt[192];
+    char original[MAX_LINE];
+    const char *saved_prompt = ls->prompt;
+    int saved_width = ls->prompt_width;
+    int original_len = ls->len;
+    int qlen = 0;
+    int match = history_count();
+    int found, len, key;
+    const char *text, *hit;
+
+    memcpy(original, ls->buf, ls->len + 1);
+
+    while (1) {
+        snprintf(search_prompt, sizeof(search_prompt),
+                 "(reverse-i-search)`%s': ", query);
+        ls->prompt = search_prompt;
+        ls->prompt_width = str_width(search_prompt, strlen(search_prompt));
+        refresh_line(ls);
+
+        key = read_key();
+        if (key == CTRL_KEY('r')) {
+            /* 继续查找更早的匹配 */
+            found = qlen > 0 ? history_search(query, match - 1) : -1;
+        } else if (key == 127 || key == CTRL_KEY('h')) {
+            if (qlen == 0) {
+                continue;
+            }
+            query[--qlen] = '\0';
+            found = qlen > 0 ? history_search(query, history_count() - 1) : -1;
+        } else if (key >= 32 && key < 256) {
+            if (qlen < (int)sizeof(query) - 1) {
+                query[qlen++] = (char)key;
+                query[qlen] = '\0';
+            }
+            found = history_search(query, match < history_count() ? match
+                                                                : history_count() - 1);
+        } else {
+            break;
+        }
+
+        if (found >= 0) {
+            match = found;
+            text = history_get(match, &len);
+            set_line(ls, text, len);
+            hit = memmem(ls->buf, ls->len, query, qlen);
+            ls->pos = hit ? (int)(hit - ls->buf) : ls->len;
+        }
+    }
+
+    ls->prompt = saved_prompt;
+    ls->prompt_width = saved_width;
+
+    if (key == CTRL_KEY('g') || key == CTRL_KEY('c')) {
+        set_line(ls, original, original_len);
+        refresh_line(ls);
+        return 0;
+    }
+    refresh_line(ls);
+    return key == KEY_ESCAPE ? 0 : key;
+}
+
+/**
+ * line_edit_clear - 清除正在编辑的命令行
+ *
+ * 功能：回到编辑区域的首行并清除到屏幕末尾，之后的输出从行首开始；
+ *       input_wait 在输出结束后重绘
+ */
+void line_edit_clear() {
+    char out[32];
+    int len = 0;
+
+    if (editing == NULL || edit_cleared) {
+        return;
+    }
+    if (editing->cursor_row > 0) {
+        len += snprintf(out + len, sizeof(out) - len, "\033[%dA", editing->cursor_row);
+    }
+    len += snprintf(out + len, sizeof(out) - len, "\r\033[J");
+    write_all(out, len);
+    editing->cursor_row = 0;
+    edit_cleared = 1;
+}
+
+/**
+ * input_wait - 等待按键，同时转发后台作业的输出
+ *
+ * 功能：jobout 开启时后台作业的输出经过 shell，等待按键期间也要读出，
+ *       否则作业会因管道写满而停下。输出清除了编辑行时重绘
+ * 参数：ls - 编辑状态
+ */
+static void input_wait(LineState *ls) {
+    struct pollfd pfd[2];
+
+    pfd[0].fd = STDIN_FILENO;
+    pfd[0].events = POLLIN;
+    pfd[1].events = POLLIN;
+
+    while ((pfd[1].fd = mux_fd()) >= 0) {
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (pfd[0].revents != 0) {
+            return;
+        }
+        if (pfd[1].revents != 0) {
+            mux_poll(0);
+            if (edit_cleared) {
+                edit_cleared = 0;
+                refresh_line(ls);
+            }
+        }
+    }
+}
+
+/**
+ * edit_loop - 行编辑主循环
+ *
+ * 参数：ls - 编辑状态
+ * 返回：1 表示输入完成，0 表示输入结束（Ctrl-D 或读取失败）
+ */
+static int edit_loop(LineState *ls) {
+    char utf8[4];
+    char insert[MAX_LINE];
+    int key, n, i;
+    int last_key = 0;
+
+    refresh_line(ls);
+
+    while (1) {
+        n = last_key;
+        input_wait(ls);
+        key = last_key = read_key();
+        if (key == CTRL_KEY('r')) {
+            key = reverse_search(ls);
+            if (key == 0) {
+                continue;
+            }
+        }
+
+        switch (key) {
+        case -1:
+            return 0;
+        case '\r':
+        case '\n':
+            /* 光标移到末尾再换行，避免多行内容被覆盖 */
+            ls->pos = ls->len;
+            refresh_line(ls);
+            write_all("\r\n", 2);
+            return 1;
+        case CTRL_KEY('c'):
+            /* 放弃当前行，重新开始 */
+            write_all("^C\r\n", 4);
+            ls->len = ls->pos = 0;
+            ls->buf[0] = '\0';
+            ls->cursor_row = 0;
+            ls->history_index = history_count();
+            break;
+        case CTRL_KEY('d'):
+            if (ls->len == 0) {
+                write_all("\r\n", 2);
+                return 0;
+            }
+            delete_range(ls, ls->pos, next_char(ls, ls->pos), 0);
+            break;
+        case 127:
+        case CTRL_KEY('h'):
+            delete_range(ls, prev_char(ls, ls->pos), ls->pos, 0);
+            break;
+        case KEY_DELETE:
+            delete_range(ls, ls->pos, next_char(ls, ls->pos), 0);
+            break;
+        case KEY_LEFT:
+        case CTRL_KEY('b'):
+            ls->pos = prev_char(ls, ls->pos);
+            break;
+        case KEY_RIGHT:
+        case CTRL_KEY('f'):
+            ls->pos = next_char(ls, ls->pos);
+            break;
+        case KEY_HOME:
+        case CTRL_KEY('a'):
+            ls->pos = 0;
+            break;
+        case KEY_END:
+        case CTRL_KEY('e'):
+            ls->pos = ls->len;
+            break;
+        case KEY_WORD_LEFT:
+            ls->pos = word_left(ls);
+            break;
+        case KEY_WORD_RIGHT:
+            ls->pos = word_right(ls);
+            break;
+        case KEY_UP:
+        case CTRL_KEY('p'):
+            history_step(ls, -1);
+            break;
+        case KEY_DOWN:
+        case CTRL_KEY('n'):
+            history_step(ls, 1);
+            break;
+        case CTRL_KEY('k'):
+            delete_range(ls, ls->pos, ls->len, 1);
+            break;
+        case CTRL_KEY('u'):
+            delete_range(ls, 0, ls->pos, 1);
+            break;
+        case CTRL_KEY('w'):
+            delete_range(ls, word_left(ls), ls->pos, 1);
+            break;
+        case CTRL_KEY('y'):
+            insert_text(ls, kill_buffer, strlen(kill_buffer));
+            break;
+        case CTRL_KEY('l'):
+            write_all("\033[H\033[2J", 7);
+            ls->cursor_row = 0;
+            break;
+        case '\t':
+            /* 补全公共前缀；无可补全内容时，连按两次列出全部候选 */
+            if (complete_word(ls->buf, ls->pos, insert, sizeof(insert)) > 1 &&
+                insert[0] == '\0' && n == '\t') {
+                i = ls->pos;
+                ls->pos = ls->len;
+                refresh_line(ls);
+                ls->pos = i;
+                complete_list(ls->buf, ls->pos, terminal_columns());
+                ls->cursor_row = 0;
+                last_key = 0;
+            } else {
+                insert_text(ls, insert, strlen(insert));
+            }
+            break;
+        default:
+            if (key < 32 || key >= 256) {
+                break;
+            }
+            /* 多字节 UTF-8 字符整体插入 */
+            utf8[0] = (char)key;
+            n = 1;
+            if ((key & 0xe0) == 0xc0) {
+                n = 2;
+            } else if ((key & 0xf0) == 0xe0) {
+                n = 3;
+            } else if ((key & 0xf8) == 0xf0) {
+                n = 4;
+            }
+            for (i = 1; i < n; i++) {
+                if (read(STDIN_FILENO, &utf8[i], 1) != 1) {
+                    return 0;
+                }
+            }
+            insert_text(ls, utf8, n);
+            break;
+        }
+
+        refresh_line(ls);
+    }
+}
+
+/**
+ * line_edit - 读取一行交互输入
+ *
+ * 功能：在原始模式下编辑一行，返回前恢复终端设置。
+ *       首次调用时加载历史文件
+ * 参数：prompt - 提示符
+ * 返回：命令字符串指针（静态缓冲区），输入结束返回 NULL
+ */
+char* line_edit(const char *prompt) {
+    static LineState ls;
+    int ok;
+
+    history_load();
+
+    ls.len = 0;
+    ls.pos = 0;
+    ls.buf[0] = '\0';
+    ls.prompt = prompt;
+    ls.prompt_width = str_width(prompt, strlen(prompt));
+    ls.cursor_row = 0;
+    ls.history_index = history_count();
+    ls.saved[0] = '\0';
+
+    fflush(stdout);
+    if (enable_raw_mode() < 0) {
+        /* 无法进入原始模式，退化为普通读取 */
+        write_all(prompt, strlen(prompt));
+        return read_command(stdin);
+    }
+
+    editing = &ls;
+    edit_cleared = 0;
+    ok = edit_loop(&ls);
+    editing = NULL;
+    disable_raw_mode();
+
+    return ok ? ls.buf : NULL;
+}
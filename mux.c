@@ -0,0 +1,680 @@
+/*
+ * mux.c - MyShell 后台作业输出汇集
+ *
+ * 功能：jobout line 或 jobout group 开启后，后台作业的标准输出和标准错误
+ *       不再直接写终端，而是写入 shell 持有的管道。shell 用一个 epoll 实例
+ *       监听所有管道，读入每个作业各自的环形缓冲区，再按方式输出：
+ *         line  - 每读到完整的一行就输出，行首加作业号 "[1] "
+ *         group - 作业的输出集中在一起，作业结束时整块输出
+ *       缓冲区大小固定。group 方式下缓冲区写满的作业成为"当前作业"，
+ *       输出直接转发；已有当前作业时，其他写满的作业停止读取，
+ *       作业因管道写满而等待（背压），不会无限占用内存
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/epoll.h>
+#include <sys/uio.h>
+
+/* 输出方式 */
+#define MUX_OFF     0   /* 作业直接写终端 */
+#define MUX_LINE    1   /* 逐行输出，加作业号前缀 */
+#define MUX_GROUP   2   /* 按作业集中输出 */
+
+/* 每个作业每个输出流的环形缓冲区大小（2 的幂） */
+#define MUX_RING_SIZE (64 * 1024)
+
+struct Output;
+
+/**
+ * Stream 结构体 - 作业的一个输出流（标准输出或标准错误）
+ *
+ * 字段说明：
+ *   fd      - 管道读端，-1 表示已读到文件结束
+ *   target  - 转发的目标描述符
+ *   data    - 环形缓冲区
+ *   head    - 缓冲区中第一个字节的位置
+ *   len     - 缓冲区中的字节数
+ *   paused  - 缓冲区已满，暂时不再读取（已从 epoll 中移除）
+ *   output  - 所属的作业输出
+ */
+typedef struct {
+    int fd;
+    int target;
+    char *data;
+    size_t head;
+    size_t len;
+    int paused;
+    struct Output *output;
+} Stream;
+
+/**
+ * Output 结构体 - 一个后台作业的输出
+ *
+ * 字段说明：
+ *   id       - 作业号
+ *   mode     - 输出方式（MUX_LINE 或 MUX_GROUP），作业启动时确定
+ *   cmdline  - 命令行，group 方式下作为标题
+ *   ended    - 作业已结束（已报告完成或已从作业表删除）
+ *   trailer  - 输出之后显示的作业完成信息
+ *   streams  - 标准输出和标准错误
+ *   next     - 下一个作业（按启动顺序）
+ */
+typedef struct Output {
+    int id;
+    int mode;
+    char *cmdline;
+    int ended;
+    char *trailer;
+    Stream streams[2];
+    struct Output *next;
+} Output;
+
+/* 之后启动的作业的输出方式，由 jobout 命令设置 */
+static int mux_mode = MUX_OFF;
+
+/* 监听所有管道读端的 epoll 实例，-1 表示尚未创建 */
+static int mux_epoll_fd = -1;
+
+/* 尚未结束的作业输出，按启动顺序排列 */
+static Output *outputs = NULL;
+
+/* group 方式下正在直接转发的作业 */
+static Output *current = NULL;
+
+/* ========== 环形缓冲区 ========== */
+
+/**
+ * ring_fill - 从管道读入数据，填充缓冲区的空闲部分
+ *
+ * 功能：空闲部分可能跨过缓冲区末尾，用 readv 一次读入两段
+ * 返回：读入的字节数，0 表示文件结束，-1 表示失败或暂无数据（errno）
+ */
+static ssize_t ring_fill(Stream *s) {
+    struct iovec iov[2];
+    size_t tail = (s->head + s->len) & (MUX_RING_SIZE - 1);
+    size_t space = MUX_RING_SIZE - s->len;
+    size_t first = MUX_RING_SIZE - tail < space ? MUX_RING_SIZE - tail : space;
+    ssize_t n;
+
+    iov[0].iov_base = s->data + tail;
+    iov[0].iov_len = first;
+    iov[1].iov_base = s->data;
+    iov[1].iov_len = space - first;
+
+    do {
+        n = readv(s->fd, iov, space > first ? 2 : 1);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0) {
+        s->len += n;
+    }
+    return n;
+}
+
+/**
+ * ring_line - 查找缓冲区中第一行的长度
+ *
+ * 返回：包括换行符在内的长度，没有完整的行返回 0
+ */
+static size_t ring_line(Stream *s) {
+    size_t i;
+
+    for (i = 0; i < s->len; i++) {
+        if (s->data[(s->head + i) & (MUX_RING_SIZE - 1)] == '\n') {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * mux_write - 把数据写到终端
+ *
+ * 功能：先输出 shell 自己缓冲的内容，并清除正在编辑的命令行
+ *       （行编辑器在下一次等待按键时重绘）
+ */
+static void mux_write(int fd, const struct iovec *iov, int count) {
+    const char *data;
+    size_t len;
+    ssize_t n;
+    int i;
+
+    fflush(stdout);
+    line_edit_clear();
+
+    for (i = 0; i < count; i++) {
+        data = iov[i].iov_base;
+        len = iov[i].iov_len;
+        while (len > 0) {
+            n = write(fd, data, len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += n;
+            len -= n;
+        }
+    }
+}
+
+/**
+ * ring_emit - 输出缓冲区开头的 n 个字节
+ *
+ * 参数：s - 输出流，n - 字节数，prefix - 行首前缀（可为 NULL），
+ *       newline - 是否在末尾补一个换行符
+ */
+static void ring_emit(Stream *s, size_t n, const char *prefix, int newline) {
+    struct iovec iov[4];
+    size_t first = MUX_RING_SIZE - s->head < n ? MUX_RING_SIZE - s->head : n;
+    int count = 0;
+
+    if (n == 0) {
+        return;
+    }
+    if (prefix != NULL) {
+        iov[count].iov_base = (void *)prefix;
+        iov[count++].iov_len = strlen(prefix);
+    }
+    iov[count].iov_base = s->data + s->head;
+    iov[count++].iov_len = first;
+    if (n > first) {
+        iov[count].iov_base = s->data;
+        iov[count++].iov_len = n - first;
+    }
+    if (newline) {
+        iov[count].iov_base = "\n";
+        iov[count++].iov_len = 1;
+    }
+    mux_write(s->target, iov, count);
+
+    s->head = (s->head + n) & (MUX_RING_SIZE - 1);
+    s->len -= n;
+}
+
+/* ========== 作业输出 ========== */
+
+/**
+ * output_free - 关闭管道并释放作业输出
+ */
+static void output_free(Output *out) {
+    Output **p;
+    int i;
+
+    for (p = &outputs; *p != NULL; p = &(*p)->next) {
+        if (*p == out) {
+            *p = out->next;
+            break;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        if (out->streams[i].fd >= 0) {
+            close(out->streams[i].fd);
+        }
+        free(out->streams[i].data);
+    }
+    if (current == out) {
+        current = NULL;
+    }
+    free(out->trailer);
+    free(out->cmdline);
+    free(out);
+}
+
+/**
+ * output_emit - 按输出方式转发缓冲区中可以输出的内容
+ *
+ * 功能：line 方式输出完整的行；缓冲区满了仍没有换行，或流已结束时，
+ *       剩余部分也作为一行输出。group 方式只有当前作业直接转发，
+ *       其他作业的内容留在缓冲区中
+ * 参数：out - 作业输出，s - 输出流
+ */
+static void output_emit(Output *out, Stream *s) {
+    char prefix[32];
+    size_t n;
+
+    if (out->mode == MUX_LINE) {
+        snprintf(prefix, sizeof(prefix), "[%d] ", out->id);
+        while ((n = ring_line(s)) > 0) {
+            ring_emit(s, n, prefix, 0);
+        }
+        if (s->len == MUX_RING_SIZE || (s->fd < 0 && s->len > 0)) {
+            ring_emit(s, s->len, prefix, 1);
+        }
+    } else if (current == out) {
+        ring_emit(s, s->len, NULL, 0);
+    }
+}
+
+/**
+ * output_flush - 输出作业缓冲区中的全部内容
+ *
+ * 功能：group 方式先输出标题，再依次输出标准输出和标准错误
+ */
+static void output_flush(Output *out) {
+    char header[MAX_LINE + 64];
+    struct iovec iov;
+    int i;
+
+    if (out->mode == MUX_GROUP && current != out &&
+        out->streams[0].len + out->streams[1].len > 0) {
+        iov.iov_base = header;
+        iov.iov_len = snprintf(header, sizeof(header), "==> [%d] %s <==\n",
+                               out->id, out->cmdline);
+        if (iov.iov_len >= sizeof(header)) {
+            iov.iov_len = sizeof(header) - 1;
+        }
+        mux_write(STDOUT_FILENO, &iov, 1);
+    }
+    for (i = 0; i < 2; i++) {
+        if (out->mode == MUX_LINE) {
+            output_emit(out, &out->streams[i]);
+        } else {
+            ring_emit(&out->streams[i], out->streams[i].len, NULL, 0);
+        }
+    }
+    if (out->trailer != NULL) {
+        iov.iov_base = out->trailer;
+        iov.iov_len = strlen(out->trailer);
+        mux_write(STDOUT_FILENO, &iov, 1);
+    }
+}
+
+/**
+ * stream_resume - 重新开始读取暂停的流
+ */
+static void stream_resume(Stream *s) {
+    struct epoll_event ev;
+
+    if (!s->paused) {
+        return;
+    }
+    s->paused = 0;
+    ev.events = EPOLLIN;
+    ev.data.ptr = s;
+    epoll_ctl(mux_epoll_fd, EPOLL_CTL_ADD, s->fd, &ev);
+}
+
+/**
+ * output_take - 让作业成为 group 方式的当前作业
+ *
+ * 功能：输出标题和已缓冲的内容，之后的输出直接转发；恢复读取暂停的流
+ */
+static void output_take(Output *out) {
+    output_flush(out);
+    current = out;
+    stream_resume(&out->streams[0]);
+    stream_resume(&out->streams[1]);
+}
+
+/**
+ * output_finished - 判断作业的输出是否已全部读到
+ *
+ * 功能：两个流都已结束并且作业已结束。作业结束后才输出，
+ *       作业完成信息总是跟在它的输出之后
+ */
+static int output_finished(Output *out) {
+    return out->ended && out->streams[0].fd < 0 && out->streams[1].fd < 0;
+}
+
+/**
+ * output_next - 输出已结束的作业，选出下一个当前作业
+ *
+ * 功能：line 方式的作业结束后输出剩余内容和完成信息。group 方式的作业
+ *       在没有当前作业时，按启动顺序整块输出已结束的作业；遇到缓冲区
+ *       已满的作业时让它成为当前作业，其余 group 作业继续等待
+ */
+static void output_next() {
+    Output *out, *next;
+
+    if (current != NULL && output_finished(current)) {
+        output_flush(current);
+        output_free(current);
+    }
+    for (out = outputs; out != NULL; out = next) {
+        next = out->next;
+        if (out->mode == MUX_GROUP && current != NULL) {
+            continue;
+        }
+        if (output_finished(out)) {
+            output_flush(out);
+            output_free(out);
+        } else if (out->mode == MUX_GROUP &&
+                   (out->streams[0].paused || out->streams[1].paused)) {
+            output_take(out);
+        }
+    }
+}
+
+/**
+ * stream_read - 读出管道中已有的数据并转发
+ *
+ * 功能：读到暂无数据、缓冲区满或文件结束为止。group 方式下缓冲区满时，
+ *       没有当前作业则成为当前作业，否则暂停读取
+ * 参数：s - 输出流
+ */
+static void stream_read(Stream *s) {
+    Output *out = s->output;
+    ssize_t n;
+
+    while (s->fd >= 0 && !s->paused) {
+        if (s->len < MUX_RING_SIZE) {
+            n = ring_fill(s);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n <= 0) {
+                /* 文件结束：关闭描述符也会把它从 epoll 中移除 */
+                close(s->fd);
+                s->fd = -1;
+            }
+        }
+        output_emit(out, s);
+
+        if (out->mode == MUX_GROUP && s->fd >= 0 && s->len == MUX_RING_SIZE) {
+            if (current == NULL) {
+                output_take(out);
+            } else if (current != out) {
+                epoll_ctl(mux_epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+                s->paused = 1;
+            }
+        }
+    }
+}
+
+/* ========== 接口 ========== */
+
+/**
+ * mux_pipes - 为后台作业创建输出管道
+ *
+ * 功能：jobout 关闭时不创建。fds[0]、fds[1] 为标准输出管道的读端和写端，
+ *       fds[2]、fds[3] 为标准错误管道的读端和写端；读端为非阻塞
+ * 参数：fds - 输出参数
+ * 返回：1 表示已创建，0 表示不经过 shell（关闭或创建失败）
+ */
+int mux_pipes(int fds[4]) {
+    if (mux_mode == MUX_OFF) {
+        return 0;
+    }
+    if (pipe2(fds, O_CLOEXEC) < 0) {
+        perror("jobout: pipe");
+        return 0;
+    }
+    if (pipe2(fds + 2, O_CLOEXEC) < 0) {
+        perror("jobout: pipe");
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[2], F_SETFL, O_NONBLOCK);
+    return 1;
+}
+
+/**
+ * mux_abort - fork 失败时关闭 mux_pipes 创建的管道
+ *
+ * 参数：fds - mux_pipes 创建的管道
+ */
+void mux_abort(int fds[4]) {
+    close(fds[0]);
+    close(fds[1]);
+    close(fds[2]);
+    close(fds[3]);
+}
+
+/**
+ * mux_child - 在子进程中把标准输出和标准错误接到管道
+ *
+ * 参数：fds - mux_pipes 创建的管道
+ */
+void mux_child(int fds[4]) {
+    dup2(fds[1], STDOUT_FILENO);
+    dup2(fds[3], STDERR_FILENO);
+    mux_abort(fds);
+}
+
+/**
+ * mux_attach - 在 shell 中登记作业的输出管道
+ *
+ * 功能：关闭写端，读端加入 epoll；失败时直接关闭管道（作业写入时收到 SIGPIPE）
+ * 参数：id - 作业号，cmdline - 命令行，fds - mux_pipes 创建的管道
+ */
+void mux_attach(int id, const char *cmdline, int fds[4]) {
+    struct epoll_event ev;
+    Output *out, **tail;
+    int i;
+
+    close(fds[1]);
+    close(fds[3]);
+
+    if (mux_epoll_fd < 0) {
+        mux_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    }
+    out = calloc(1, sizeof(Output));
+    if (out == NULL || mux_epoll_fd < 0 || (out->cmdline = strdup(cmdline)) == NULL) {
+        perror("jobout");
+        free(out);
+        close(fds[0]);
+        close(fds[2]);
+        return;
+    }
+
+    /* 没有作业号（作业表已满）时不会有完成通知，读到文件结束即输出 */
+    out->id = id;
+    out->mode = mux_mode;
+    out->ended = id == 0;
+    for (i = 0; i < 2; i++) {
+        out->streams[i].fd = fds[i * 2];
+        out->streams[i].target = i == 0 ? STDOUT_FILENO : STDERR_FILENO;
+        out->streams[i].output = out;
+        out->streams[i].data = malloc(MUX_RING_SIZE);
+        ev.events = EPOLLIN;
+        ev.data.ptr = &out->streams[i];
+        if (out->streams[i].data == NULL ||
+            epoll_ctl(mux_epoll_fd, EPOLL_CTL_ADD, out->streams[i].fd, &ev) < 0) {
+            perror("jobout");
+            out->streams[i].fd = -1;
+            close(fds[i * 2]);
+        }
+    }
+
+    for (tail = &outputs; *tail != NULL; tail = &(*tail)->next) {
+    }
+    *tail = out;
+}
+
+/**
+ * mux_fd - 获取监听作业输出的 epoll 描述符
+ *
+ * 功能：供等待前台作业、等待按键和回收作业时一并监听
+ * 返回：描述符，没有需要监听的输出时返回 -1
+ */
+int mux_fd() {
+    return outputs != NULL ? mux_epoll_fd : -1;
+}
+
+/**
+ * mux_poll - 读出就绪的作业输出并转发
+ *
+ * 参数：timeout - epoll 超时（毫秒），0 表示立即返回
+ * 返回：处理的事件数
+ */
+int mux_poll(int timeout) {
+    struct epoll_event events[64];
+    int n, i;
+
+    if (outputs == NULL) {
+        return 0;
+    }
+    output_next();
+    do {
+        n = epoll_wait(mux_epoll_fd, events, 64, timeout);
+    } while (n < 0 && errno == EINTR);
+
+    for (i = 0; i < n; i++) {
+        stream_read(events[i].data.ptr);
+    }
+    output_next();
+    return n < 0 ? 0 : n;
+}
+
+/**
+ * mux_drain - 作业结束时读出其管道中剩余的输出
+ *
+ * 功能：在报告作业完成之前调用，使作业的输出出现在完成信息之前
+ * 参数：id - 作业号
+ */
+void mux_drain(int id) {
+    Output *out;
+
+    for (out = outputs; out != NULL; out = out->next) {
+        if (out->id == id && !out->ended) {
+            stream_read(&out->streams[0]);
+            stream_read(&out->streams[1]);
+            return;
+        }
+    }
+}
+
+/**
+ * mux_job_done - 作业结束，之后可以输出它的全部内容
+ *
+ * 功能：作业的输出经过 shell 时，完成信息排在输出之后显示：group 方式下
+ *       不会插入到正在输出的其他作业中间，也不会早于作业自己的输出
+ * 参数：id - 作业号，message - 完成信息（可为 NULL）
+ * 返回：1 表示完成信息已排入，0 表示调用者直接显示
+ */
+int mux_job_done(int id, const char *message) {
+    Output *out;
+    int queued = 0;
+
+    for (out = outputs; out != NULL; out = out->next) {
+        if (out->id == id && !out->ended) {
+            out->ended = 1;
+            if (message != NULL) {
+                out->trailer = strdup(message);
+                queued = out->trailer != NULL;
+            }
+            output_next();
+            break;
+        }
+    }
+    return queued;
+}
+
+/**
+ * mux_relay - 在转发进程中继续转发作业的输出
+ *
+ * 功能：shell 已退出，不会再有完成信息；每个作业读到两个流都结束
+ *       （作业及其子进程都关闭了写端）后输出剩余内容
+ */
+static void mux_relay() {
+    Output *out;
+
+    for (out = outputs; out != NULL; out = out->next) {
+        out->ended = 1;
+    }
+    while (outputs != NULL) {
+        mux_poll(-1);
+    }
+    _exit(0);
+}
+
+/**
+ * mux_shutdown - shell 退出前处理经过 shell 的作业输出
+ *
+ * 功能：先转发已读到的内容。仍有作业在运行时，fork 一个转发进程
+ *       继续读管道直到写端全部关闭，shell 照常退出，作业之后的输出
+ *       与 jobout off 时一样继续出现，不会因读端关闭而丢失或收到 SIGPIPE。
+ *       无法创建转发进程时输出已缓冲的内容后关闭管道
+ */
+void mux_shutdown() {
+    pid_t pid;
+    int i;
+
+    mux_poll(0);
+    if (outputs == NULL) {
+        return;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if (pid == 0) {
+        mux_relay();
+    }
+    if (pid > 0) {
+        /* 管道已交给转发进程，shell 只关闭自己的读端 */
+        mux_forget();
+        return;
+    }
+    perror("jobout: fork");
+    while (outputs != NULL) {
+        outputs->ended = 1;
+        for (i = 0; i < 2; i++) {
+            if (outputs->streams[i].fd >= 0) {
+                close(outputs->streams[i].fd);
+                outputs->streams[i].fd = -1;
+            }
+        }
+        output_flush(outputs);
+        output_free(outputs);
+    }
+}
+
+/**
+ * mux_forget - 在子进程中丢弃继承的管道和 epoll 实例
+ */
+void mux_forget() {
+    Output *out;
+    int i;
+
+    while ((out = outputs) != NULL) {
+        outputs = out->next;
+        for (i = 0; i < 2; i++) {
+            if (out->streams[i].fd >= 0) {
+                close(out->streams[i].fd);
+            }
+            free(out->streams[i].data);
+        }
+        free(out->trailer);
+        free(out->cmdline);
+        free(out);
+    }
+    current = NULL;
+    mux_mode = MUX_OFF;
+    if (mux_epoll_fd >= 0) {
+        close(mux_epoll_fd);
+        mux_epoll_fd = -1;
+    }
+}
+
+/**
+ * cmd_jobout - 设置后台作业的输出方式
+ *
+ * 功能：jobout 显示当前方式；jobout off|line|group 设置之后启动的后台作业
+ *       的输出方式，已启动的作业不受影响
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数错误
+ */
+int cmd_jobout(Command *cmd) {
+    static const char *mode_names[] = { "off", "line", "group" };
+    int i;
+
+    if (cmd->argc == 1) {
+        printf("jobout: %s\n", mode_names[mux_mode]);
+        return 0;
+    }
+    for (i = 0; i < 3; i++) {
+        if (cmd->argc == 2 && strcmp(cmd->args[1], mode_names[i]) == 0) {
+            mux_mode = i;
+            return 0;
+        }
+    }
+    fprintf(stderr, "用法: jobout [off|line|group]\n");
+    return -1;
+}
@@ -8,109 +8,509 @@
  */
 
 #include "myshell.h"
+#include "trace.h"
 
-/* 全局变量：批处理文件指针 */
+/* 全局变量：批处理文件指针（-c 时为命令串，-s 时为标准输入） */
 static FILE *batch_file = NULL;
 
+/* 读取批处理文件和 -s 脚本的缓冲区大小，大块读取减少 read 系统调用 */
+#define SCRIPT_BUFFER_SIZE (256 * 1024)
+
+/* 启动阶段，--startup-profile 报告每个阶段的耗时 */
+#define STARTUP_MAIN    0   /* 进入 main */
+#define STARTUP_ENV     1   /* 设置 shell 环境变量 */
+#define STARTUP_INPUT   2   /* 打开输入、初始化作业控制 */
+#define STARTUP_READ    3   /* 读入第一条命令 */
+#define STARTUP_PARSE   4   /* 解析第一条命令 */
+#define STARTUP_EXEC    5   /* 执行第一条命令 */
+#define STARTUP_PHASES  6
+
+/* 各阶段结束的时刻；startup_profile 为 0 时只记录进入 main 的时刻 */
+static struct timespec startup_time[STARTUP_PHASES];
+static int startup_profile = 0;
+
+static char* read_input(FILE *input, int continuation);
+static int text_append(char **text, size_t *len, size_t *size, const char *line);
+static int resolve_aliases(const char *path);
+static void set_shell_path(const char *argv0);
+static void startup_mark(int phase);
+static void startup_report();
+
 /* ========== 主函数 ========== */
 
 /**
  * main - 程序入口
  * 
- * 功能：初始化环境变量，处理批处理模式，进入主循环
+ * 功能：初始化环境变量，处理批处理模式、-c 命令串和 -s 标准输入脚本，
+ *       进入主循环
  * 参数：argc - 参数数量，argv - 参数数组
  * 返回：0 表示正常退出
  */
 int main(int argc, char *argv[]) {
-    char shell_path[MAX_PATH];
     char *line;
-    Command *cmd;
+    char *text = NULL;          /* 正在解析的命令文本（可能包含多行） */
+    size_t text_len = 0;
+    size_t text_size = 0;
+    Node *tree;
+    char **args;
+    char *self_args[2];
+    int count;
+    int status;
     int result;
+    struct timespec start, end;
+    long long elapsed_ms;
+    long long offset = 0;       /* 当前命令在批处理文件中的偏移 */
+    const char *journal_path = NULL;
+    int resume = 0;
+    const char *stats_path = NULL;
+    long long line_index = 0;   /* 已执行的命令数，作为跟踪点 line_start 的序号 */
     FILE *input = stdin;  /* 默认从标准输入读取 */
+
+    clock_gettime(CLOCK_MONOTONIC, &startup_time[STARTUP_MAIN]);
+
+    /* --startup-profile：第一条命令执行后报告启动耗时 */
+    if (argc > 1 && strcmp(argv[1], "--startup-profile") == 0) {
+        startup_profile = 1;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
+    /* --journal 日志文件 [--resume]：记录批处理文件中已完成的命令，恢复时跳过 */
+    while (argc > 1) {
+        if (strcmp(argv[1], "--journal") == 0 && argc > 2) {
+            journal_path = argv[2];
+            argv[2] = argv[0];
+            argv += 2;
+            argc -= 2;
+        } else if (strcmp(argv[1], "--stats") == 0 && argc > 2) {
+            /* --stats 文件：退出时把运行统计写成 JSON（- 表示标准错误） */
+            stats_path = argv[2];
+            argv[2] = argv[0];
+            argv += 2;
+            argc -= 2;
+        } else if (strcmp(argv[1], "--trace") == 0 && argc > 2) {
+            /* --trace 文件：跟踪点同时写入带时间戳的标记文件 */
+            if (trace_open(argv[2]) < 0) {
+                return 1;
+            }
+            argv[2] = argv[0];
+            argv += 2;
+            argc -= 2;
+        } else if (strcmp(argv[1], "--resume") == 0) {
+            resume = 1;
+            argv[1] = argv[0];
+            argv++;
+            argc--;
+        } else {
+            break;
+        }
+    }
+    if (journal_path == NULL && resume) {
+        fprintf(stderr, "myshell: --resume 需要与 --journal 日志文件 一起使用\n");
+        return 1;
+    }
+    if (journal_path != NULL &&
+        (argc < 2 || strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "-s") == 0)) {
+        fprintf(stderr, "myshell: --journal 只能用于批处理文件\n");
+        return 1;
+    }
     
+    stats_dump_at_exit(stats_path);
+
     /* 获取程序的完整路径并设置 shell 环境变量 */
-    if (realpath(argv[0], shell_path) != NULL) {
-        setenv("shell", shell_path, 1);
-    } else {
-        /* 如果 realpath 失败，使用 argv[0] */
-        setenv("shell", argv[0], 1);
-    }
+    set_shell_path(argv[0]);
+    startup_mark(STARTUP_ENV);
     
-    /* 检查是否为批处理模式 */
-    if (argc > 1) {
+    /* 预先展开批处理文件中的别名，输出到标准输出 */
+    if (argc == 3 && strcmp(argv[1], "--resolve-aliases") == 0) {
+        return resolve_aliases(argv[2]) < 0 ? 1 : 0;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        /* -c 命令串 [名字 [参数...]]：直接执行参数中的命令，不经过文件 */
+        if (argc < 3) {
+            fprintf(stderr, "myshell: -c 需要一个参数\n");
+            return 1;
+        }
+        if (argv[2][0] == '\0') {
+            return 0;
+        }
+        batch_file = fmemopen(argv[2], strlen(argv[2]), "r");
+        if (batch_file == NULL) {
+            perror("myshell: fmemopen");
+            return 1;
+        }
+
+        /* 名字为 $0，其后的参数为 $1、$2 ...；没有名字时 $0 为程序名 */
+        if (argc > 3) {
+            args = argv + 3;
+            count = argc - 4;
+        } else {
+            self_args[0] = argv[0];
+            self_args[1] = NULL;
+            args = self_args;
+            count = 0;
+        }
+    } else if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+        /* -s [参数...]：从标准输入读取脚本，不显示提示符，不做行编辑 */
+        batch_file = fdopen(STDIN_FILENO, "r");
+        if (batch_file == NULL) {
+            perror("myshell: fdopen");
+            return 1;
+        }
+        setvbuf(batch_file, NULL, _IOFBF, SCRIPT_BUFFER_SIZE);
+
+        /* 程序名为 $0，其后的参数为 $1、$2 ... */
+        argv[1] = argv[0];
+        args = argv + 1;
+        count = argc - 2;
+    } else if (argc > 1) {
+        /* 检查是否为批处理模式 */
         batch_file = fopen(argv[1], "r");
         if (batch_file == NULL) {
             fprintf(stderr, "myshell: 无法打开批处理文件 '%s': %s\n", 
                     argv[1], strerror(errno));
             return 1;
         }
+        setvbuf(batch_file, NULL, _IOFBF, SCRIPT_BUFFER_SIZE);
+        if (journal_path != NULL && journal_open(journal_path, resume) < 0) {
+            return 1;
+        }
+
+        /* 批处理文件名为 $0，其后的参数为 $1、$2 ... */
+        args = argv + 1;
+        count = argc - 2;
+    }
+
+    if (batch_file != NULL) {
         input = batch_file;
+        positional_swap(&args, &count);
+    } else {
+        /* 交互时开启作业控制：Ctrl-C、Ctrl-Z 只作用于前台作业 */
+        job_control_init();
     }
+    startup_mark(STARTUP_INPUT);
     
     /* 主循环 */
     while (1) {
-        /* 如果是交互模式，显示提示符 */
-        if (input == stdin) {
-            display_prompt();
+        /* 回收已结束的后台作业（非阻塞） */
+        jobs_reap(0);
+
+        if (journal_active()) {
+            offset = ftell(input);
         }
-        
-        /* 读取命令行 */
-        line = read_command(input);
+        line = read_input(input, 0);
         if (line == NULL) {
             /* 文件结束或读取错误 */
             break;
         }
-        
-        /* 跳过空行和注释 */
-        if (line[0] == '\0' || line[0] == '#') {
+        startup_mark(STARTUP_READ);
+
+        /* 解析命令；引号或复合命令未闭合时继续读取后续行 */
+        text_len = 0;
+        if (text_append(&text, &text_len, &text_size, line) < 0) {
             continue;
         }
-        
-        /* 解析命令 */
-        cmd = parse_command(line);
-        if (cmd == NULL) {
+        while ((status = parse_command(text, &tree)) == PARSE_INCOMPLETE) {
+            line = read_input(input, 1);
+            if (line == NULL) {
+                fprintf(stderr, "myshell: 语法错误: 意外的文件结束\n");
+                break;
+            }
+            if (text_append(&text, &text_len, &text_size, "\n") < 0 ||
+                text_append(&text, &text_len, &text_size, line) < 0) {
+                break;
+            }
+        }
+        if (status != PARSE_OK) {
+            /* 语法错误的状态为 2 */
+            status_set(2);
+            if (line == NULL) {
+                break;
+            }
             continue;
         }
+        if (tree == NULL) {
+            /* 空行或注释 */
+            continue;
+        }
+        if (journal_active() && journal_skip(offset, text, tree)) {
+            /* 上次运行中已成功完成 */
+            node_free(tree);
+            continue;
+        }
+        startup_mark(STARTUP_PARSE);
         
-        /* 执行命令 */
-        result = execute_command(cmd);
+        /* 执行命令，记录状态和耗时供提示符使用 */
+        line_index++;
+        TRACE(line_start, line_index, text);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        job_interrupt_clear();
+        result = execute_tree(tree);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        TRACE(line_done, status_get(), text);
+        startup_mark(STARTUP_EXEC);
+        startup_report();
+        elapsed_ms = (end.tv_sec - start.tv_sec) * 1000LL +
+                     (end.tv_nsec - start.tv_nsec) / 1000000;
+        prompt_command_done(status_get(), elapsed_ms);
+
+        /* exit 不记录：恢复时不能跳过它继续执行后面的命令 */
+        if (result != -999) {
+            journal_record(offset, text, status_get(), elapsed_ms);
+        }
         
-        /* 释放命令结构体 */
-        free_command(cmd);
+        /* 释放语法树 */
+        node_free(tree);
         
         /* 检查是否退出 */
         if (result == -999) {
             break;
         }
     }
+    free(text);
+    startup_report();
     
-    /* 关闭批处理文件 */
+    /* 关闭批处理文件，同步日志 */
     if (batch_file != NULL) {
         fclose(batch_file);
     }
+    journal_close();
+
+    /* 输出后台作业缓冲的内容（jobout） */
+    mux_shutdown();
+
+    /* 清理 shell 创建的 cgroup */
+    cgroup_shutdown();
+
+    /* --stats：写入运行统计 */
+    stats_shutdown();
+    trace_close();
     
-    return 0;
+    /* shell 的退出状态为最后一条命令的状态（或 exit n 指定的状态） */
+    return status_get();
 }
 
 /* ========== 辅助函数实现 ========== */
 
 /**
- * display_prompt - 显示命令提示符
- * 
- * 功能：显示包含当前工作目录的提示符
+ * set_shell_path - 设置 shell 环境变量为程序的完整路径
+ *
+ * 功能：readlink /proc/self/exe 一次系统调用即可得到解析后的路径，
+ *       不像 realpath 那样逐级 lstat，也不受 argv[0] 是否含路径影响；
+ *       没有挂载 /proc 时退回 realpath(argv[0])
+ * 参数：argv0 - argv[0]
  */
-void display_prompt() {
-    char cwd[MAX_PATH];
-    
-    /* 获取当前工作目录 */
-    if (getcwd(cwd, sizeof(cwd)) != NULL) {
-        printf("%s> ", cwd);
+static void set_shell_path(const char *argv0) {
+    char shell_path[MAX_PATH];
+    ssize_t n;
+
+    n = readlink("/proc/self/exe", shell_path, sizeof(shell_path) - 1);
+    if (n > 0) {
+        shell_path[n] = '\0';
+        setenv("shell", shell_path, 1);
+    } else if (realpath(argv0, shell_path) != NULL) {
+        setenv("shell", shell_path, 1);
     } else {
-        printf("myshell> ");
+        /* 如果 realpath 失败，使用 argv[0] */
+        setenv("shell", argv0, 1);
+    }
+}
+
+/* ========== 启动耗时 ========== */
+
+/**
+ * startup_mark - 记录启动阶段结束的时刻
+ *
+ * 功能：只记录每个阶段第一次到达的时刻；未开启 --startup-profile 时不做任何事
+ * 参数：phase - 阶段编号
+ */
+static void startup_mark(int phase) {
+    if (startup_profile && startup_time[phase].tv_sec == 0 &&
+        startup_time[phase].tv_nsec == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &startup_time[phase]);
     }
-    
-    /* 刷新输出缓冲区 */
-    fflush(stdout);
+}
+
+/**
+ * startup_report - 向标准错误输出启动耗时
+ *
+ * 功能：先输出 getrusage 得到的进程 CPU 时间和缺页次数（包含 main 之前的
+ *       动态链接和初始化），再输出进入 main 之后各阶段的耗时（微秒）。只输出一次
+ */
+static void startup_report() {
+    static const char *names[STARTUP_PHASES] = {
+        "进入 main", "设置 shell 变量", "打开输入", "读入第一条命令",
+        "解析第一条命令", "执行第一条命令"
+    };
+    struct rusage usage;
+    struct timespec *prev = &startup_time[STARTUP_MAIN];
+    long long us;
+    int i;
+
+    if (!startup_profile) {
+        return;
+    }
+    startup_profile = 0;
+
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "[startup] 进程 CPU 时间: 用户 %ld us, 系统 %ld us, 缺页 %ld 次\n",
+            usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec,
+            usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec,
+            usage.ru_minflt + usage.ru_majflt);
+
+    for (i = 1; i < STARTUP_PHASES; i++) {
+        if (startup_time[i].tv_sec == 0 && startup_time[i].tv_nsec == 0) {
+            continue;
+        }
+        us = (startup_time[i].tv_sec - prev->tv_sec) * 1000000LL +
+             (startup_time[i].tv_nsec - prev->tv_nsec) / 1000;
+        fprintf(stderr, "[startup] %s: %lld us\n", names[i], us);
+        prev = &startup_time[i];
+    }
+    us = (prev->tv_sec - startup_time[STARTUP_MAIN].tv_sec) * 1000000LL +
+         (prev->tv_nsec - startup_time[STARTUP_MAIN].tv_nsec) / 1000;
+    fprintf(stderr, "[startup] 合计: %lld us（自%s）\n", us, names[0]);
+}
+
+/**
+ * read_input - 读取一行输入
+ * 
+ * 功能：终端交互时使用行编辑器并记录历史，否则直接读取；
+ *       标准输入的续行使用 "> " 提示符
+ * 参数：input - 输入流，continuation - 是否为续行
+ * 返回：命令字符串指针，文件结束返回 NULL
+ */
+static char* read_input(FILE *input, int continuation) {
+    char *line;
+
+    if (input == stdin && isatty(STDIN_FILENO)) {
+        line = line_edit(continuation ? "> " : prompt_text());
+        if (line != NULL) {
+            history_add(line);
+        }
+        return line;
+    }
+
+    if (input == stdin) {
+        if (continuation) {
+            printf("> ");
+            fflush(stdout);
+        } else {
+            display_prompt();
+        }
+    }
+    return read_command(input);
+}
+
+/**
+ * text_append - 向命令文本末尾追加内容
+ * 
+ * 参数：text - 文本缓冲区指针，len - 当前长度，size - 缓冲区大小，
+ *       line - 追加的内容
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+static int text_append(char **text, size_t *len, size_t *size, const char *line) {
+    size_t add = strlen(line);
+    char *grown;
+
+    if (*len + add + 1 > *size) {
+        size_t new_size = *size ? *size : MAX_LINE;
+        while (*len + add + 1 > new_size) {
+            new_size *= 2;
+        }
+        grown = realloc(*text, new_size);
+        if (grown == NULL) {
+            perror("myshell");
+            return -1;
+        }
+        *text = grown;
+        *size = new_size;
+    }
+    memcpy(*text + *len, line, add + 1);
+    *len += add;
+    return 0;
+}
+
+/**
+ * resolve_aliases - 预先展开批处理文件中的别名
+ *
+ * 功能：逐条解析批处理文件，输出展开别名后的命令文本。文件中的
+ *       alias/unalias 命令在解析到时执行（不输出），之后的命令按新的
+ *       别名展开。输出的文件运行时不再需要展开别名
+ * 参数：path - 批处理文件路径
+ * 返回：0 表示成功，-1 表示文件无法打开或有语法错误
+ */
+static int resolve_aliases(const char *path) {
+    FILE *file = fopen(path, "r");
+    char *text = NULL;
+    char *resolved;
+    size_t len = 0, size = 0;
+    char *line;
+    Node *tree, *node, *next;
+    int status;
+    int result = 0;
+
+    if (file == NULL) {
+        fprintf(stderr, "myshell: 无法打开批处理文件 '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while ((line = read_command(file)) != NULL) {
+        len = 0;
+        if (text_append(&text, &len, &size, line) < 0) {
+            result = -1;
+            break;
+        }
+        while ((status = parse_resolve(text, &tree, &resolved)) == PARSE_INCOMPLETE) {
+            free(resolved);
+            resolved = NULL;
+            line = read_command(file);
+            if (line == NULL || text_append(&text, &len, &size, "\n") < 0 ||
+                text_append(&text, &len, &size, line) < 0) {
+                break;
+            }
+        }
+
+        if (status != PARSE_OK || resolved == NULL) {
+            /* 语法错误的命令原样输出 */
+            printf("%s\n", text);
+            free(resolved);
+            result = -1;
+            if (status == PARSE_INCOMPLETE) {
+                break;
+            }
+            continue;
+        }
+
+        if (tree == NULL) {
+            /* 空行和注释原样输出 */
+            printf("%s\n", resolved);
+        }
+
+        /* 顶层的 alias/unalias 命令在这里执行并从输出中去掉，使后续命令
+         * 按新的别名展开，且运行输出的文件时不会再次展开；其他命令输出
+         * 展开后的文本，每项一行 */
+        for (node = tree; node != NULL; node = next) {
+            next = node->next;
+            if (node->type == NODE_SIMPLE && node->word_count > 0 &&
+                (strcmp(node->words[0], "alias") == 0 || strcmp(node->words[0], "unalias") == 0)) {
+                node->next = NULL;
+                fflush(stdout);
+                execute_tree(node);
+                node->next = next;
+            } else {
+                printf("%s%s\n", node->text ? node->text : "", node->background ? " &" : "");
+            }
+        }
+        node_free(tree);
+        free(resolved);
+    }
+
+    free(text);
+    fclose(file);
+    return result;
 }
 
 /**
@@ -126,6 +526,7 @@ char* read_command(FILE *input) {
     int len;
     
     /* 读取一行 */
+    TRACE(read_start, 0, "");
     result = fgets(buffer, MAX_LINE, input);
     if (result == NULL) {
         return NULL;
@@ -136,92 +537,11 @@ char* read_command(FILE *input) {
     if (len > 0 && buffer[len - 1] == '\n') {
         buffer[len - 1] = '\0';
     }
+    TRACE(read_done, len, buffer);
     
     return buffer;
 }
 
-/**
- * parse_command - 解析命令行
- * 
- * 功能：将命令行字符串解析为 Command 结构体
- *       识别参数、重定向符号（<、>、>>）和后台执行符号（&）
- * 参数：line - 命令行字符串
- * 返回：Command 结构体指针，失败返回 NULL
- */
-Command* parse_command(char *line) {
-    static Command cmd;
-    static char line_copy[MAX_LINE];
-    char *token;
-
-    /* 初始化 Command 结构体 */
-    cmd.argc = 0;
-    cmd.input_file = NULL;
-    cmd.output_file = NULL;
-    cmd.append_mode = 0;
-    cmd.background = 0;
-    
-    /* 复制命令行，因为 strtok 会修改原字符串 */
-    strncpy(line_copy, line, MAX_LINE - 1);
-    line_copy[MAX_LINE - 1] = '\0';
-    
-    /* 使用 strtok 分割命令行 */
-    token = strtok(line_copy, " \t");
-    
-    while (token != NULL && cmd.argc < MAX_ARGS - 1) {
-        /* 检查是否为重定向符号 */
-        if (strcmp(token, "<") == 0) {
-            /* 输入重定向 */
-            token = strtok(NULL, " \t");
-            if (token != NULL) {
-                cmd.input_file = token;
-            }
-        } else if (strcmp(token, ">") == 0) {
-            /* 输出重定向（覆盖模式） */
-            token = strtok(NULL, " \t");
-            if (token != NULL) {
-                cmd.output_file = token;
-                cmd.append_mode = 0;
-            }
-        } else if (strcmp(token, ">>") == 0) {
-            /* 输出重定向（追加模式） */
-            token = strtok(NULL, " \t");
-            if (token != NULL) {
-                cmd.output_file = token;
-                cmd.append_mode = 1;
-            }
-        } else if (strcmp(token, "&") == 0) {
-            /* 后台执行 */
-            cmd.background = 1;
-        } else {
-            /* 普通参数 */
-            cmd.args[cmd.argc++] = token;
-        }
-        
-        token = strtok(NULL, " \t");
-    }
-    
-    /* 参数数组以 NULL 结尾（execvp 需要） */
-    cmd.args[cmd.argc] = NULL;
-    
-    /* 如果没有参数，返回 NULL */
-    if (cmd.argc == 0) {
-        return NULL;
-    }
-    
-    return &cmd;
-}
-
-/**
- * free_command - 释放命令结构体
- * 
- * 功能：释放 Command 结构体占用的内存
- * 参数：cmd - Command 结构体指针
- */
-void free_command(Command *cmd) {
-    /* 当前实现使用静态结构体，无需释放 */
-    /* 如果将来改为动态分配，在此处添加 free 调用 */
-}
-
 /* ========== 内部命令实现（简单命令） ========== */
 
 /**
@@ -254,6 +574,7 @@ int cmd_cd(Command *cmd) {
         if (getcwd(cwd, sizeof(cwd)) != NULL) {
             setenv("PWD", cwd, 1);
         }
+        prompt_invalidate_cwd();
     }
     
     return 0;
@@ -276,11 +597,15 @@ int cmd_clr(Command *cmd) {
 /**
  * cmd_quit - 退出命令
  * 
- * 功能：退出 shell 程序
+ * 功能：退出 shell 程序；quit [n] / exit [n] 以 n 为退出状态，
+ *       省略时为最后一条命令的状态
  * 参数：cmd - Command 结构体指针
  * 返回：-999 表示退出信号
  */
 int cmd_quit(Command *cmd) {
+    if (cmd->argc > 1) {
+        status_set(atoi(cmd->args[1]));
+    }
     return -999;
 }
 
@@ -297,99 +622,205 @@ int cmd_pause(Command *cmd) {
     return 0;
 }
 
-/* ========== 命令执行调度（临时实现） ========== */
+/* ========== 命令执行调度 ========== */
+
+/**
+ * 内部命令分派表
+ *
+ * 每项为命令名、处理函数和是否支持 I/O 重定向；以 NULL 结尾。
+ * Tab 补全也从这里获取内部命令名
+ */
+static const Builtin builtins[] = {
+    { "cd",       cmd_cd,       1 },
+    { "clr",      cmd_clr,      0 },
+    { "quit",     cmd_quit,     0 },
+    { "exit",     cmd_quit,     0 },
+    { "pause",    cmd_pause,    0 },
+    { "dir",      cmd_dir,      1 },
+    { "echo",     cmd_echo,     1 },
+    { "environ",  cmd_environ,  1 },
+    { "env",      cmd_env,      1 },
+    { "help",     cmd_help,     1 },
+    { "timeout",  cmd_timeout,  0 },
+    { "cache",    cmd_cache,    0 },
+    { "jobout",   cmd_jobout,   1 },
+    { "stats",    cmd_stats,    1 },
+    { "ulimit",   cmd_ulimit,   1 },
+    { "cgroup",   cmd_cgroup,   1 },
+    { "taskset",  cmd_taskset,  0 },
+    { "affinity", cmd_affinity, 1 },
+    { "acct",     cmd_acct,     1 },
+    { "history",  cmd_history,  1 },
+    { "prompt",   cmd_prompt,   1 },
+    { "break",    cmd_break,    0 },
+    { "continue", cmd_continue, 0 },
+    { "return",   cmd_return,   0 },
+    { "shift",    cmd_shift,    0 },
+    { "set",      cmd_set,      1 },
+    { "let",      cmd_let,      0 },
+    { "true",     cmd_true,     1 },
+    { "false",    cmd_false,    1 },
+    { ":",        cmd_true,     1 },
+    { "test",     cmd_test,     1 },
+    { "[",        cmd_test,     1 },
+    { "printf",   cmd_printf,   1 },
+    { "read",     cmd_read,     1 },
+    { "export",   cmd_export,   1 },
+    { "unset",    cmd_unset,    1 },
+    { "pwd",      cmd_pwd,      1 },
+    { "cat",      cmd_cat,      1 },
+    { "head",     cmd_head,     1 },
+    { "tail",     cmd_tail,     1 },
+    { "wc",       cmd_wc,       1 },
+    { "enable",   cmd_enable,   1 },
+    { "alias",    cmd_alias,    1 },
+    { "unalias",  cmd_unalias,  0 },
+    { "jobs",     cmd_jobs,     1 },
+    { "wait",     cmd_wait,     0 },
+    { "fg",       cmd_fg,       0 },
+    { "bg",       cmd_bg,       1 },
+    { NULL,       NULL,         0 }
+};
+
+/**
+ * find_builtin - 查找内部命令
+ *
+ * 功能：先查 enable -f 加载的命令（可替换同名的内置命令），再查分派表
+ * 参数：name - 命令名
+ * 返回：分派表中的表项，不是内部命令时返回 NULL
+ */
+const Builtin* find_builtin(const char *name) {
+    const Builtin *loaded = plugin_find(name);
+    int i;
+
+    if (loaded != NULL) {
+        return loaded;
+    }
+    for (i = 0; builtins[i].name != NULL; i++) {
+        if (strcmp(builtins[i].name, name) == 0) {
+            return &builtins[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * builtin_count - 获取内置命令个数（不含已加载的命令）
+ *
+ * 返回：分派表中的命令个数
+ */
+int builtin_count() {
+    return (int)(sizeof(builtins) / sizeof(builtins[0])) - 1;
+}
+
+/**
+ * builtin_name - 按序号获取内部命令名
+ *
+ * 功能：序号先覆盖分派表中的命令，之后是已加载的命令
+ * 参数：index - 序号
+ * 返回：命令名，序号超出范围时返回 NULL
+ */
+const char* builtin_name(int index) {
+    if (index < 0) {
+        return NULL;
+    }
+    if (index < builtin_count()) {
+        return builtins[index].name;
+    }
+    return plugin_name(index - builtin_count());
+}
+
+/**
+ * run_builtin_redirected - 在 I/O 重定向下执行内部命令
+ *
+ * 功能：临时把标准输入/输出重定向到文件，执行完毕后恢复
+ * 参数：builtin - 分派表项，cmd - Command 结构体指针
+ * 返回：内部命令的返回值，重定向失败返回 -1
+ */
+static int run_builtin_redirected(const Builtin *builtin, Command *cmd) {
+    int saved_stdin = -1;
+    int saved_stdout = -1;
+    int result = -1;
+
+    /* 保存原 stdin/stdout */
+    fflush(stdout);
+    if (cmd->input_file != NULL && (saved_stdin = dup(STDIN_FILENO)) < 0) {
+        perror("dup");
+        return -1;
+    }
+    if (cmd->output_file != NULL && (saved_stdout = dup(STDOUT_FILENO)) < 0) {
+        perror("dup");
+        if (saved_stdin >= 0) {
+            close(saved_stdin);
+        }
+        return -1;
+    }
+
+    /* 打开文件并重定向，然后执行命令 */
+    if (setup_redirection(cmd) == 0) {
+        stats_builtin_begin();
+        result = builtin->func(cmd);
+        stats_builtin_end();
+    }
+
+    /* 恢复原 stdin/stdout */
+    fflush(stdout);
+    if (saved_stdin >= 0) {
+        dup2(saved_stdin, STDIN_FILENO);
+        close(saved_stdin);
+    }
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    return result;
+}
 
 /**
  * execute_command - 执行命令
  *
- * 功能：判断命令类型（内部命令或外部程序）并执行
- *       支持内部命令的输出重定向（dir、echo）
+ * 功能：依次查找 shell 函数和分派表中的内部命令并执行，否则作为外部程序执行
+ *       支持内部命令的 I/O 重定向（dir、echo、printf、read 等）
  * 参数：cmd - Command 结构体指针
  * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
  */
 int execute_command(Command *cmd) {
-    int saved_stdout = -1;
-    int result = 0;
-    int fd_out;
-    int flags;
+    const Builtin *builtin;
+    Node *function;
+    int result;
 
     /* 检查空命令 */
     if (cmd == NULL || cmd->argc == 0) {
         return 0;
     }
 
-    /* 获取命令名 */
-    char *command = cmd->args[0];
-
-    /* 判断是否为内部命令 */
-    if (strcmp(command, "cd") == 0) {
-        return cmd_cd(cmd);
-    } else if (strcmp(command, "clr") == 0) {
-        return cmd_clr(cmd);
-    } else if (strcmp(command, "quit") == 0) {
-        return cmd_quit(cmd);
-    } else if (strcmp(command, "pause") == 0) {
-        return cmd_pause(cmd);
-    } else if (strcmp(command, "dir") == 0 || strcmp(command, "echo") == 0) {
-        /* dir 和 echo 支持输出重定向 */
-
-        /* 如果有输出重定向，保存原 stdout */
-        if (cmd->output_file != NULL) {
-            saved_stdout = dup(STDOUT_FILENO);
-            if (saved_stdout < 0) {
-                perror("dup");
-                return -1;
-            }
+    status_begin();
+    TRACE(command_start, cmd->argc, cmd->args[0]);
 
-            /* 打开输出文件 */
-            flags = O_WRONLY | O_CREAT;
-            if (cmd->append_mode) {
-                flags |= O_APPEND;
-            } else {
-                flags |= O_TRUNC;
-            }
-
-            fd_out = open(cmd->output_file, flags, 0644);
-            if (fd_out < 0) {
-                perror("输出重定向");
-                close(saved_stdout);
-                return -1;
-            }
-
-            /* 重定向标准输出 */
-            if (dup2(fd_out, STDOUT_FILENO) < 0) {
-                perror("dup2");
-                close(fd_out);
-                close(saved_stdout);
-                return -1;
-            }
-
-            close(fd_out);
-        }
-
-        /* 执行命令 */
-        if (strcmp(command, "dir") == 0) {
-            result = cmd_dir(cmd);
+    /* shell 函数优先于内部命令 */
+    function = function_find(cmd->args[0]);
+    builtin = function == NULL ? find_builtin(cmd->args[0]) : NULL;
+    stats_add(STAT_REDIRECTIONS, (cmd->input_file != NULL) + (cmd->output_file != NULL));
+    if (function != NULL) {
+        stats_add(STAT_FUNCTIONS, 1);
+        result = function_call(function, cmd);
+    } else if (builtin == NULL) {
+        /* 外部程序，调用 execute_external */
+        result = execute_external(cmd);
+    } else {
+        stats_add(STAT_BUILTINS, 1);
+        if (builtin->redirect && (cmd->input_file != NULL || cmd->output_file != NULL)) {
+            result = run_builtin_redirected(builtin, cmd);
         } else {
-            result = cmd_echo(cmd);
+            stats_builtin_begin();
+            result = builtin->func(cmd);
+            stats_builtin_end();
         }
-
-        /* 恢复原 stdout */
-        if (saved_stdout >= 0) {
-            dup2(saved_stdout, STDOUT_FILENO);
-            close(saved_stdout);
-        }
-
-        return result;
-    } else if (strcmp(command, "environ") == 0) {
-        return cmd_environ(cmd);
-    } else if (strcmp(command, "help") == 0) {
-        return cmd_help(cmd);
-    } else {
-        /* 外部程序，调用 execute_external */
-        return execute_external(cmd);
     }
 
-    return 0;
+    /* 没有记录具体状态的内部命令按结果记为 0 或 1 */
+    result = status_finish(result);
+    TRACE(command_done, status_get(), cmd->args[0]);
+    return result;
 }
-
@@ -10,6 +10,9 @@
 #define MYSHELL_H
 
 /* ========== 系统头文件 ========== */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     /* 启用 prlimit 等 Linux 扩展接口 */
+#endif
 #include <stdio.h>      /* 标准输入输出 */
 #include <stdlib.h>     /* 标准库函数 */
 #include <string.h>     /* 字符串处理 */
@@ -19,6 +22,9 @@
 #include <fcntl.h>      /* 文件控制 */
 #include <dirent.h>     /* 目录操作 */
 #include <errno.h>      /* 错误处理 */
+#include <sched.h>      /* CPU 亲和性 */
+#include <sys/resource.h> /* 资源使用统计 */
+#include <time.h>       /* 单调时钟 */
 
 /* ========== 常量定义 ========== */
 #define MAX_LINE 1024   /* 最大命令行长度 */
@@ -37,6 +43,14 @@
  *   output_file  - 输出重定向文件名（> 或 >> 符号），NULL 表示无重定向
  *   append_mode  - 输出追加模式标志：1 表示追加(>>)，0 表示覆盖(>)
  *   background   - 后台执行标志：1 表示后台执行(&)，0 表示前台执行
+ *   timeout_ms   - 执行时限（毫秒），0 表示不限时（由 timeout 命令设置）
+ *   kill_after_ms - 超时发送 SIGTERM 后，再等待多久发送 SIGKILL
+ *   has_cpus     - 是否指定了 CPU 亲和性（由 taskset 命令设置）
+ *   cpus         - 子进程允许运行的 CPU 集合
+ *   env[]        - 只对本命令生效的环境变量（VAR=val cmd 前缀和 env 命令），
+ *                  形如 "NAME=value"，不含 '=' 的项表示删除该变量
+ *   env_count    - env 中的项数
+ *   env_clear    - 1 表示子进程从空环境开始（env -i）
  */
 typedef struct {
     char *args[MAX_ARGS];   /* 参数数组 */
@@ -45,18 +59,198 @@ typedef struct {
     char *output_file;      /* 输出重定向文件 */
     int append_mode;        /* 追加模式标志 */
     int background;         /* 后台执行标志 */
+    long timeout_ms;        /* 执行时限 */
+    long kill_after_ms;     /* 强制终止延迟 */
+    int has_cpus;           /* 指定 CPU 亲和性标志 */
+    cpu_set_t cpus;         /* CPU 集合 */
+    char *env[MAX_ARGS];    /* 本命令的环境变量 */
+    int env_count;          /* 环境变量项数 */
+    int env_clear;          /* 空环境标志 */
 } Command;
 
-/* ========== 函数原型声明（myshell.c 中实现） ========== */
+/**
+ * Placement 结构体 - 子进程的 CPU/NUMA 放置方案
+ * 
+ * 字段说明：
+ *   active       - 是否需要设置：0 表示沿用 shell 的亲和性
+ *   cpus         - 绑定的 CPU 集合
+ *   node         - 首选的 NUMA 节点，-1 表示不设置内存策略
+ *   desc         - 文本描述，如 "cpus=0-3 node=0"，用于资源统计输出
+ */
+typedef struct {
+    int active;             /* 是否需要设置 */
+    cpu_set_t cpus;         /* CPU 集合 */
+    int node;               /* NUMA 节点 */
+    char desc[128];         /* 文本描述 */
+} Placement;
 
 /**
- * display_prompt - 显示命令提示符
+ * CgroupStats 结构体 - 作业结束时从 cgroup 读取的资源统计
  * 
- * 功能：显示包含当前工作目录的提示符
- * 参数：无
- * 返回：无
+ * 字段说明（-1 表示该项不可用）：
+ *   cpu_usage_us   - CPU 使用时间（微秒，cpu.stat 的 usage_usec）
+ *   memory_peak    - 内存使用峰值（字节，memory.peak）
+ *   cpu_stall_us   - CPU 压力累计停顿时间（微秒，cpu.pressure 的 some total）
+ *   memory_stall_us - 内存压力累计停顿时间（微秒）
+ *   io_stall_us    - IO 压力累计停顿时间（微秒）
  */
-void display_prompt();
+typedef struct {
+    long long cpu_usage_us;     /* CPU 使用时间 */
+    long long memory_peak;      /* 内存峰值 */
+    long long cpu_stall_us;     /* CPU 压力 */
+    long long memory_stall_us;  /* 内存压力 */
+    long long io_stall_us;      /* IO 压力 */
+} CgroupStats;
+
+/**
+ * Builtin 结构体 - 内部命令分派表项
+ * 
+ * 字段说明：
+ *   name      - 命令名
+ *   func      - 处理函数
+ *   redirect  - 是否支持输出重定向：1 表示支持
+ */
+typedef struct {
+    const char *name;           /* 命令名 */
+    int (*func)(Command *cmd);  /* 处理函数 */
+    int redirect;               /* 支持 I/O 重定向标志 */
+} Builtin;
+
+/* 语法树节点类型 */
+#define NODE_SIMPLE   0   /* 简单命令 */
+#define NODE_PIPE     1   /* 管道 a | b */
+#define NODE_AND      2   /* a && b */
+#define NODE_OR       3   /* a || b */
+#define NODE_SUBSHELL 4   /* ( 列表 )，在子进程中执行 */
+#define NODE_BRACE    5   /* { 列表 }，在 shell 进程内执行 */
+#define NODE_IF       6   /* if/elif/else */
+#define NODE_WHILE    7   /* while 循环 */
+#define NODE_UNTIL    8   /* until 循环 */
+#define NODE_FOR      9   /* for 循环 */
+#define NODE_CASE     10  /* case 语句 */
+#define NODE_CASE_ITEM 11 /* case 的一个分支 */
+#define NODE_FUNCTION 12  /* 函数定义 */
+
+/* 重定向类型 */
+#define REDIR_IN      0   /* < */
+#define REDIR_OUT     1   /* > */
+#define REDIR_APPEND  2   /* >> */
+
+/* parse_command 的返回值 */
+#define PARSE_OK          0   /* 解析成功 */
+#define PARSE_INCOMPLETE  1   /* 输入不完整，需要继续读取 */
+#define PARSE_ERROR      -1   /* 语法错误 */
+
+/**
+ * Redirect 结构体 - 语法树中的一个重定向
+ * 
+ * 字段说明：
+ *   type      - 重定向类型：REDIR_IN、REDIR_OUT 或 REDIR_APPEND
+ *   target    - 目标文件名（未展开的原文）
+ *   next      - 下一个重定向
+ */
+typedef struct Redirect {
+    int type;                   /* 重定向类型 */
+    char *target;               /* 目标文件名 */
+    struct Redirect *next;      /* 下一个重定向 */
+} Redirect;
+
+/**
+ * Node 结构体 - 语法树节点
+ * 
+ * 字段说明：
+ *   type       - 节点类型（NODE_*）
+ *   left       - 管道、&&、|| 的左侧；组合命令、循环体、函数体；
+ *                if/while/until 的条件；case 分支的命令列表
+ *   right      - 管道、&&、|| 的右侧；if 的 then 分支；while/until 的循环体
+ *   alt        - if 的 else 分支（elif 为嵌套的 if 节点）；case 的分支链
+ *   next       - 命令列表中的下一项
+ *   words      - 简单命令的单词、for 的列表、case 的测试值或分支模式（未展开的原文）
+ *   word_count - 单词数量
+ *   name       - for 的循环变量名；函数名
+ *   redirects  - 简单命令或复合命令的重定向
+ *   background - 列表项以 & 结尾，后台执行
+ *   refs       - 额外引用计数（函数体被函数表引用时大于 0）
+ *   text       - 列表项的源文本，用于显示后台作业
+ */
+typedef struct Node {
+    int type;                   /* 节点类型 */
+    struct Node *left;          /* 左子树 */
+    struct Node *right;         /* 右子树 */
+    struct Node *alt;           /* 其他分支 */
+    struct Node *next;          /* 列表下一项 */
+    char **words;               /* 单词 */
+    int word_count;             /* 单词数量 */
+    char *name;                 /* 变量名或函数名 */
+    Redirect *redirects;        /* 重定向 */
+    int background;             /* 后台执行标志 */
+    int refs;                   /* 额外引用计数 */
+    char *text;                 /* 源文本 */
+} Node;
+
+/**
+ * WordList 结构体 - 展开得到的单词列表
+ * 
+ * 字段说明：
+ *   items     - 单词数组，以 NULL 结尾
+ *   count     - 单词数量
+ *   capacity  - 数组容量
+ */
+typedef struct {
+    char **items;               /* 单词数组 */
+    int count;                  /* 单词数量 */
+    int capacity;               /* 数组容量 */
+} WordList;
+
+/* 作业状态 */
+#define JOB_RUNNING 0   /* 运行中 */
+#define JOB_DONE    1   /* 已结束 */
+#define JOB_STOPPED 2   /* 已停止（被 Ctrl-Z 挂起） */
+
+/* timeout 命令默认的强制终止延迟（毫秒） */
+#define TIMEOUT_KILL_DELAY 2000
+
+/**
+ * Job 结构体 - 表示作业表中的一个子进程
+ * 
+ * 字段说明：
+ *   id           - 作业号，从 1 开始分配
+ *   pid          - 子进程号
+ *   pidfd        - 子进程的 pidfd，-1 表示内核不支持，退化为 PID 跟踪
+ *   background   - 后台执行标志
+ *   state        - 作业状态：JOB_RUNNING、JOB_DONE 或 JOB_STOPPED
+ *   status       - wait 返回的退出状态
+ *   cmdline      - 命令行文本，用于显示
+ *   deadline     - 超时时刻（单调时钟毫秒），0 表示不限时
+ *   kill_deadline - 发送 SIGKILL 的时刻，发送 SIGTERM 后才有效
+ *   kill_after_ms - SIGTERM 与 SIGKILL 之间的间隔
+ *   timed_out    - 超时标志：1 表示已因超时发送过 SIGTERM
+ *   start_ms     - 启动时刻（单调时钟毫秒），用于统计实际耗时
+ *   end_ms       - 结束时刻
+ *   usage        - wait4 返回的资源使用情况
+ *   cgroup       - 作业独占的 cgroup 目录，空串表示没有
+ *   placement    - CPU/NUMA 放置描述，空串表示未绑定
+ */
+typedef struct {
+    int id;                 /* 作业号 */
+    pid_t pid;              /* 子进程号 */
+    int pidfd;              /* 进程文件描述符 */
+    int background;         /* 后台执行标志 */
+    int state;              /* 作业状态 */
+    int status;             /* 退出状态 */
+    char cmdline[MAX_LINE]; /* 命令行文本 */
+    long long deadline;     /* 超时时刻 */
+    long long kill_deadline; /* 强制终止时刻 */
+    long kill_after_ms;     /* 强制终止延迟 */
+    int timed_out;          /* 超时标志 */
+    long long start_ms;     /* 启动时刻 */
+    long long end_ms;       /* 结束时刻 */
+    struct rusage usage;    /* 资源使用情况 */
+    char cgroup[MAX_PATH];  /* 作业 cgroup 目录 */
+    char placement[128];    /* 放置描述 */
+} Job;
+
+/* ========== 函数原型声明（myshell.c 中实现） ========== */
 
 /**
  * read_command - 读取命令行
@@ -67,16 +261,6 @@ void display_prompt();
  */
 char* read_command(FILE *input);
 
-/**
- * parse_command - 解析命令行
- * 
- * 功能：将命令行字符串解析为 Command 结构体
- *       识别参数、重定向符号（<、>、>>）和后台执行符号（&）
- * 参数：line - 命令行字符串
- * 返回：Command 结构体指针，失败返回 NULL
- */
-Command* parse_command(char *line);
-
 /**
  * execute_command - 执行命令
  * 
@@ -87,13 +271,32 @@ Command* parse_command(char *line);
 int execute_command(Command *cmd);
 
 /**
- * free_command - 释放命令结构体
+ * find_builtin - 查找内部命令
  * 
- * 功能：释放 Command 结构体占用的内存
- * 参数：cmd - Command 结构体指针
- * 返回：无
+ * 功能：在内部命令分派表中按名称查找
+ * 参数：name - 命令名
+ * 返回：分派表项指针，不是内部命令时返回 NULL
+ */
+const Builtin* find_builtin(const char *name);
+
+/**
+ * builtin_name - 按序号获取内部命令名
+ * 
+ * 功能：用于枚举所有内部命令（例如 Tab 补全）
+ * 参数：index - 序号，从 0 开始
+ * 返回：命令名，超出范围时返回 NULL
+ */
+const char* builtin_name(int index);
+
+/**
+ * builtin_count - 获取内置命令个数
+ * 
+ * 功能：不含 enable -f 加载的命令；builtin_name 的序号从这里开始是已加载的命令
+ * 参数：无
+ * 返回：命令个数
  */
-void free_command(Command *cmd);
+int builtin_count();
+
 
 /**
  * cmd_cd - 改变当前目录命令
@@ -162,13 +365,76 @@ int cmd_environ(Command *cmd);
 int cmd_echo(Command *cmd);
 
 /**
- * cmd_help - 显示帮助命令
+ * cmd_cat - 连接并输出文件
  * 
- * 功能：显示用户手册，使用 more 命令分页
+ * 功能：在 shell 进程内用 copy_file_range/splice/sendfile 复制文件，
+ *       不支持的选项执行外部 cat
  * 参数：cmd - Command 结构体指针
  * 返回：0 表示成功，-1 表示失败
  */
-int cmd_help(Command *cmd);
+int cmd_cat(Command *cmd);
+
+/**
+ * cmd_head - 输出文件开头部分
+ * 
+ * 功能：支持 -n 和 -c，其他选项执行外部 head
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_head(Command *cmd);
+
+/**
+ * cmd_tail - 输出文件末尾部分
+ * 
+ * 功能：对普通文件从末尾定位，支持 -n 和 -c，管道输入和其他选项执行外部 tail
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_tail(Command *cmd);
+
+/**
+ * cmd_wc - 统计行数、单词数和字节数
+ * 
+ * 功能：支持 -l、-w、-c，其他选项执行外部 wc
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_wc(Command *cmd);
+
+/**
+ * copy_fd - 把数据从一个描述符复制到另一个描述符
+ * 
+ * 功能：按描述符类型选用 copy_file_range、splice、sendfile，最后退回 read/write
+ * 参数：in - 源描述符，out - 目标描述符，limit - 最多复制的字节数（-1 表示不限）
+ * 返回：0 表示成功，-1 表示失败
+ */
+int copy_fd(int in, int out, long long limit);
+
+/**
+ * exec_failed - 在子进程中报告 exec 失败
+ * 
+ * 参数：name - 命令名
+ * 返回：退出状态，找不到命令为 127，不能执行为 126
+ */
+int exec_failed(const char *name);
+
+/**
+ * env_build - 构造子进程的环境
+ * 
+ * 功能：在 shell 的环境上应用 cmd->env 中的设置和删除（env_clear 时从空环境开始）
+ * 参数：cmd - Command 结构体指针
+ * 返回：以 NULL 结尾的数组，由调用者 free（字符串不需要释放），失败返回 NULL
+ */
+char** env_build(Command *cmd);
+
+/**
+ * exec_command - 在子进程中执行外部程序
+ * 
+ * 功能：有单独的环境时按 env_build 的结果 execve，否则 execvp
+ * 参数：cmd - Command 结构体指针
+ * 返回：只在失败时返回，errno 为失败原因
+ */
+void exec_command(Command *cmd);
 
 /**
  * execute_external - 执行外部程序
@@ -188,5 +454,1208 @@ int execute_external(Command *cmd);
  */
 int setup_redirection(Command *cmd);
 
+/* ========== 函数原型声明（jobs.c 中实现） ========== */
+
+/**
+ * job_add - 登记新的子进程
+ * 
+ * 功能：为子进程分配作业号并打开 pidfd，后台作业加入 epoll 监听
+ * 参数：pid - 子进程号，cmd - 对应的命令
+ * 返回：作业指针，失败返回 NULL
+ */
+Job* job_add(pid_t pid, Command *cmd);
+
+/**
+ * job_wait - 等待前台作业结束
+ * 
+ * 功能：在 pidfd 上 poll 等待进程结束，回收后从作业表移除；
+ *       交互时把终端交给作业，作业被挂起时转为后台的已停止作业
+ * 参数：job - 作业指针，status - 输出参数，保存 wait 状态
+ * 返回：0 表示成功，1 表示超时，2 表示作业已停止，-1 表示失败
+ */
+int job_wait(Job *job, int *status);
+
+/**
+ * job_wait_pid - 等待不在作业表中的前台子进程
+ * 
+ * 功能：用于管道各段和子 shell，它们被挂起时立即继续执行
+ * 参数：pid - 子进程号，status - 输出参数，保存 wait 状态
+ * 返回：0 表示成功，-1 表示失败
+ */
+int job_wait_pid(pid_t pid, int *status);
+
+/**
+ * job_signal - 向作业发送信号
+ * 
+ * 功能：通过 pidfd_send_signal 发送信号，不支持时退化为 kill
+ * 参数：job - 作业指针，sig - 信号编号
+ * 返回：0 表示成功，-1 表示失败
+ */
+int job_signal(Job *job, int sig);
+
+/**
+ * jobs_reap - 回收已结束的后台作业
+ * 
+ * 功能：通过 epoll 取出就绪的 pidfd 并回收，打印完成信息
+ * 参数：timeout - 超时毫秒数，0 表示不阻塞，-1 表示一直等待
+ * 返回：回收的作业数量
+ */
+int jobs_reap(int timeout);
+
+/**
+ * jobs_background_count - 统计运行中的后台作业数量
+ * 
+ * 功能：返回作业表中后台作业的数量
+ * 参数：无
+ * 返回：后台作业数量
+ */
+int jobs_background_count();
+
+/**
+ * jobs_forget - 在子进程中丢弃继承的作业表
+ * 
+ * 功能：关闭继承的 pidfd 和 epoll 实例（epoll 实例与父进程共享），
+ *       不影响父进程中的作业
+ * 参数：无
+ * 返回：无
+ */
+void jobs_forget();
+
+/**
+ * job_control_init - 开启交互式作业控制
+ * 
+ * 功能：标准输入是控制终端时，shell 自成进程组并取得终端，
+ *       忽略 SIGQUIT、SIGTSTP、SIGTTIN、SIGTTOU，SIGINT 只设置中断标志
+ * 参数：无
+ * 返回：无
+ */
+void job_control_init();
+
+/**
+ * job_child_setup - 在子进程中设置进程组和信号
+ * 
+ * 功能：作业控制开启时加入指定进程组，前台作业取得终端，
+ *       信号处理恢复为默认，exec 之前调用
+ * 参数：pgid - 进程组号，0 表示自成进程组；foreground - 是否为前台作业
+ * 返回：无
+ */
+void job_child_setup(pid_t pgid, int foreground);
+
+/**
+ * job_set_group - 在父进程中设置子进程的进程组
+ * 
+ * 功能：与子进程中的 job_child_setup 重复设置，避免两者之间的竞争
+ * 参数：pid - 子进程号，pgid - 进程组号（0 表示自成进程组），
+ *       foreground - 是否把终端交给该进程组
+ * 返回：无
+ */
+void job_set_group(pid_t pid, pid_t pgid, int foreground);
+
+/**
+ * job_foreground_done - 前台子进程结束后收回终端
+ * 
+ * 功能：子进程被信号终止时恢复终端设置，被 SIGINT 终止时设置中断标志
+ * 参数：status - 子进程的 wait 状态
+ * 返回：无
+ */
+void job_foreground_done(int status);
+
+/**
+ * job_interrupted - 查询是否收到了 Ctrl-C
+ * 
+ * 功能：循环和命令列表据此停止执行
+ * 参数：无
+ * 返回：1 表示已中断，0 表示未中断
+ */
+int job_interrupted();
+
+/**
+ * job_interrupt_clear - 清除中断标志
+ * 
+ * 功能：每条命令执行之前调用
+ * 参数：无
+ * 返回：无
+ */
+void job_interrupt_clear();
+
+/**
+ * cmd_timeout - 限时执行命令
+ * 
+ * 功能：在限定时间内执行外部程序，超时后向其进程组发送 SIGTERM，
+ *       仍未结束则发送 SIGKILL
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败或超时
+ */
+int cmd_timeout(Command *cmd);
+
+/**
+ * cmd_acct - 命令资源统计开关
+ * 
+ * 功能：开启后每个外部命令结束时向标准错误输出一行资源统计
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_acct(Command *cmd);
+
+/**
+ * acct_is_enabled - 查询资源统计是否开启
+ * 
+ * 功能：返回 acct 命令设置的开关状态
+ * 参数：无
+ * 返回：1 表示开启，0 表示关闭
+ */
+int acct_is_enabled();
+
+/**
+ * cmd_jobs - 列出后台作业命令
+ * 
+ * 功能：列出仍在运行的后台作业
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_jobs(Command *cmd);
+
+/**
+ * cmd_wait - 等待后台作业命令
+ * 
+ * 功能：等待所有后台作业结束
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_wait(Command *cmd);
+
+/**
+ * cmd_fg - 把作业调到前台命令
+ * 
+ * 功能：继续已停止或后台运行的作业，并等待其结束
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_fg(Command *cmd);
+
+/**
+ * cmd_bg - 在后台继续作业命令
+ * 
+ * 功能：向已停止的作业发送 SIGCONT
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_bg(Command *cmd);
+
+/* ========== 函数原型声明（resource.c 中实现） ========== */
+
+/**
+ * cmd_ulimit - 子进程资源限制命令
+ * 
+ * 功能：设置或显示子进程的 CPU 时间、地址空间和打开文件数限制
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_ulimit(Command *cmd);
+
+/**
+ * apply_child_limits - 在子进程中应用资源限制
+ * 
+ * 功能：在 exec 之前通过 prlimit 应用 ulimit 设置的限制
+ * 参数：无
+ * 返回：0 表示成功，-1 表示失败
+ */
+int apply_child_limits();
+
+/**
+ * cmd_cgroup - cgroup 资源隔离命令
+ * 
+ * 功能：开启或关闭 cgroup v2 隔离，设置 cpu.max、memory.max、io.weight
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_cgroup(Command *cmd);
+
+/**
+ * cgroup_prepare_job - 为即将启动的作业准备 cgroup
+ * 
+ * 功能：按作业模式创建新的 cgroup 并写入限制，按批处理模式复用同一个 cgroup
+ * 参数：path - 输出参数，保存作业独占的 cgroup 目录（批处理模式为空串）
+ *       size - path 缓冲区大小
+ * 返回：cgroup.procs 的文件描述符，未开启或失败时返回 -1
+ */
+int cgroup_prepare_job(char *path, size_t size);
+
+/**
+ * cgroup_enter - 在子进程中加入 cgroup
+ * 
+ * 功能：向 cgroup.procs 写入 0，把当前进程移入该 cgroup
+ * 参数：procs_fd - cgroup_prepare_job 返回的文件描述符
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cgroup_enter(int procs_fd);
+
+/**
+ * child_enter_job - 在子进程中加入作业 cgroup，应用资源限制和 CPU/NUMA 放置
+ * 
+ * 功能：外部程序 exec 之前调用，execute_external 和管道的各段共用
+ * 参数：cgroup_fd - cgroup_prepare_job 返回的文件描述符，-1 表示不隔离，
+ *       pl - affinity_choose 选择的放置方案
+ * 返回：0 表示成功，-1 表示失败
+ */
+int child_enter_job(int cgroup_fd, Placement *pl);
+
+/**
+ * cgroup_collect - 读取作业 cgroup 的统计并删除该 cgroup
+ * 
+ * 功能：读取 CPU 使用、内存峰值和压力信息，然后尝试删除目录
+ * 参数：path - cgroup 目录，stats - 输出参数
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cgroup_collect(const char *path, CgroupStats *stats);
+
+/**
+ * cgroup_shutdown - 退出时清理 cgroup
+ * 
+ * 功能：报告批处理模式 cgroup 的统计，删除 shell 创建的 cgroup 目录
+ * 参数：无
+ * 返回：无
+ */
+void cgroup_shutdown();
+
+/**
+ * cmd_taskset - 指定 CPU 亲和性执行命令
+ * 
+ * 功能：taskset -c CPULIST command 或 taskset MASK command
+ * 参数：cmd - Command 结构体指针
+ * 返回：命令的执行结果，参数错误返回 -1
+ */
+int cmd_taskset(Command *cmd);
+
+/**
+ * cmd_affinity - CPU/NUMA 放置策略命令
+ * 
+ * 功能：设置作业的自动放置策略：off、compact 或 spread
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_affinity(Command *cmd);
+
+/**
+ * affinity_choose - 为即将启动的作业选择放置方案
+ * 
+ * 功能：优先使用 taskset 指定的 CPU 集合，否则按当前策略选择
+ * 参数：cmd - Command 结构体指针（可为 NULL，表示没有 taskset），pl - 输出参数
+ * 返回：无
+ */
+void affinity_choose(Command *cmd, Placement *pl);
+
+/**
+ * affinity_apply - 在子进程中应用放置方案
+ * 
+ * 功能：在 exec 之前设置 CPU 亲和性和内存策略
+ * 参数：pl - 放置方案
+ * 返回：0 表示成功，-1 表示失败
+ */
+int affinity_apply(Placement *pl);
+
+/* ========== 函数原型声明（lineedit.c 中实现） ========== */
+
+/**
+ * line_edit - 读取一行交互输入
+ * 
+ * 功能：在终端原始模式下编辑命令行，支持光标移动、kill/yank、
+ *       历史浏览和 Ctrl-R 反向搜索
+ * 参数：prompt - 提示符
+ * 返回：命令字符串指针，输入结束返回 NULL
+ */
+char* line_edit(const char *prompt);
+
+/**
+ * line_edit_clear - 清除正在编辑的命令行
+ * 
+ * 功能：编辑命令行时输出后台作业的内容之前调用，命令行在输出之后重绘；
+ *       没有在编辑时不做任何事
+ * 参数：无
+ * 返回：无
+ */
+void line_edit_clear();
+
+/* ========== 函数原型声明（history.c 中实现） ========== */
+
+/**
+ * history_load - 加载历史文件
+ * 
+ * 功能：mmap 历史文件并建立行索引，只在第一次调用时执行
+ * 参数：无
+ * 返回：0 表示成功，-1 表示没有可用的历史文件
+ */
+int history_load();
+
+/**
+ * history_add - 添加一条历史记录
+ * 
+ * 功能：记录到内存索引并立即追加到历史文件
+ * 参数：line - 命令行
+ * 返回：无
+ */
+void history_add(const char *line);
+
+/**
+ * history_count - 获取历史记录数量
+ * 
+ * 功能：返回已加载和本次新增的记录总数
+ * 参数：无
+ * 返回：记录数量
+ */
+int history_count();
+
+/**
+ * history_get - 获取一条历史记录
+ * 
+ * 功能：按序号返回记录内容，内容不以 '\0' 结尾
+ * 参数：index - 序号（0 为最早），len - 输出参数，保存长度
+ * 返回：记录内容，序号无效返回 NULL
+ */
+const char* history_get(int index, int *len);
+
+/**
+ * history_search - 反向搜索历史记录
+ * 
+ * 功能：从 start 开始向前查找包含 query 的记录
+ * 参数：query - 子串，start - 起始序号
+ * 返回：匹配的序号，未找到返回 -1
+ */
+int history_search(const char *query, int start);
+
+/**
+ * cmd_history - 显示命令历史
+ * 
+ * 功能：显示最近的历史记录
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_history(Command *cmd);
+
+/* ========== 函数原型声明（complete.c 中实现） ========== */
+
+/**
+ * complete_word - 计算 Tab 补全内容
+ * 
+ * 功能：补全光标所在单词：命令位置补全内部命令和 PATH 中的程序，
+ *       '$' 开头补全环境变量名，其余补全文件路径
+ * 参数：line - 命令行，pos - 光标偏移，insert - 输出参数，保存应插入的内容，
+ *       size - 缓冲区大小
+ * 返回：匹配数量
+ */
+int complete_word(const char *line, int pos, char *insert, size_t size);
+
+/**
+ * complete_list - 列出补全候选项
+ * 
+ * 功能：按终端宽度分列显示光标所在单词的候选项
+ * 参数：line - 命令行，pos - 光标偏移，cols - 终端列数
+ * 返回：无
+ */
+void complete_list(const char *line, int pos, int cols);
+
+/**
+ * complete_add_command - 向补全的命令表加入命令名
+ * 
+ * 功能：供 enable -f 加载命令后调用
+ * 参数：name - 命令名
+ * 返回：无
+ */
+void complete_add_command(const char *name);
+
+/**
+ * complete_remove_command - 从补全的命令表移除命令名
+ * 
+ * 参数：name - 命令名
+ * 返回：无
+ */
+void complete_remove_command(const char *name);
+
+/* ========== 函数原型声明（prompt.c 中实现） ========== */
+
+/**
+ * display_prompt - 显示命令提示符
+ * 
+ * 功能：按提示符格式生成提示符，用一次 write 输出
+ * 参数：无
+ * 返回：无
+ */
+void display_prompt();
+
+/**
+ * prompt_text - 生成提示符文本
+ * 
+ * 功能：返回缓存的提示符，相关字段变化时才重新生成，供行编辑器重绘使用
+ * 参数：无
+ * 返回：提示符字符串（静态缓冲区）
+ */
+const char* prompt_text();
+
+/**
+ * prompt_invalidate_cwd - 使当前目录缓存失效
+ * 
+ * 功能：cd 之后调用，当前目录和 git 分支在下次显示时重新计算
+ * 参数：无
+ * 返回：无
+ */
+void prompt_invalidate_cwd();
+
+/**
+ * prompt_command_done - 记录命令结果
+ * 
+ * 功能：保存上一条命令的退出状态和耗时，供 %s、%t 字段使用
+ * 参数：status - 退出状态，elapsed_ms - 耗时（毫秒）
+ * 返回：无
+ */
+void prompt_command_done(int status, long long elapsed_ms);
+
+/**
+ * cmd_prompt - 提示符格式命令
+ * 
+ * 功能：显示、设置或恢复默认提示符格式
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_prompt(Command *cmd);
+
+/* ========== 函数原型声明（parser.c 中实现） ========== */
+
+/**
+ * parse_command - 解析命令文本
+ * 
+ * 功能：把可能包含多行的命令文本解析为语法树，
+ *       识别 ; & && || | ( ) { } 和重定向符号（<、>、>>）
+ * 参数：text - 命令文本，tree - 输出参数，保存语法树（空文本为 NULL）
+ * 返回：PARSE_OK、PARSE_INCOMPLETE 或 PARSE_ERROR
+ */
+int parse_command(const char *text, Node **tree);
+
+/**
+ * parse_resolve - 解析命令文本并返回展开别名后的文本
+ * 
+ * 功能：与 parse_command 相同，另外输出展开别名后的完整文本
+ * 参数：text - 命令文本，tree - 输出参数，保存语法树，
+ *       resolved - 输出参数，保存展开后的文本（需要 free）
+ * 返回：PARSE_OK、PARSE_INCOMPLETE 或 PARSE_ERROR
+ */
+int parse_resolve(const char *text, Node **tree, char **resolved);
+
+/**
+ * node_free - 释放语法树
+ * 
+ * 功能：释放节点及其子树和列表中的后续项
+ * 参数：node - 根节点，可以为 NULL
+ * 返回：无
+ */
+void node_free(Node *node);
+
+/* ========== 函数原型声明（exec.c 中实现） ========== */
+
+/**
+ * execute_tree - 执行语法树
+ * 
+ * 功能：依次执行命令列表中的各项，处理 && || 短路、管道、
+ *       组合命令和后台执行
+ * 参数：list - 命令列表的第一项
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+int execute_tree(Node *list);
+
+/**
+ * cmd_break - 跳出循环
+ * 
+ * 功能：break [n]，跳出 n 层循环
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示不在循环中
+ */
+int cmd_break(Command *cmd);
+
+/**
+ * cmd_continue - 继续下一轮循环
+ * 
+ * 功能：continue [n]，继续第 n 层循环的下一轮
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示不在循环中
+ */
+int cmd_continue(Command *cmd);
+
+/**
+ * cmd_return - 从函数返回
+ * 
+ * 功能：return [n]，结束当前函数，n 为函数的退出状态
+ * 参数：cmd - Command 结构体指针
+ * 返回：n 为 0 时返回 0，否则返回 -1
+ */
+int cmd_return(Command *cmd);
+
+/**
+ * cmd_shift - 左移位置参数
+ * 
+ * 功能：shift [n]，丢弃前 n 个位置参数
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数不足
+ */
+int cmd_shift(Command *cmd);
+
+/**
+ * cmd_set - 设置 shell 选项
+ * 
+ * 功能：set -e、set -x、set -o pipefail 及对应的 + 形式关闭，
+ *       set -o 列出选项状态
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示选项不合法
+ */
+int cmd_set(Command *cmd);
+
+/**
+ * status_get - 获取最近一条命令的退出状态（$?）
+ * 
+ * 参数：无
+ * 返回：退出状态 0~255
+ */
+int status_get();
+
+/**
+ * status_set - 记录当前命令的退出状态
+ * 
+ * 参数：status - 退出状态，只保留低 8 位
+ * 返回：无
+ */
+void status_set(int status);
+
+/**
+ * status_begin - 开始执行一条命令
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void status_begin();
+
+/**
+ * status_finish - 命令执行完毕，没有记录具体状态时按结果记为 0 或 1
+ * 
+ * 参数：result - 命令的结果
+ * 返回：result
+ */
+int status_finish(int result);
+
+/**
+ * status_from_wait - 把 wait 状态转换为退出状态
+ * 
+ * 参数：wstatus - wait 返回的状态
+ * 返回：退出码，被信号终止或停止时为 128 加信号编号
+ */
+int status_from_wait(int wstatus);
+
+/**
+ * function_find - 查找 shell 函数
+ * 
+ * 功能：供命令分派判断命令名是否为已定义的函数
+ * 参数：name - 函数名
+ * 返回：函数体，未定义返回 NULL
+ */
+Node* function_find(const char *name);
+
+/**
+ * runs_in_shell - 判断命令是否在 shell 进程中执行
+ * 
+ * 功能：函数和内部命令返回 1；timeout、cache、env、taskset 等前缀命令
+ *       用 execute_external 启动其后的命令，和外部程序一样返回 0
+ * 参数：name - 命令名
+ * 返回：1 表示在 shell 进程中执行，0 表示不是
+ */
+int runs_in_shell(const char *name);
+
+/**
+ * function_unset - 删除 shell 函数
+ * 
+ * 功能：供 unset -f 使用
+ * 参数：name - 函数名
+ * 返回：0 表示已删除，-1 表示函数不存在
+ */
+int function_unset(const char *name);
+
+/**
+ * function_call - 调用 shell 函数
+ * 
+ * 功能：以 cmd 的参数作为位置参数执行函数体
+ * 参数：body - 函数体，cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败，-999 表示退出 shell
+ */
+int function_call(Node *body, Command *cmd);
+
+/* ========== 函数原型声明（vars.c 中实现） ========== */
+
+/**
+ * var_valid_name - 检查变量名是否合法
+ * 
+ * 功能：变量名由字母、数字和下划线组成，不以数字开头
+ * 参数：name - 变量名，len - 检查的长度（-1 表示整个字符串）
+ * 返回：1 表示合法，0 表示不合法
+ */
+int var_valid_name(const char *name, int len);
+
+/**
+ * var_get - 获取变量值
+ * 
+ * 功能：先查 shell 变量，再查环境变量
+ * 参数：name - 变量名
+ * 返回：变量值，未定义返回 NULL
+ */
+const char* var_get(const char *name);
+
+/**
+ * var_set - 设置变量
+ * 
+ * 功能：已在环境中的变量更新环境，其他保存为 shell 变量
+ * 参数：name - 变量名，value - 变量值
+ * 返回：0 表示成功，-1 表示失败
+ */
+int var_set(const char *name, const char *value);
+
+/**
+ * var_unset - 删除变量
+ * 
+ * 功能：删除同名的 shell 变量和环境变量
+ * 参数：name - 变量名
+ * 返回：无
+ */
+void var_unset(const char *name);
+
+/**
+ * var_export - 把变量放入环境
+ * 
+ * 功能：供 export 使用，value 为 NULL 时使用变量的当前值
+ * 参数：name - 变量名，value - 新值（可为 NULL）
+ * 返回：0 表示成功，-1 表示失败
+ */
+int var_export(const char *name, const char *value);
+
+/**
+ * positional_get - 获取位置参数
+ * 
+ * 功能：n 为 0 时返回 $0
+ * 参数：n - 序号
+ * 返回：参数值，超出范围返回 NULL
+ */
+const char* positional_get(int n);
+
+/**
+ * positional_count - 获取位置参数个数
+ * 
+ * 功能：返回 $# 的值
+ * 参数：无
+ * 返回：参数个数
+ */
+int positional_count();
+
+/**
+ * positional_swap - 交换位置参数数组
+ * 
+ * 功能：调用函数前换入新参数，返回后换回原参数
+ * 参数：args - 输入输出参数，参数数组（args[0] 为 $0，以 NULL 结尾），
+ *       count - 输入输出参数，参数个数
+ * 返回：无
+ */
+void positional_swap(char ***args, int *count);
+
+/**
+ * positional_shift - 左移位置参数
+ * 
+ * 功能：丢弃前 n 个位置参数
+ * 参数：n - 个数
+ * 返回：0 表示成功，-1 表示参数不足
+ */
+int positional_shift(int n);
+
+/* ========== 函数原型声明（expand.c 中实现） ========== */
+
+/**
+ * expand_word - 展开单词为一个字符串
+ * 
+ * 功能：变量替换和去除引号，不分割字段、不通配
+ * 参数：raw - 单词原文
+ * 返回：展开结果（需要 free），失败返回 NULL
+ */
+char* expand_word(const char *raw);
+
+/**
+ * expand_pattern - 展开单词为通配模式
+ * 
+ * 功能：与 expand_word 相同，但加引号的通配符被转义，供 case 匹配使用
+ * 参数：raw - 单词原文
+ * 返回：模式（需要 free），失败返回 NULL
+ */
+char* expand_pattern(const char *raw);
+
+/**
+ * expand_fields - 展开单词为若干字段
+ * 
+ * 功能：变量替换、按空白分割未加引号的变量值、文件名通配和去除引号
+ * 参数：raw - 单词原文，out - 输出列表（结果追加到末尾）
+ * 返回：0 表示成功，-1 表示失败
+ */
+int expand_fields(const char *raw, WordList *out);
+
+/**
+ * wordlist_add - 向单词列表追加单词
+ * 
+ * 功能：列表取得 word 的所有权
+ * 参数：list - 单词列表，word - 单词（malloc 分配）
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+int wordlist_add(WordList *list, char *word);
+
+/**
+ * wordlist_free - 释放单词列表
+ * 
+ * 功能：释放所有单词和数组
+ * 参数：list - 单词列表
+ * 返回：无
+ */
+void wordlist_free(WordList *list);
+
+/* ========== 函数原型声明（arith.c 中实现） ========== */
+
+/**
+ * arith_eval - 计算 64 位整数表达式
+ * 
+ * 功能：支持 C 语言的算术、比较、位运算、逻辑运算、条件运算、
+ *       赋值运算（= += 等）、自增自减和逗号运算，变量按整数读取
+ * 参数：expr - 表达式（变量替换已完成），value - 输出参数，保存结果
+ * 返回：0 表示成功，-1 表示表达式错误
+ */
+int arith_eval(const char *expr, long long *value);
+
+/**
+ * cmd_let - 计算算术表达式
+ * 
+ * 功能：依次计算每个参数表达式
+ * 参数：cmd - Command 结构体指针
+ * 返回：最后一个表达式的值非 0 时返回 0，否则返回 -1
+ */
+int cmd_let(Command *cmd);
+
+/* ========== 函数原型声明（builtins.c 中实现） ========== */
+
+/**
+ * cmd_true - 返回成功（true 和 :）
+ * 
+ * 参数：cmd - Command 结构体指针
+ * 返回：0
+ */
+int cmd_true(Command *cmd);
+
+/**
+ * cmd_false - 返回失败
+ * 
+ * 参数：cmd - Command 结构体指针
+ * 返回：-1
+ */
+int cmd_false(Command *cmd);
+
+/**
+ * cmd_test - 条件测试（test 和 [）
+ * 
+ * 功能：文件测试、字符串和整数比较，支持 ! -a -o 和括号
+ * 参数：cmd - Command 结构体指针
+ * 返回：条件为真返回 0，否则返回 -1
+ */
+int cmd_test(Command *cmd);
+
+/**
+ * cmd_printf - 格式化输出
+ * 
+ * 功能：按格式输出参数，参数多于转换时重复使用格式
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_printf(Command *cmd);
+
+/**
+ * cmd_read - 从标准输入读取一行并赋给变量
+ * 
+ * 功能：read [-r] [-p 提示] [变量...]
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示文件结束或失败
+ */
+int cmd_read(Command *cmd);
+
+/**
+ * cmd_export - 把变量放入环境
+ * 
+ * 功能：export [名字[=值]...]，没有参数时列出环境变量
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_export(Command *cmd);
+
+/**
+ * cmd_unset - 删除变量或函数
+ * 
+ * 功能：unset [-v|-f] 名字...
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_unset(Command *cmd);
+
+/**
+ * cmd_pwd - 显示当前工作目录
+ * 
+ * 功能：pwd [-L|-P]
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_pwd(Command *cmd);
+
+/**
+ * cmd_env - 在修改后的环境中执行命令
+ * 
+ * 功能：env [-i] [-u 名字]... [名字=值]... [命令 [参数...]]，没有命令时显示环境
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_env(Command *cmd);
+
+/* ========== 函数原型声明（plugin.c 中实现） ========== */
+
+/**
+ * plugin_find - 查找 enable -f 加载的命令
+ * 
+ * 参数：name - 命令名
+ * 返回：分派表项，未加载返回 NULL
+ */
+const Builtin* plugin_find(const char *name);
+
+/**
+ * plugin_name - 按序号获取已加载的命令名
+ * 
+ * 参数：index - 序号，从 0 开始
+ * 返回：命令名，超出范围时返回 NULL
+ */
+const char* plugin_name(int index);
+
+/**
+ * cmd_enable - 加载、卸载或列出内部命令
+ * 
+ * 功能：enable [-f 库 命令名... | -d 命令名...]
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_enable(Command *cmd);
+
+/* ========== 函数原型声明（alias.c 中实现） ========== */
+
+/**
+ * alias_get - 获取别名的替换文本
+ * 
+ * 功能：供语法分析展开别名，没有定义别名时不查表
+ * 参数：name - 别名
+ * 返回：替换文本，不是别名返回 NULL
+ */
+const char* alias_get(const char *name);
+
+/**
+ * cmd_alias - 定义或显示别名
+ * 
+ * 功能：alias [名字[=值]...]
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_alias(Command *cmd);
+
+/**
+ * cmd_unalias - 删除别名
+ * 
+ * 功能：unalias [-a] 名字...
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示别名不存在
+ */
+int cmd_unalias(Command *cmd);
+
+/* ========== 函数原型声明（help.c 中实现） ========== */
+
+/**
+ * cmd_help - 显示帮助命令
+ * 
+ * 功能：显示编译时嵌入的用户手册；help 主题 只显示对应章节，
+ *       标准输出是终端时分页
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示没有找到主题
+ */
+int cmd_help(Command *cmd);
+
+/* ========== 函数原型声明（cache.c 中实现） ========== */
+
+/**
+ * cmd_cache - 缓存外部程序的执行结果
+ * 
+ * 功能：cache [-i 文件]... [-e 变量]... command [args...]，键命中时恢复
+ *       保存的输出和退出状态而不执行程序；cache 显示统计，
+ *       cache -c 清空，cache -m 大小 设置大小上限
+ * 参数：cmd - Command 结构体指针
+ * 返回：命令的执行结果，参数错误返回 -1
+ */
+int cmd_cache(Command *cmd);
+
+/* ========== 函数原型声明（journal.c 中实现） ========== */
+
+/**
+ * journal_open - 开启批处理日志
+ * 
+ * 功能：resume 为 0 时清空日志，为 1 时读入已完成的命令并追加记录
+ * 参数：path - 日志文件路径，resume - 是否从日志恢复
+ * 返回：0 表示成功，-1 表示失败
+ */
+int journal_open(const char *path, int resume);
+
+/**
+ * journal_active - 判断是否开启了批处理日志
+ * 
+ * 参数：无
+ * 返回：1 表示开启，0 表示没有
+ */
+int journal_active();
+
+/**
+ * journal_skip - 判断命令是否已在上次运行中成功完成
+ * 
+ * 参数：offset - 命令在批处理文件中的偏移，text - 命令文本，tree - 解析后的命令
+ * 返回：1 表示应跳过，0 表示需要执行
+ */
+int journal_skip(long long offset, const char *text, Node *tree);
+
+/**
+ * journal_record - 记录一条已执行的命令（偏移、退出状态、耗时）
+ * 
+ * 参数：offset - 命令在批处理文件中的偏移，text - 命令文本，
+ *       status - 退出状态，elapsed_ms - 耗时（毫秒）
+ * 返回：无
+ */
+void journal_record(long long offset, const char *text, int status, long long elapsed_ms);
+
+/**
+ * journal_close - 同步并关闭日志
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void journal_close();
+
+/* ========== 函数原型声明（mux.c 中实现） ========== */
+
+/**
+ * mux_pipes - 为后台作业创建输出管道（jobout 关闭时不创建）
+ * 
+ * 参数：fds - 输出参数，标准输出和标准错误管道的读端、写端
+ * 返回：1 表示已创建，0 表示作业直接输出
+ */
+int mux_pipes(int fds[4]);
+
+/**
+ * mux_abort - fork 失败时关闭 mux_pipes 创建的管道
+ * 
+ * 参数：fds - mux_pipes 创建的管道
+ * 返回：无
+ */
+void mux_abort(int fds[4]);
+
+/**
+ * mux_child - 在子进程中把标准输出和标准错误接到管道
+ * 
+ * 参数：fds - mux_pipes 创建的管道
+ * 返回：无
+ */
+void mux_child(int fds[4]);
+
+/**
+ * mux_attach - 在 shell 中登记作业的输出管道
+ * 
+ * 参数：id - 作业号，cmdline - 命令行，fds - mux_pipes 创建的管道
+ * 返回：无
+ */
+void mux_attach(int id, const char *cmdline, int fds[4]);
+
+/**
+ * mux_fd - 获取监听作业输出的 epoll 描述符
+ * 
+ * 参数：无
+ * 返回：描述符，没有需要监听的输出时返回 -1
+ */
+int mux_fd();
+
+/**
+ * mux_poll - 读出就绪的作业输出并转发
+ * 
+ * 参数：timeout - epoll 超时（毫秒），0 表示立即返回
+ * 返回：处理的事件数
+ */
+int mux_poll(int timeout);
+
+/**
+ * mux_drain - 作业结束时读出其管道中剩余的输出
+ * 
+ * 参数：id - 作业号
+ * 返回：无
+ */
+void mux_drain(int id);
+
+/**
+ * mux_job_done - 作业结束，完成信息排在作业的输出之后显示
+ * 
+ * 参数：id - 作业号，message - 完成信息（可为 NULL）
+ * 返回：1 表示完成信息已排入，0 表示调用者直接显示
+ */
+int mux_job_done(int id, const char *message);
+
+/**
+ * mux_shutdown - shell 退出前输出所有缓冲的内容
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void mux_shutdown();
+
+/**
+ * mux_forget - 在子进程中丢弃继承的管道和 epoll 实例
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void mux_forget();
+
+/**
+ * cmd_jobout - 设置后台作业的输出方式
+ * 
+ * 功能：jobout off|line|group；line 逐行输出并加作业号前缀，
+ *       group 按作业集中输出；不带参数时显示当前方式
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数错误
+ */
+int cmd_jobout(Command *cmd);
+/* ========== 函数原型声明（stats.c 中实现） ========== */
+
+/* 计数器，stats_add 的参数 */
+#define STAT_PARSED         0   /* 解析的命令行 */
+#define STAT_BUILTINS       1   /* 执行的内部命令 */
+#define STAT_FUNCTIONS      2   /* 调用的函数 */
+#define STAT_EXTERNALS      3   /* 启动的外部程序（管道各段除外） */
+#define STAT_FORKS          4   /* fork 次数 */
+#define STAT_REAPED         5   /* 回收的子进程 */
+#define STAT_REDIRECTIONS   6   /* 命令的 < > >> 重定向 */
+#define STAT_BUILTIN_BYTES  7   /* 内部命令输出的字节数 */
+#define STAT_COUNT          8
+
+/* 耗时分布，stats_latency 的参数 */
+#define LATENCY_SPAWN   0   /* fork 的耗时 */
+#define LATENCY_WAIT    1   /* 等待前台子进程的耗时 */
+#define LATENCY_COUNT   2
+
+/**
+ * stats_add - 增加计数器
+ * 
+ * 参数：counter - STAT_* 之一，n - 增加的数量
+ * 返回：无
+ */
+void stats_add(int counter, long long n);
+
+/**
+ * stats_clock - 获取单调时钟的当前时间
+ * 
+ * 参数：无
+ * 返回：纳秒
+ */
+long long stats_clock();
+
+/**
+ * stats_latency - 记录一次操作的耗时
+ * 
+ * 参数：which - LATENCY_* 之一，ns - 耗时（纳秒）
+ * 返回：无
+ */
+void stats_latency(int which, long long ns);
+
+/**
+ * stats_fork - fork 并记录次数和耗时
+ * 
+ * 参数：无
+ * 返回：同 fork
+ */
+pid_t stats_fork();
+
+/**
+ * stats_builtin_begin - 内部命令开始执行，stdout 换成计数流
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void stats_builtin_begin();
+
+/**
+ * stats_builtin_end - 内部命令执行结束，刷新计数流并恢复原来的 stdout
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void stats_builtin_end();
+
+/**
+ * stats_dump_at_exit - 设置退出时写入统计的 JSON 文件
+ * 
+ * 参数：path - 文件路径，"-" 表示标准错误，NULL 表示不写入
+ * 返回：无
+ */
+void stats_dump_at_exit(const char *path);
+
+/**
+ * stats_shutdown - 退出时按 --stats 写入 JSON
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void stats_shutdown();
+
+/**
+ * cmd_stats - 显示 shell 的运行统计
+ * 
+ * 功能：stats 以表格显示，stats -j 以 JSON 显示，stats -r 清零
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数错误
+ */
+int cmd_stats(Command *cmd);
+/* ========== 函数原型声明（trace.c 中实现） ========== */
+
+/**
+ * trace_open - 开启跟踪标记文件（--trace）
+ * 
+ * 参数：path - 文件路径
+ * 返回：0 表示成功，-1 表示失败
+ */
+int trace_open(const char *path);
+
+/**
+ * trace_active - 判断是否开启了跟踪标记文件
+ * 
+ * 参数：无
+ * 返回：1 表示开启，0 表示没有
+ */
+int trace_active();
+
+/**
+ * trace_mark - 写入一个带时间戳的标记，由 trace.h 的 TRACE 调用
+ * 
+ * 参数：event - 跟踪点名称，num - 整数参数，text - 文本参数
+ * 返回：无
+ */
+void trace_mark(const char *event, long long num, const char *text);
+
+/**
+ * trace_close - 关闭跟踪标记文件
+ * 
+ * 参数：无
+ * 返回：无
+ */
+void trace_close();
+
 #endif /* MYSHELL_H */
 
@@ -0,0 +1,76 @@
+/*
+ * myshell_plugin.h - MyShell 可加载内部命令接口
+ *
+ * 功能：定义插件共享库与 MyShell 之间的 C 接口。插件不需要包含
+ *       myshell.h，只依赖本文件中的类型，MyShell 内部结构变化不影响已编译的插件。
+ *       接口有不兼容的修改时 MYSHELL_PLUGIN_ABI 加一
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ *
+ * 编写插件：导出一个名为 myshell_plugin_<命令名> 的 MyshellPlugin 变量，例如
+ *
+ *     #include "myshell_plugin.h"
+ *
+ *     static int hello_run(const MyshellCall *call) {
+ *         dprintf(call->out_fd, "hello %s\n", call->argc > 1 ? call->argv[1] : "world");
+ *         return 0;
+ *     }
+ *
+ *     MyshellPlugin myshell_plugin_hello = {
+ *         MYSHELL_PLUGIN_ABI, "hello", hello_run, "hello [名字]"
+ *     };
+ *
+ * 编译：gcc -shared -fPIC -o hello.so hello.c
+ * 加载：enable -f ./hello.so hello
+ */
+
+#ifndef MYSHELL_PLUGIN_H
+#define MYSHELL_PLUGIN_H
+
+/* 接口版本号 */
+#define MYSHELL_PLUGIN_ABI 1
+
+/* 插件变量名前缀，完整名称为前缀加命令名 */
+#define MYSHELL_PLUGIN_PREFIX "myshell_plugin_"
+
+/**
+ * MyshellCall 结构体 - 一次命令调用
+ *
+ * 字段说明：
+ *   abi_version  - 调用方的接口版本
+ *   argc         - 参数个数（含命令名）
+ *   argv         - 参数数组，以 NULL 结尾，argv[0] 为命令名
+ *   in_fd        - 标准输入（已应用重定向）
+ *   out_fd       - 标准输出（已应用重定向）
+ *   err_fd       - 标准错误
+ *   get_var      - 读取 shell 变量，未定义返回 NULL
+ *   set_var      - 设置 shell 变量，成功返回 0
+ */
+typedef struct MyshellCall {
+    int abi_version;
+    int argc;
+    char **argv;
+    int in_fd;
+    int out_fd;
+    int err_fd;
+    const char *(*get_var)(const char *name);
+    int (*set_var)(const char *name, const char *value);
+} MyshellCall;
+
+/**
+ * MyshellPlugin 结构体 - 插件导出的命令描述
+ *
+ * 字段说明：
+ *   abi_version  - 编译插件时的接口版本，必须为 MYSHELL_PLUGIN_ABI
+ *   name         - 命令名
+ *   run          - 处理函数，在 shell 进程中调用，返回 0 表示成功
+ *   usage        - 用法说明（可为 NULL），enable 列出命令时显示
+ */
+typedef struct MyshellPlugin {
+    int abi_version;
+    const char *name;
+    int (*run)(const MyshellCall *call);
+    const char *usage;
+} MyshellPlugin;
+
+#endif /* MYSHELL_PLUGIN_H */
@@ -0,0 +1,1153 @@
+/*
+ * parser.c - MyShell 语法分析
+ *
+ * 功能：把命令文本解析为语法树。支持的文法：
+ *
+ *       列表     := 与或 ((';' | '&' | 换行) 与或)*
+ *       与或     := 管道 (('&&' | '||') 管道)*
+ *       管道     := 命令 ('|' 命令)*
+ *       命令     := 简单命令 | 复合命令 重定向* | 函数定义
+ *       复合命令 := '(' 列表 ')' | '{' 列表 '}'
+ *                 | if 列表 then 列表 (elif 列表 then 列表)* [else 列表] fi
+ *                 | while 列表 do 列表 done | until 列表 do 列表 done
+ *                 | for 名字 [in 单词*] do 列表 done
+ *                 | case 单词 in (模式 ('|' 模式)* ')' [列表] ';;')* esac
+ *       函数定义 := 名字 '(' ')' 复合命令 | function 名字 复合命令
+ *       简单命令 := (单词 | 重定向)+
+ *
+ *       单词在语法树中保留原文（含引号），执行时才展开，
+ *       因此同一棵树可以反复执行。命令位置上未加引号的别名在分析时
+ *       替换为其文本，再继续分析
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include "trace.h"
+
+/* 记号类型 */
+#define TOK_EOF      0   /* 输入结束 */
+#define TOK_WORD     1   /* 单词 */
+#define TOK_NEWLINE  2   /* 换行 */
+#define TOK_SEMI     3   /* ; */
+#define TOK_AMP      4   /* & */
+#define TOK_AND      5   /* && */
+#define TOK_OR       6   /* || */
+#define TOK_PIPE     7   /* | */
+#define TOK_LPAREN   8   /* ( */
+#define TOK_RPAREN   9   /* ) */
+#define TOK_LESS     10  /* < */
+#define TOK_GREAT    11  /* > */
+#define TOK_DGREAT   12  /* >> */
+#define TOK_DSEMI    13  /* ;; */
+
+/* 同时展开中的别名层数上限 */
+#define MAX_ALIAS_DEPTH 64
+
+/* 一条命令中别名展开的总次数上限 */
+#define MAX_ALIAS_EXPANSIONS 10000
+
+/**
+ * AliasFrame 结构体 - 一个正在展开的别名
+ *
+ * 字段说明：
+ *   name  - 别名
+ *   end   - 替换文本在源文本中的结束位置；扫描到这里之前该别名不再展开
+ */
+typedef struct {
+    char *name;
+    int end;
+} AliasFrame;
+
+/**
+ * Parser 结构体 - 语法分析状态
+ *
+ * 字段说明：
+ *   text       - 源文本
+ *   pos        - 下一个记号的扫描位置
+ *   type       - 当前记号类型
+ *   start      - 当前记号在源文本中的起始位置
+ *   word       - 当前单词的原文（type 为 TOK_WORD 时有效）
+ *   incomplete - 输入在引号或复合命令中途结束，需要继续读取
+ *   error      - 遇到语法错误
+ *   buffer     - 展开别名后的文本（text 指向它），未展开时为 NULL
+ *   frames     - 正在展开的别名，防止别名递归展开自己
+ *   frame_count - frames 中的个数
+ *   alias_next - 别名文本以空白结尾时，从该位置开始的下一个单词也检查别名
+ *   expansions - 已展开的次数
+ */
+typedef struct {
+    const char *text;
+    int pos;
+    int type;
+    int start;
+    char *word;
+    int incomplete;
+    int error;
+    char *buffer;
+    AliasFrame frames[MAX_ALIAS_DEPTH];
+    int frame_count;
+    int alias_next;
+    int expansions;
+} Parser;
+
+static Node* parse_list(Parser *p);
+
+/* ========== 词法分析 ========== */
+
+/**
+ * is_operator_char - 判断字符是否结束一个未加引号的单词
+ */
+static int is_operator_char(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\0' ||
+           strchr(";&|<>()", c) != NULL;
+}
+
+/**
+ * scan_word - 扫描一个单词，返回结束位置
+ *
+ * 功能：引号、反斜杠和 $( ) 内的特殊字符不结束单词。
+ *       引号或括号未闭合时设置 incomplete
+ * 参数：p - 分析状态，pos - 起始位置
+ * 返回：单词结束位置
+ */
+static int scan_word(Parser *p, int pos) {
+    const char *s = p->text;
+    int depth;
+    char quote;
+
+    while (!is_operator_char(s[pos])) {
+        if (s[pos] == '\\') {
+            if (s[pos + 1] == '\0') {
+                p->incomplete = 1;
+                return pos + 1;
+            }
+            pos += 2;
+        } else if (s[pos] == '\'') {
+            const char *end = strchr(s + pos + 1, '\'');
+            if (end == NULL) {
+                p->incomplete = 1;
+                return strlen(s);
+            }
+            pos = end - s + 1;
+        } else if (s[pos] == '"') {
+            for (pos++; s[pos] != '"'; pos++) {
+                if (s[pos] == '\0') {
+                    p->incomplete = 1;
+                    return pos;
+                }
+                if (s[pos] == '\\' && s[pos + 1] != '\0') {
+                    pos++;
+                }
+            }
+            pos++;
+        } else if (s[pos] == '$' && s[pos + 1] == '(') {
+            /* $( ... ) 和 $(( ... )) 作为单词的一部分，按括号配对 */
+            depth = 0;
+            quote = 0;
+            for (pos++; s[pos] != '\0'; pos++) {
+                if (quote) {
+                    if (s[pos] == quote) {
+                        quote = 0;
+                    }
+                } else if (s[pos] == '\'' || s[pos] == '"') {
+                    quote = s[pos];
+                } else if (s[pos] == '(') {
+                    depth++;
+                } else if (s[pos] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            if (s[pos] == '\0') {
+                p->incomplete = 1;
+                return pos;
+            }
+            pos++;
+        } else {
+            pos++;
+        }
+    }
+    return pos;
+}
+
+/**
+ * advance - 读取下一个记号
+ *
+ * 参数：p - 分析状态
+ */
+static void advance(Parser *p) {
+    const char *s = p->text;
+    int pos = p->pos;
+    int end;
+
+    free(p->word);
+    p->word = NULL;
+
+    /* 跳过空白、续行和注释 */
+    while (1) {
+        if (s[pos] == ' ' || s[pos] == '\t') {
+            pos++;
+        } else if (s[pos] == '\\' && s[pos + 1] == '\n') {
+            pos += 2;
+        } else if (s[pos] == '#') {
+            while (s[pos] != '\0' && s[pos] != '\n') {
+                pos++;
+            }
+        } else {
+            break;
+        }
+    }
+
+    p->start = pos;
+    switch (s[pos]) {
+    case '\0':
+        p->type = TOK_EOF;
+        break;
+    case '\n':
+        p->type = TOK_NEWLINE;
+        pos++;
+        break;
+    case ';':
+        p->type = s[pos + 1] == ';' ? TOK_DSEMI : TOK_SEMI;
+        pos += p->type == TOK_DSEMI ? 2 : 1;
+        break;
+    case '&':
+        p->type = s[pos + 1] == '&' ? TOK_AND : TOK_AMP;
+        pos += p->type == TOK_AND ? 2 : 1;
+        break;
+    case '|':
+        p->type = s[pos + 1] == '|' ? TOK_OR : TOK_PIPE;
+        pos += p->type == TOK_OR ? 2 : 1;
+        break;
+    case '(':
+        p->type = TOK_LPAREN;
+        pos++;
+        break;
+    case ')':
+        p->type = TOK_RPAREN;
+        pos++;
+        break;
+    case '<':
+        p->type = TOK_LESS;
+        pos++;
+        break;
+    case '>':
+        p->type = s[pos + 1] == '>' ? TOK_DGREAT : TOK_GREAT;
+        pos += p->type == TOK_DGREAT ? 2 : 1;
+        break;
+    default:
+        end = scan_word(p, pos);
+        p->type = TOK_WORD;
+        p->word = strndup(s + pos, end - pos);
+        pos = end;
+        break;
+    }
+    p->pos = pos;
+}
+
+/**
+ * alias_expand - 展开当前单词中的别名
+ *
+ * 功能：当前记号是未加引号的别名时，用替换文本改写源文本并重新读取记号，
+ *       直到当前单词不再是别名。替换文本范围内不再展开同一个别名，
+ *       因此 alias ls='ls -F' 不会无限展开
+ * 参数：p - 分析状态（当前记号位于命令位置）
+ */
+static void alias_expand(Parser *p) {
+    const char *value;
+    char *text;
+    int word_end, len, delta;
+    int i;
+
+    while (p->type == TOK_WORD) {
+        /* 已经扫描过的展开不再起作用 */
+        while (p->frame_count > 0 && p->frames[p->frame_count - 1].end <= p->start) {
+            free(p->frames[--p->frame_count].name);
+        }
+
+        if (strpbrk(p->word, "\"'\\$`") != NULL) {
+            return;     /* 加引号的单词不是别名 */
+        }
+        for (i = 0; i < p->frame_count; i++) {
+            if (strcmp(p->frames[i].name, p->word) == 0) {
+                return;
+            }
+        }
+        value = alias_get(p->word);
+        if (value == NULL) {
+            return;
+        }
+        if (p->frame_count == MAX_ALIAS_DEPTH || ++p->expansions > MAX_ALIAS_EXPANSIONS) {
+            fprintf(stderr, "myshell: %s: 别名展开层数过多\n", p->word);
+            return;
+        }
+
+        /* 用替换文本改写源文本 */
+        word_end = p->pos;
+        len = strlen(value);
+        delta = len - (word_end - p->start);
+        text = malloc(strlen(p->text) + delta + 1);
+        if (text == NULL) {
+            perror("myshell");
+            return;
+        }
+        memcpy(text, p->text, p->start);
+        memcpy(text + p->start, value, len);
+        strcpy(text + p->start + len, p->text + word_end);
+        free(p->buffer);
+        p->buffer = text;
+        p->text = text;
+
+        for (i = 0; i < p->frame_count; i++) {
+            p->frames[i].end += delta;
+        }
+        p->frames[p->frame_count].name = p->word;
+        p->frames[p->frame_count].end = p->start + len;
+        p->frame_count++;
+        p->word = NULL;
+
+        if (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) {
+            p->alias_next = p->start + len;
+        }
+
+        p->pos = p->start;
+        advance(p);
+    }
+}
+
+/**
+ * token_name - 当前记号的文本，用于错误提示
+ */
+static const char* token_name(Parser *p) {
+    static const char *names[] = {
+        "文件结束", "", "换行", ";", "&", "&&", "||", "|", "(", ")", "<", ">", ">>", ";;"
+    };
+
+    if (p->type == TOK_WORD) {
+        return p->word;
+    }
+    return names[p->type];
+}
+
+/**
+ * syntax_error - 报告语法错误
+ *
+ * 功能：输入在中途结束时只标记为不完整，由调用者继续读取
+ * 参数：p - 分析状态
+ */
+static void syntax_error(Parser *p) {
+    if (p->error || p->incomplete) {
+        return;
+    }
+    if (p->type == TOK_EOF) {
+        p->incomplete = 1;
+        return;
+    }
+    fprintf(stderr, "myshell: 语法错误: 意外的 '%s'\n", token_name(p));
+    p->error = 1;
+}
+
+/**
+ * is_reserved - 判断当前记号是否为指定的保留字
+ *
+ * 功能：保留字只在命令位置、且未加引号时识别
+ * 参数：p - 分析状态，word - 保留字
+ */
+static int is_reserved(Parser *p, const char *word) {
+    return p->type == TOK_WORD && strcmp(p->word, word) == 0;
+}
+
+/**
+ * at_list_end - 判断当前记号是否结束一个列表
+ *
+ * 功能：文件结束、')'、';;' 以及复合命令的结束保留字都会结束列表
+ */
+static int at_list_end(Parser *p) {
+    static const char *closers[] = {
+        "}", "then", "elif", "else", "fi", "do", "done", "esac", NULL
+    };
+    int i;
+
+    if (p->type == TOK_EOF || p->type == TOK_RPAREN || p->type == TOK_DSEMI) {
+        return 1;
+    }
+    for (i = 0; p->type == TOK_WORD && closers[i] != NULL; i++) {
+        if (strcmp(p->word, closers[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * expect_reserved - 要求当前记号为指定保留字，并跳过它
+ *
+ * 参数：p - 分析状态，word - 保留字
+ * 返回：0 表示成功，-1 表示语法错误
+ */
+static int expect_reserved(Parser *p, const char *word) {
+    if (!is_reserved(p, word)) {
+        syntax_error(p);
+        return -1;
+    }
+    advance(p);
+    return 0;
+}
+
+/**
+ * skip_newlines - 跳过换行
+ */
+static void skip_newlines(Parser *p) {
+    while (p->type == TOK_NEWLINE) {
+        advance(p);
+    }
+}
+
+/* ========== 语法树节点 ========== */
+
+/**
+ * node_new - 分配语法树节点
+ *
+ * 参数：type - 节点类型
+ * 返回：新节点，内存不足时返回 NULL
+ */
+static Node* node_new(int type) {
+    Node *node = calloc(1, sizeof(Node));
+
+    if (node == NULL) {
+        perror("myshell");
+        return NULL;
+    }
+    node->type = type;
+    return node;
+}
+
+/**
+ * node_free - 释放语法树
+ *
+ * 参数：node - 根节点（列表的第一项），可以为 NULL
+ */
+void node_free(Node *node) {
+    Node *next;
+    Redirect *redir, *next_redir;
+    int i;
+
+    while (node != NULL) {
+        next = node->next;
+        if (node->refs > 0) {
+            /* 仍被函数表引用，由最后一个引用者释放 */
+            node->refs--;
+            node = next;
+            continue;
+        }
+        node_free(node->left);
+        node_free(node->right);
+        for (i = 0; i < node->word_count; i++) {
+            free(node->words[i]);
+        }
+        free(node->words);
+        for (redir = node->redirects; redir != NULL; redir = next_redir) {
+            next_redir = redir->next;
+            free(redir->target);
+            free(redir);
+        }
+        node_free(node->alt);
+        free(node->name);
+        free(node->text);
+        free(node);
+        node = next;
+    }
+}
+
+/* ========== 语法分析 ========== */
+
+/**
+ * parse_redirect - 解析一个重定向并追加到节点
+ *
+ * 参数：p - 分析状态（当前记号为重定向符号），node - 所属节点
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int parse_redirect(Parser *p, Node *node) {
+    Redirect *redir, **tail;
+    int type;
+
+    type = p->type == TOK_LESS ? REDIR_IN :
+           p->type == TOK_DGREAT ? REDIR_APPEND : REDIR_OUT;
+    advance(p);
+    if (p->type != TOK_WORD) {
+        syntax_error(p);
+        return -1;
+    }
+
+    redir = malloc(sizeof(Redirect));
+    if (redir == NULL) {
+        perror("myshell");
+        return -1;
+    }
+    redir->type = type;
+    redir->target = p->word;
+    redir->next = NULL;
+    p->word = NULL;
+
+    for (tail = &node->redirects; *tail != NULL; tail = &(*tail)->next) {
+    }
+    *tail = redir;
+
+    advance(p);
+    return 0;
+}
+
+/**
+ * is_redirect - 判断当前记号是否为重定向符号
+ */
+static int is_redirect(Parser *p) {
+    return p->type == TOK_LESS || p->type == TOK_GREAT || p->type == TOK_DGREAT;
+}
+
+/**
+ * parse_simple - 解析简单命令
+ *
+ * 参数：p - 分析状态
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_simple(Parser *p) {
+    Node *node = node_new(NODE_SIMPLE);
+    char **grown;
+    int capacity = 0;
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    while (p->type == TOK_WORD || is_redirect(p)) {
+        if (is_redirect(p)) {
+            if (parse_redirect(p, node) < 0) {
+                node_free(node);
+                return NULL;
+            }
+            continue;
+        }
+
+        if (node->word_count == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            grown = realloc(node->words, capacity * sizeof(char *));
+            if (grown == NULL) {
+                perror("myshell");
+                node_free(node);
+                return NULL;
+            }
+            node->words = grown;
+        }
+        node->words[node->word_count++] = p->word;
+        p->word = NULL;
+        advance(p);
+
+        /* 别名文本以空白结尾：紧随其后的单词也检查别名 */
+        if (p->alias_next > 0 && p->type == TOK_WORD && p->start >= p->alias_next) {
+            p->alias_next = 0;
+            alias_expand(p);
+        }
+    }
+
+    if (node->word_count == 0 && node->redirects == NULL) {
+        syntax_error(p);
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * parse_body - 解析复合命令内部的列表，并要求以指定保留字结束
+ *
+ * 参数：p - 分析状态，closer - 结束保留字（NULL 表示不检查）
+ * 返回：列表，失败返回 NULL
+ */
+static Node* parse_body(Parser *p, const char *closer) {
+    Node *list;
+
+    skip_newlines(p);
+    list = parse_list(p);
+    if (list != NULL && closer != NULL && expect_reserved(p, closer) < 0) {
+        node_free(list);
+        return NULL;
+    }
+    return list;
+}
+
+/**
+ * parse_group - 解析 ( 列表 ) 或 { 列表 }
+ *
+ * 参数：p - 分析状态（当前记号为 '(' 或 '{'），type - NODE_SUBSHELL 或 NODE_BRACE
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_group(Parser *p, int type) {
+    Node *node = node_new(type);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    advance(p);
+    node->left = parse_body(p, type == NODE_BRACE ? "}" : NULL);
+    if (node->left == NULL) {
+        node_free(node);
+        return NULL;
+    }
+
+    if (type == NODE_SUBSHELL) {
+        if (p->type != TOK_RPAREN) {
+            syntax_error(p);
+            node_free(node);
+            return NULL;
+        }
+        advance(p);
+    }
+    return node;
+}
+
+/**
+ * parse_if - 解析 if 或 elif 之后的部分
+ *
+ * 功能：elif 作为 else 分支中嵌套的 if 节点，与外层共用一个 fi
+ * 参数：p - 分析状态（当前记号为 if 或 elif）
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_if(Parser *p) {
+    Node *node = node_new(NODE_IF);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    advance(p);
+    if ((node->left = parse_body(p, "then")) == NULL ||
+        (node->right = parse_body(p, NULL)) == NULL) {
+        node_free(node);
+        return NULL;
+    }
+
+    if (is_reserved(p, "elif")) {
+        node->alt = parse_if(p);
+        if (node->alt == NULL) {
+            node_free(node);
+            return NULL;
+        }
+        return node;
+    }
+    if (is_reserved(p, "else")) {
+        advance(p);
+        node->alt = parse_body(p, NULL);
+        if (node->alt == NULL) {
+            node_free(node);
+            return NULL;
+        }
+    }
+    if (expect_reserved(p, "fi") < 0) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * parse_loop - 解析 while 或 until 循环
+ *
+ * 参数：p - 分析状态（当前记号为 while 或 until），type - NODE_WHILE 或 NODE_UNTIL
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_loop(Parser *p, int type) {
+    Node *node = node_new(type);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    advance(p);
+    if ((node->left = parse_body(p, "do")) == NULL ||
+        (node->right = parse_body(p, "done")) == NULL) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * add_word - 向节点的单词数组追加当前单词
+ *
+ * 参数：p - 分析状态（当前记号为单词），node - 节点，capacity - 数组容量
+ * 返回：0 表示成功，-1 表示内存不足
+ */
+static int add_word(Parser *p, Node *node, int *capacity) {
+    char **grown;
+
+    if (node->word_count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        grown = realloc(node->words, *capacity * sizeof(char *));
+        if (grown == NULL) {
+            perror("myshell");
+            return -1;
+        }
+        node->words = grown;
+    }
+    node->words[node->word_count++] = p->word;
+    p->word = NULL;
+    advance(p);
+    return 0;
+}
+
+/**
+ * parse_for - 解析 for 循环
+ *
+ * 功能：省略 in 时遍历位置参数，等价于 in "$@"
+ * 参数：p - 分析状态（当前记号为 for）
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_for(Parser *p) {
+    Node *node = node_new(NODE_FOR);
+    int capacity = 0;
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    advance(p);
+    if (p->type != TOK_WORD || !var_valid_name(p->word, -1)) {
+        syntax_error(p);
+        node_free(node);
+        return NULL;
+    }
+    node->name = p->word;
+    p->word = NULL;
+    advance(p);
+    skip_newlines(p);
+
+    if (is_reserved(p, "in")) {
+        advance(p);
+        while (p->type == TOK_WORD) {
+            if (add_word(p, node, &capacity) < 0) {
+                node_free(node);
+                return NULL;
+            }
+        }
+    } else {
+        node->words = malloc(sizeof(char *));
+        if (node->words == NULL || (node->words[0] = strdup("\"$@\"")) == NULL) {
+            perror("myshell");
+            node_free(node);
+            return NULL;
+        }
+        node->word_count = 1;
+    }
+
+    if (p->type == TOK_SEMI) {
+        advance(p);
+    }
+    skip_newlines(p);
+    if (expect_reserved(p, "do") < 0 || (node->left = parse_body(p, "done")) == NULL) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * parse_case - 解析 case 语句
+ *
+ * 功能：每个分支为一个 NODE_CASE_ITEM 节点，words 为模式，
+ *       left 为命令列表，各分支通过 alt 串联
+ * 参数：p - 分析状态（当前记号为 case）
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_case(Parser *p) {
+    Node *node = node_new(NODE_CASE);
+    Node **tail;
+    Node *item;
+    int capacity = 0;
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    advance(p);
+    if (p->type != TOK_WORD || add_word(p, node, &capacity) < 0) {
+        syntax_error(p);
+        node_free(node);
+        return NULL;
+    }
+    skip_newlines(p);
+    if (expect_reserved(p, "in") < 0) {
+        node_free(node);
+        return NULL;
+    }
+    skip_newlines(p);
+
+    tail = &node->alt;
+    while (!is_reserved(p, "esac")) {
+        item = node_new(NODE_CASE_ITEM);
+        if (item == NULL) {
+            node_free(node);
+            return NULL;
+        }
+        *tail = item;
+        tail = &item->alt;
+        capacity = 0;
+
+        /* 模式列表：[(] 模式 (| 模式)* ) */
+        if (p->type == TOK_LPAREN) {
+            advance(p);
+        }
+        while (1) {
+            if (p->type != TOK_WORD || add_word(p, item, &capacity) < 0) {
+                syntax_error(p);
+                node_free(node);
+                return NULL;
+            }
+            if (p->type != TOK_PIPE) {
+                break;
+            }
+            advance(p);
+        }
+        if (p->type != TOK_RPAREN) {
+            syntax_error(p);
+            node_free(node);
+            return NULL;
+        }
+        advance(p);
+        skip_newlines(p);
+
+        /* 分支命令，可以为空 */
+        if (p->type != TOK_DSEMI && !is_reserved(p, "esac")) {
+            item->left = parse_list(p);
+            if (item->left == NULL) {
+                node_free(node);
+                return NULL;
+            }
+        }
+        if (p->type == TOK_DSEMI) {
+            advance(p);
+            skip_newlines(p);
+        } else if (!is_reserved(p, "esac")) {
+            syntax_error(p);
+            node_free(node);
+            return NULL;
+        }
+    }
+    advance(p);
+    return node;
+}
+
+/**
+ * is_compound_start - 判断当前记号是否开始一个复合命令
+ */
+static int is_compound_start(Parser *p) {
+    return p->type == TOK_LPAREN || is_reserved(p, "{") || is_reserved(p, "if") ||
+           is_reserved(p, "while") || is_reserved(p, "until") ||
+           is_reserved(p, "for") || is_reserved(p, "case");
+}
+
+/**
+ * parse_compound - 解析复合命令及其后的重定向
+ *
+ * 参数：p - 分析状态（is_compound_start 为真）
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_compound(Parser *p) {
+    Node *node;
+
+    if (p->type == TOK_LPAREN) {
+        node = parse_group(p, NODE_SUBSHELL);
+    } else if (is_reserved(p, "{")) {
+        node = parse_group(p, NODE_BRACE);
+    } else if (is_reserved(p, "if")) {
+        node = parse_if(p);
+    } else if (is_reserved(p, "while")) {
+        node = parse_loop(p, NODE_WHILE);
+    } else if (is_reserved(p, "until")) {
+        node = parse_loop(p, NODE_UNTIL);
+    } else if (is_reserved(p, "for")) {
+        node = parse_for(p);
+    } else {
+        node = parse_case(p);
+    }
+
+    while (node != NULL && is_redirect(p)) {
+        if (parse_redirect(p, node) < 0) {
+            node_free(node);
+            return NULL;
+        }
+    }
+    return node;
+}
+
+/**
+ * is_function_def - 判断当前单词之后是否紧跟 "( )"
+ */
+static int is_function_def(Parser *p) {
+    const char *s = p->text + p->pos;
+
+    if (p->type != TOK_WORD || !var_valid_name(p->word, -1)) {
+        return 0;
+    }
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    if (*s++ != '(') {
+        return 0;
+    }
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    return *s == ')';
+}
+
+/**
+ * parse_function - 解析函数定义
+ *
+ * 功能：函数体必须是复合命令，定义时只登记语法树，调用时才执行
+ * 参数：p - 分析状态（当前记号为 function 或函数名）
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_function(Parser *p) {
+    Node *node = node_new(NODE_FUNCTION);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    if (is_reserved(p, "function")) {
+        advance(p);
+        if (p->type != TOK_WORD || !var_valid_name(p->word, -1)) {
+            syntax_error(p);
+            node_free(node);
+            return NULL;
+        }
+        node->name = p->word;
+        p->word = NULL;
+        advance(p);
+        if (p->type == TOK_LPAREN) {
+            advance(p);
+            if (p->type != TOK_RPAREN) {
+                syntax_error(p);
+                node_free(node);
+                return NULL;
+            }
+            advance(p);
+        }
+    } else {
+        node->name = p->word;
+        p->word = NULL;
+        advance(p);     /* ( */
+        advance(p);     /* ) */
+        advance(p);
+    }
+
+    skip_newlines(p);
+    if (!is_compound_start(p)) {
+        syntax_error(p);
+        node_free(node);
+        return NULL;
+    }
+    node->left = parse_compound(p);
+    if (node->left == NULL) {
+        node_free(node);
+        return NULL;
+    }
+    return node;
+}
+
+/**
+ * parse_command_node - 解析一个命令
+ *
+ * 功能：函数定义的名字不作为别名展开，其他命令先展开别名
+ * 参数：p - 分析状态
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_command_node(Parser *p) {
+    if (is_function_def(p)) {
+        return parse_function(p);
+    }
+
+    p->alias_next = 0;
+    alias_expand(p);
+    if (is_compound_start(p)) {
+        return parse_compound(p);
+    }
+    if (is_reserved(p, "function") || is_function_def(p)) {
+        return parse_function(p);
+    }
+    return parse_simple(p);
+}
+
+/**
+ * parse_binary - 构造二元节点
+ *
+ * 参数：type - 节点类型，left - 左子树，right - 右子树
+ * 返回：节点，失败时释放两棵子树并返回 NULL
+ */
+static Node* parse_binary(int type, Node *left, Node *right) {
+    Node *node;
+
+    if (right == NULL || (node = node_new(type)) == NULL) {
+        node_free(left);
+        node_free(right);
+        return NULL;
+    }
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+/**
+ * parse_pipeline - 解析管道
+ *
+ * 参数：p - 分析状态
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_pipeline(Parser *p) {
+    Node *node = parse_command_node(p);
+
+    while (node != NULL && p->type == TOK_PIPE) {
+        advance(p);
+        skip_newlines(p);
+        node = parse_binary(NODE_PIPE, node, parse_command_node(p));
+    }
+    return node;
+}
+
+/**
+ * parse_and_or - 解析 && 和 || 连接的管道
+ *
+ * 功能：记录该项的源文本，用于后台作业的显示
+ * 参数：p - 分析状态
+ * 返回：节点，失败返回 NULL
+ */
+static Node* parse_and_or(Parser *p) {
+    int start = p->start;
+    int end;
+    int type;
+    Node *node = parse_pipeline(p);
+
+    while (node != NULL && (p->type == TOK_AND || p->type == TOK_OR)) {
+        type = p->type == TOK_AND ? NODE_AND : NODE_OR;
+        advance(p);
+        skip_newlines(p);
+        node = parse_binary(type, node, parse_pipeline(p));
+    }
+
+    if (node != NULL) {
+        for (end = p->start; end > start && strchr(" \t\n", p->text[end - 1]); end--) {
+        }
+        node->text = strndup(p->text + start, end - start);
+    }
+    return node;
+}
+
+/**
+ * parse_list - 解析命令列表
+ *
+ * 功能：各项通过 next 串联；以 & 结尾的项标记为后台执行
+ * 参数：p - 分析状态
+ * 返回：第一项，失败返回 NULL
+ */
+static Node* parse_list(Parser *p) {
+    Node *head = NULL;
+    Node **tail = &head;
+    Node *item;
+
+    while (1) {
+        item = parse_and_or(p);
+        if (item == NULL) {
+            node_free(head);
+            return NULL;
+        }
+        *tail = item;
+        tail = &item->next;
+
+        if (p->type != TOK_SEMI && p->type != TOK_AMP && p->type != TOK_NEWLINE) {
+            break;
+        }
+        if (p->type == TOK_AMP) {
+            item->background = 1;
+        }
+        advance(p);
+        skip_newlines(p);
+        if (at_list_end(p)) {
+            break;
+        }
+    }
+    return head;
+}
+
+/**
+ * parse_text - 解析命令文本
+ *
+ * 参数：text - 命令文本，tree - 输出参数，保存语法树，
+ *       resolved - 输出参数，保存展开别名后的文本（可为 NULL）
+ * 返回：PARSE_OK、PARSE_INCOMPLETE 或 PARSE_ERROR
+ */
+static int parse_text(const char *text, Node **tree, char **resolved) {
+    Parser p;
+    Node *node = NULL;
+    int i;
+
+    memset(&p, 0, sizeof(p));
+    p.text = text;
+    *tree = NULL;
+
+    advance(&p);
+    skip_newlines(&p);
+    if (p.type != TOK_EOF) {
+        node = parse_list(&p);
+        if (node != NULL && p.type != TOK_EOF) {
+            syntax_error(&p);
+        }
+    }
+    free(p.word);
+    for (i = 0; i < p.frame_count; i++) {
+        free(p.frames[i].name);
+    }
+    if (resolved != NULL) {
+        *resolved = strdup(p.text);
+    }
+    free(p.buffer);
+
+    if (p.incomplete || p.error) {
+        node_free(node);
+        return p.error ? PARSE_ERROR : PARSE_INCOMPLETE;
+    }
+    if (node != NULL) {
+        stats_add(STAT_PARSED, 1);
+    }
+    *tree = node;
+    return PARSE_OK;
+}
+
+/**
+ * parse_command - 解析命令文本
+ *
+ * 功能：文本可以包含多行；空文本和只有注释的文本得到空树
+ * 参数：text - 命令文本，tree - 输出参数，保存语法树（列表的第一项）
+ * 返回：PARSE_OK 表示成功，PARSE_INCOMPLETE 表示输入不完整（引号、
+ *       复合命令未闭合或以 && 等结尾），PARSE_ERROR 表示语法错误
+ */
+int parse_command(const char *text, Node **tree) {
+    int result;
+
+    TRACE(parse_start, 0, text);
+    result = parse_text(text, tree, NULL);
+    TRACE(parse_done, result, text);
+    return result;
+}
+
+/**
+ * parse_resolve - 解析命令文本并返回展开别名后的文本
+ *
+ * 功能：供预先展开批处理文件中的别名使用
+ * 参数：text - 命令文本，tree - 输出参数，保存语法树，
+ *       resolved - 输出参数，保存展开别名后的文本（需要 free，内存不足时为 NULL）
+ * 返回：同 parse_command
+ */
+int parse_resolve(const char *text, Node **tree, char **resolved) {
+    return parse_text(text, tree, resolved);
+}
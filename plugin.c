@@ -0,0 +1,263 @@
+/*
+ * plugin.c - MyShell 可加载内部命令
+ *
+ * 功能：enable -f 用 dlopen 加载共享库中的命令，登记到内部命令分派表，
+ *       之后像内置的内部命令一样在 shell 进程中执行，不需要 fork。
+ *       插件与 shell 之间只通过 myshell_plugin.h 定义的接口交互
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include "myshell_plugin.h"
+#ifndef MYSHELL_STATIC
+#include <dlfcn.h>
+#endif
+
+/**
+ * Loaded 结构体 - 一个已加载的命令
+ *
+ * 字段说明：
+ *   entry   - 分派表项，处理函数为 plugin_run
+ *   name    - 命令名
+ *   path    - 共享库路径
+ *   handle  - dlopen 返回的句柄
+ *   plugin  - 插件导出的命令描述
+ */
+typedef struct {
+    Builtin entry;
+    char *name;
+    char *path;
+    void *handle;
+    const MyshellPlugin *plugin;
+} Loaded;
+
+/* 已加载的命令 */
+static Loaded *loaded = NULL;
+static int loaded_count = 0;
+
+/* ========== 分派表 ========== */
+
+/**
+ * loaded_find - 按命令名查找已加载的命令
+ *
+ * 参数：name - 命令名
+ * 返回：下标，未加载返回 -1
+ */
+static int loaded_find(const char *name) {
+    int i;
+
+    for (i = 0; i < loaded_count; i++) {
+        if (strcmp(loaded[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * plugin_find - 查找已加载的命令
+ *
+ * 参数：name - 命令名
+ * 返回：分派表项，未加载返回 NULL
+ */
+const Builtin* plugin_find(const char *name) {
+    int i = loaded_find(name);
+
+    return i < 0 ? NULL : &loaded[i].entry;
+}
+
+/**
+ * plugin_name - 按序号获取已加载的命令名
+ *
+ * 参数：index - 序号
+ * 返回：命令名，序号超出范围时返回 NULL
+ */
+const char* plugin_name(int index) {
+    if (index < 0 || index >= loaded_count) {
+        return NULL;
+    }
+    return loaded[index].name;
+}
+
+#ifndef MYSHELL_STATIC
+/**
+ * plugin_run - 执行已加载的命令
+ *
+ * 功能：重定向已由分派代码应用，这里把标准输入输出描述符交给插件
+ * 参数：cmd - Command 结构体指针
+ * 返回：插件返回 0 时返回 0，否则返回 -1
+ */
+static int plugin_run(Command *cmd) {
+    MyshellCall call;
+    int i = loaded_find(cmd->args[0]);
+
+    if (i < 0) {
+        return -1;
+    }
+
+    call.abi_version = MYSHELL_PLUGIN_ABI;
+    call.argc = cmd->argc;
+    call.argv = cmd->args;
+    call.in_fd = STDIN_FILENO;
+    call.out_fd = STDOUT_FILENO;
+    call.err_fd = STDERR_FILENO;
+    call.get_var = var_get;
+    call.set_var = var_set;
+
+    /* 插件直接写描述符，先输出 shell 缓冲区中的内容 */
+    fflush(stdout);
+    return loaded[i].plugin->run(&call) == 0 ? 0 : -1;
+}
+#endif
+
+/* ========== 加载和卸载 ========== */
+
+/**
+ * plugin_unload - 卸载命令
+ *
+ * 参数：index - 下标
+ */
+static void plugin_unload(int index) {
+    Loaded *item = &loaded[index];
+
+    complete_remove_command(item->name);
+#ifndef MYSHELL_STATIC
+    dlclose(item->handle);
+#endif
+    free(item->name);
+    free(item->path);
+    loaded[index] = loaded[--loaded_count];
+}
+
+/**
+ * plugin_load - 从共享库加载命令
+ *
+ * 功能：查找库中名为 myshell_plugin_<命令名> 的变量并检查接口版本。
+ *       同名命令已加载时替换为新的实现。静态编译（make STATIC=1）时不可用
+ * 参数：path - 共享库路径，name - 命令名
+ * 返回：0 表示成功，-1 表示失败
+ */
+#ifdef MYSHELL_STATIC
+static int plugin_load(const char *path, const char *name) {
+    fprintf(stderr, "enable: 静态编译的 myshell 不能加载共享库 %s\n", path);
+    return -1;
+}
+#else
+static int plugin_load(const char *path, const char *name) {
+    char symbol[256];
+    const MyshellPlugin *plugin;
+    Loaded *grown;
+    Loaded item;
+    void *handle;
+    int old;
+
+    if (strcmp(name, "enable") == 0 || strchr(name, '/') != NULL) {
+        fprintf(stderr, "enable: %s: 不能作为命令名\n", name);
+        return -1;
+    }
+
+    handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "enable: %s\n", dlerror());
+        return -1;
+    }
+
+    snprintf(symbol, sizeof(symbol), "%s%s", MYSHELL_PLUGIN_PREFIX, name);
+    plugin = dlsym(handle, symbol);
+    if (plugin == NULL) {
+        fprintf(stderr, "enable: %s: 库中没有 %s\n", path, symbol);
+        dlclose(handle);
+        return -1;
+    }
+    if (plugin->abi_version != MYSHELL_PLUGIN_ABI || plugin->run == NULL) {
+        fprintf(stderr, "enable: %s: 接口版本 %d 不兼容（需要 %d）\n",
+                path, plugin->abi_version, MYSHELL_PLUGIN_ABI);
+        dlclose(handle);
+        return -1;
+    }
+
+    item.name = strdup(name);
+    item.path = strdup(path);
+    grown = realloc(loaded, (loaded_count + 1) * sizeof(Loaded));
+    if (item.name == NULL || item.path == NULL || grown == NULL) {
+        perror("enable");
+        free(item.name);
+        free(item.path);
+        if (grown != NULL) {
+            loaded = grown;
+        }
+        dlclose(handle);
+        return -1;
+    }
+    loaded = grown;
+
+    old = loaded_find(name);
+    if (old >= 0) {
+        plugin_unload(old);
+    }
+
+    item.handle = handle;
+    item.plugin = plugin;
+    item.entry.name = item.name;
+    item.entry.func = plugin_run;
+    item.entry.redirect = 1;
+    loaded[loaded_count++] = item;
+    complete_add_command(name);
+    return 0;
+}
+#endif
+
+/**
+ * cmd_enable - 加载、卸载或列出内部命令
+ *
+ * 功能：enable 列出所有内部命令；enable -f 库 命令名... 从共享库加载命令；
+ *       enable -d 命令名... 卸载已加载的命令
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_enable(Command *cmd) {
+    int result = 0;
+    int i, index;
+
+    if (cmd->argc == 1) {
+        for (i = 0; builtin_name(i) != NULL; i++) {
+            index = loaded_find(builtin_name(i));
+            if (index >= 0 && i >= builtin_count()) {
+                printf("enable -f %s %s", loaded[index].path, loaded[index].name);
+                if (loaded[index].plugin->usage != NULL) {
+                    printf("    # %s", loaded[index].plugin->usage);
+                }
+                printf("\n");
+            } else if (index < 0) {
+                printf("enable %s\n", builtin_name(i));
+            }
+        }
+        return 0;
+    }
+
+    if (strcmp(cmd->args[1], "-f") == 0 && cmd->argc >= 4) {
+        for (i = 3; i < cmd->argc; i++) {
+            if (plugin_load(cmd->args[2], cmd->args[i]) < 0) {
+                result = -1;
+            }
+        }
+        return result;
+    }
+
+    if (strcmp(cmd->args[1], "-d") == 0 && cmd->argc >= 3) {
+        for (i = 2; i < cmd->argc; i++) {
+            index = loaded_find(cmd->args[i]);
+            if (index < 0) {
+                fprintf(stderr, "enable: %s: 不是已加载的命令\n", cmd->args[i]);
+                result = -1;
+                continue;
+            }
+            plugin_unload(index);
+        }
+        return result;
+    }
+
+    fprintf(stderr, "用法: enable [-f 库 命令名... | -d 命令名...]\n");
+    return -1;
+}
@@ -0,0 +1,354 @@
+/*
+ * prompt.c - MyShell 提示符
+ *
+ * 功能：按格式字符串生成提示符。各字段在用到时才计算并缓存：
+ *       当前目录只在 cd 后重新获取，git 分支只在 .git/HEAD 的修改时间
+ *       变化时重新读取；所有字段未变时直接复用上次生成的提示符，
+ *       输出时只调用一次 write
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/stat.h>
+#include <time.h>
+
+/* 默认提示符格式，与原先的 "当前目录> " 一致 */
+#define DEFAULT_PROMPT "%d> "
+
+/* 提示符格式，可由 MYSHELL_PROMPT 环境变量或 prompt 命令设置 */
+static char prompt_format[MAX_LINE] = "";
+
+/* 当前目录缓存 */
+static char cwd_cache[MAX_PATH];
+static int cwd_valid = 0;
+
+/* git 缓存：HEAD 文件路径（空串表示不在仓库中）、修改时间和分支名 */
+static char git_head[MAX_PATH + 16];
+static int git_searched = 0;
+static struct timespec git_mtime;
+static char git_branch[128];
+
+/* 上一条命令的退出状态和耗时 */
+static int last_status = 0;
+static long long last_elapsed_ms = 0;
+
+/* 上次生成的提示符及其依赖的可变字段 */
+static char rendered[MAX_LINE + MAX_PATH];
+static int rendered_len = 0;
+static int rendered_valid = 0;
+static int rendered_jobs = -1;
+
+/* ========== 字段计算 ========== */
+
+/**
+ * segment_cwd - 获取当前目录（带缓存）
+ *
+ * 返回：当前目录，获取失败返回 NULL
+ */
+static const char* segment_cwd() {
+    if (!cwd_valid) {
+        if (getcwd(cwd_cache, sizeof(cwd_cache)) == NULL) {
+            return NULL;
+        }
+        cwd_valid = 1;
+    }
+    return cwd_cache;
+}
+
+/**
+ * find_git_head - 从当前目录向上查找 .git/HEAD
+ *
+ * 功能：结果保存在 git_head 中，直到下一次 cd 才重新查找
+ */
+static void find_git_head() {
+    char dir[MAX_PATH];
+    struct stat st;
+    const char *cwd = segment_cwd();
+    char *slash;
+
+    git_searched = 1;
+    git_head[0] = '\0';
+    git_mtime.tv_sec = git_mtime.tv_nsec = -1;
+    if (cwd == NULL) {
+        return;
+    }
+
+    snprintf(dir, sizeof(dir), "%s", cwd);
+    while (1) {
+        snprintf(git_head, sizeof(git_head), "%s/.git/HEAD",
+                 strcmp(dir, "/") == 0 ? "" : dir);
+        if (stat(git_head, &st) == 0) {
+            return;
+        }
+        slash = strrchr(dir, '/');
+        if (slash == NULL || strcmp(dir, "/") == 0) {
+            break;
+        }
+        if (slash == dir) {
+            dir[1] = '\0';
+        } else {
+            *slash = '\0';
+        }
+    }
+    git_head[0] = '\0';
+}
+
+/**
+ * segment_git - 获取 git 分支名（带缓存）
+ *
+ * 功能：HEAD 的修改时间未变时直接返回缓存；分离 HEAD 时返回提交号前 7 位
+ * 参数：changed - 输出参数，分支信息自上次调用以来是否变化
+ * 返回：分支名，不在仓库中返回空串
+ */
+static const char* segment_git(int *changed) {
+    char buf[256];
+    struct stat st;
+    ssize_t n;
+    int fd;
+
+    *changed = 0;
+    if (!git_searched) {
+        find_git_head();
+        *changed = 1;
+    }
+    if (git_head[0] == '\0') {
+        git_branch[0] = '\0';
+        return git_branch;
+    }
+
+    if (stat(git_head, &st) < 0) {
+        git_branch[0] = '\0';
+        return git_branch;
+    }
+    if (st.st_mtim.tv_sec == git_mtime.tv_sec && st.st_mtim.tv_nsec == git_mtime.tv_nsec) {
+        return git_branch;
+    }
+    git_mtime = st.st_mtim;
+    *changed = 1;
+
+    git_branch[0] = '\0';
+    fd = open(git_head, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return git_branch;
+    }
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return git_branch;
+    }
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+
+    if (strncmp(buf, "ref: refs/heads/", 16) == 0) {
+        snprintf(git_branch, sizeof(git_branch), "%s", buf + 16);
+    } else {
+        snprintf(git_branch, sizeof(git_branch), "%.7s", buf);
+    }
+    return git_branch;
+}
+
+/**
+ * format_elapsed - 格式化耗时
+ *
+ * 参数：buf - 输出缓冲区，size - 缓冲区大小，ms - 毫秒数
+ */
+static void format_elapsed(char *buf, size_t size, long long ms) {
+    if (ms < 1000) {
+        snprintf(buf, size, "%lldms", ms);
+    } else if (ms < 60000) {
+        snprintf(buf, size, "%lld.%llds", ms / 1000, ms % 1000 / 100);
+    } else {
+        snprintf(buf, size, "%lldm%02llds", ms / 60000, ms % 60000 / 1000);
+    }
+}
+
+/* ========== 提示符生成 ========== */
+
+/**
+ * render_prompt - 按格式生成提示符
+ *
+ * 功能：支持 %d 当前目录、%s 上条命令状态、%j 后台作业数、
+ *       %t 上条命令耗时、%b git 分支、%n 换行、%% 百分号
+ */
+static void render_prompt() {
+    char field[64];
+    const char *p;
+    const char *text;
+    size_t size = sizeof(rendered);
+    int len = 0;
+    int changed;
+
+    for (p = prompt_format; *p != '\0' && (size_t)len < size - 1; p++) {
+        if (*p != '%' || p[1] == '\0') {
+            rendered[len++] = *p;
+            continue;
+        }
+
+        p++;
+        text = field;
+        switch (*p) {
+        case 'd':
+            text = segment_cwd();
+            if (text == NULL) {
+                text = "myshell";
+            }
+            break;
+        case 's':
+            snprintf(field, sizeof(field), "%d", last_status);
+            break;
+        case 'j':
+            snprintf(field, sizeof(field), "%d", rendered_jobs);
+            break;
+        case 't':
+            format_elapsed(field, sizeof(field), last_elapsed_ms);
+            break;
+        case 'b':
+            text = segment_git(&changed);
+            break;
+        case 'n':
+            text = "\n";
+            break;
+        case '%':
+            text = "%";
+            break;
+        default:
+            snprintf(field, sizeof(field), "%%%c", *p);
+            break;
+        }
+        len += snprintf(rendered + len, size - len, "%s", text);
+        if ((size_t)len >= size) {
+            len = size - 1;
+        }
+    }
+    rendered[len] = '\0';
+    rendered_len = len;
+    rendered_valid = 1;
+}
+
+/**
+ * prompt_text - 获取提示符文本
+ *
+ * 功能：只有当前目录、命令状态、后台作业数或 git 分支变化时才重新生成
+ * 返回：提示符字符串（静态缓冲区）
+ */
+const char* prompt_text() {
+    int jobs, changed = 0;
+
+    if (prompt_format[0] == '\0') {
+        const char *env = getenv("MYSHELL_PROMPT");
+        snprintf(prompt_format, sizeof(prompt_format), "%s",
+                 env != NULL && env[0] != '\0' ? env : DEFAULT_PROMPT);
+    }
+
+    if (strstr(prompt_format, "%j") != NULL) {
+        jobs = jobs_background_count();
+        if (jobs != rendered_jobs) {
+            rendered_jobs = jobs;
+            rendered_valid = 0;
+        }
+    }
+    if (strstr(prompt_format, "%b") != NULL) {
+        segment_git(&changed);
+        if (changed) {
+            rendered_valid = 0;
+        }
+    }
+
+    if (!rendered_valid) {
+        render_prompt();
+    }
+    return rendered;
+}
+
+/**
+ * display_prompt - 显示命令提示符
+ *
+ * 功能：先刷新 stdout 中尚未输出的内容，再用一次 write 输出提示符
+ */
+void display_prompt() {
+    const char *text = prompt_text();
+    ssize_t n;
+    int off = 0;
+
+    fflush(stdout);
+    while (off < rendered_len) {
+        n = write(STDOUT_FILENO, text + off, rendered_len - off);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        off += n;
+    }
+}
+
+/* ========== 缓存失效 ========== */
+
+/**
+ * prompt_invalidate_cwd - 当前目录已改变
+ *
+ * 功能：由 cd 调用，使当前目录和 git 仓库位置重新计算
+ */
+void prompt_invalidate_cwd() {
+    cwd_valid = 0;
+    git_searched = 0;
+    rendered_valid = 0;
+}
+
+/**
+ * prompt_command_done - 记录一条命令的结果
+ *
+ * 参数：status - 退出状态，elapsed_ms - 耗时（毫秒）
+ */
+void prompt_command_done(int status, long long elapsed_ms) {
+    if (status != last_status || elapsed_ms != last_elapsed_ms) {
+        last_status = status;
+        last_elapsed_ms = elapsed_ms;
+        if (strstr(prompt_format, "%s") != NULL || strstr(prompt_format, "%t") != NULL) {
+            rendered_valid = 0;
+        }
+    }
+}
+
+/* ========== prompt 命令 ========== */
+
+/**
+ * cmd_prompt - 显示或设置提示符格式
+ *
+ * 功能：prompt 显示当前格式；prompt FORMAT 设置格式（多个参数以空格连接）；
+ *       prompt -r 恢复默认格式
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功
+ */
+int cmd_prompt(Command *cmd) {
+    int len = 0;
+    int i;
+
+    prompt_text();
+
+    if (cmd->argc == 1) {
+        printf("%s\n", prompt_format);
+        return 0;
+    }
+
+    if (cmd->argc == 2 && strcmp(cmd->args[1], "-r") == 0) {
+        snprintf(prompt_format, sizeof(prompt_format), "%s", DEFAULT_PROMPT);
+    } else {
+        for (i = 1; i < cmd->argc; i++) {
+            len += snprintf(prompt_format + len, sizeof(prompt_format) - len, "%s%s",
+                            i > 1 ? " " : "", cmd->args[i]);
+            if ((size_t)len >= sizeof(prompt_format)) {
+                break;
+            }
+        }
+        /* 单词之间的空白被分词器去掉，格式末尾补一个空格与命令隔开 */
+        if ((size_t)len < sizeof(prompt_format) - 1) {
+            strcat(prompt_format, " ");
+        }
+    }
+
+    rendered_valid = 0;
+    return 0;
+}
@@ -0,0 +1,1112 @@
+/*
+ * resource.c - MyShell 资源控制
+ *
+ * 功能：实现子进程的资源限制（ulimit）、cgroup v2 资源隔离和
+ *       CPU/NUMA 亲和性控制。
+ *       限制保存在 shell 中，只在子进程 exec 之前应用，shell 自身不受影响
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/**
+ * ChildLimit 结构体 - 一项子进程资源限制
+ *
+ * 字段说明：
+ *   option   - ulimit 命令中的选项字母
+ *   resource - 对应的 RLIMIT_* 资源
+ *   unit     - 命令行数值与内核数值之间的换算单位
+ *   name     - 显示名称
+ *   set      - 是否已设置：1 表示已设置，0 表示沿用 shell 的限制
+ *   value    - 设置的限制值（内核单位）
+ */
+typedef struct {
+    char option;
+    int resource;
+    rlim_t unit;
+    const char *name;
+    int set;
+    rlim_t value;
+} ChildLimit;
+
+/* 支持的资源限制 */
+static ChildLimit child_limits[] = {
+    { 't', RLIMIT_CPU,    1,    "CPU 时间 (秒)",       0, 0 },
+    { 'v', RLIMIT_AS,     1024, "地址空间 (KB)",       0, 0 },
+    { 'n', RLIMIT_NOFILE, 1,    "打开文件数",          0, 0 },
+};
+
+#define CHILD_LIMIT_COUNT (sizeof(child_limits) / sizeof(child_limits[0]))
+
+/* ========== ulimit 命令 ========== */
+
+/**
+ * find_child_limit - 根据选项字母查找资源限制项
+ *
+ * 参数：option - 选项字母
+ * 返回：资源限制项指针，未找到返回 NULL
+ */
+static ChildLimit* find_child_limit(char option) {
+    size_t i;
+
+    for (i = 0; i < CHILD_LIMIT_COUNT; i++) {
+        if (child_limits[i].option == option) {
+            return &child_limits[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * print_child_limit - 显示一项资源限制
+ *
+ * 功能：已设置时显示设置值，否则显示 shell 当前的软限制。表格形式
+ *       带选项和名称；否则只输出数值或 unlimited，供 $(ulimit -n) 使用
+ * 参数：limit - 资源限制项，table - 1 表示以表格的一行显示
+ */
+static void print_child_limit(ChildLimit *limit, int table) {
+    struct rlimit rl;
+    rlim_t value;
+
+    if (limit->set) {
+        value = limit->value;
+    } else if (getrlimit(limit->resource, &rl) == 0) {
+        value = rl.rlim_cur;
+    } else {
+        value = RLIM_INFINITY;
+    }
+
+    if (table) {
+        printf("-%c  %-20s ", limit->option, limit->name);
+    }
+    if (value == RLIM_INFINITY) {
+        printf("unlimited\n");
+    } else {
+        printf("%llu\n", (unsigned long long)(value / limit->unit));
+    }
+}
+
+/**
+ * cmd_ulimit - 子进程资源限制命令
+ *
+ * 功能：ulimit [-t|-v|-n] [value|unlimited]
+ *       -t 设置 CPU 时间（秒），-v 设置地址空间（KB），-n 设置打开文件数；
+ *       不带数值时只显示该项的值，不带选项或使用 -a 时以表格显示全部
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_ulimit(Command *cmd) {
+    ChildLimit *limit;
+    unsigned long long value;
+    char *end;
+    size_t i;
+
+    if (cmd->argc == 1 || strcmp(cmd->args[1], "-a") == 0) {
+        for (i = 0; i < CHILD_LIMIT_COUNT; i++) {
+            print_child_limit(&child_limits[i], 1);
+        }
+        return 0;
+    }
+
+    if (cmd->args[1][0] != '-' || strlen(cmd->args[1]) != 2 ||
+        (limit = find_child_limit(cmd->args[1][1])) == NULL) {
+        fprintf(stderr, "用法: ulimit [-a] [-t|-v|-n] [value|unlimited]\n");
+        return -1;
+    }
+
+    /* 只有选项，只显示该项的值 */
+    if (cmd->argc == 2) {
+        print_child_limit(limit, 0);
+        return 0;
+    }
+
+    if (strcmp(cmd->args[2], "unlimited") == 0) {
+        limit->value = RLIM_INFINITY;
+    } else {
+        errno = 0;
+        value = strtoull(cmd->args[2], &end, 10);
+        if (*end != '\0' || end == cmd->args[2] || errno != 0) {
+            fprintf(stderr, "ulimit: 无效的数值 '%s'\n", cmd->args[2]);
+            return -1;
+        }
+        limit->value = (rlim_t)value * limit->unit;
+    }
+    limit->set = 1;
+
+    return 0;
+}
+
+/**
+ * apply_child_limits - 在子进程中应用资源限制
+ *
+ * 功能：在 fork 之后、exec 之前调用，软硬限制同时设为指定值
+ * 返回：0 表示成功，-1 表示失败
+ */
+int apply_child_limits() {
+    struct rlimit rl;
+    size_t i;
+
+    for (i = 0; i < CHILD_LIMIT_COUNT; i++) {
+        if (!child_limits[i].set) {
+            continue;
+        }
+
+        rl.rlim_cur = child_limits[i].value;
+        rl.rlim_max = child_limits[i].value;
+        if (prlimit(0, child_limits[i].resource, &rl, NULL) < 0) {
+            perror("ulimit");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ========== cgroup v2 资源隔离 ========== */
+
+/* cgroup v2 挂载点 */
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+/* cgroup 隔离模式 */
+#define CGROUP_OFF   0  /* 关闭 */
+#define CGROUP_JOB   1  /* 每个作业一个 cgroup */
+#define CGROUP_BATCH 2  /* 整个运行过程共用一个 cgroup */
+
+/**
+ * CgroupLimit 结构体 - 一项 cgroup 限制
+ *
+ * 字段说明：
+ *   file       - 控制文件名，如 cpu.max
+ *   controller - 所需的控制器名
+ *   value      - 设置值，空串表示不设置
+ *   enabled    - 控制器已在作业 cgroup 中开启
+ *   borrowed   - 控制器是 shell 在原来的 cgroup 中开启的，退出时关闭
+ */
+typedef struct {
+    const char *file;
+    const char *controller;
+    char value[64];
+    int enabled;
+    int borrowed;
+} CgroupLimit;
+
+/* 支持的 cgroup 限制 */
+static CgroupLimit cgroup_limits[] = {
+    { "cpu.max",    "cpu",    "", 0, 0 },
+    { "memory.max", "memory", "", 0, 0 },
+    { "io.weight",  "io",     "", 0, 0 },
+};
+
+#define CGROUP_LIMIT_COUNT (sizeof(cgroup_limits) / sizeof(cgroup_limits[0]))
+
+/* 当前隔离模式 */
+static int cgroup_mode = CGROUP_OFF;
+
+/* shell 原来所在的 cgroup 目录 */
+static char cgroup_parent[MAX_PATH - 64] = "";
+
+/* shell 创建的 cgroup 子树根目录，shell 自身的 shell 叶子和所有作业 cgroup
+ * 都在其下（留出子目录名的长度） */
+static char cgroup_base[MAX_PATH - 32] = "";
+
+/* 批处理模式下共用的 cgroup 目录 */
+static char cgroup_batch[MAX_PATH] = "";
+
+/* 作业 cgroup 序号 */
+static int cgroup_seq = 0;
+
+/**
+ * cgroup_write - 向 cgroup 控制文件写入内容
+ *
+ * 参数：dir - cgroup 目录，file - 控制文件名，value - 写入内容
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int cgroup_write(const char *dir, const char *file, const char *value) {
+    char path[MAX_PATH];
+    ssize_t len = strlen(value);
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (write(fd, value, len) != len) {
+        close(fd);
+        return -1;
+    }
+    return close(fd);
+}
+
+/**
+ * cgroup_read - 读取 cgroup 控制文件
+ *
+ * 参数：dir - cgroup 目录，file - 控制文件名，buf - 缓冲区，size - 缓冲区大小
+ * 返回：读取的字节数，失败返回 -1
+ */
+static ssize_t cgroup_read(const char *dir, const char *file,
+                           char *buf, size_t size) {
+    char path[MAX_PATH];
+    ssize_t len;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    len = read(fd, buf, size - 1);
+    close(fd);
+    if (len < 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * cgroup_has_controller - 检查 cgroup 目录中是否可用某个控制器
+ *
+ * 参数：dir - cgroup 目录，name - 控制器名
+ * 返回：1 表示可用，0 表示不可用
+ */
+static int cgroup_has_controller(const char *dir, const char *name) {
+    char buf[256];
+    char *token, *save;
+
+    if (cgroup_read(dir, "cgroup.controllers", buf, sizeof(buf)) < 0) {
+        return 0;
+    }
+    for (token = strtok_r(buf, " \n", &save); token != NULL;
+         token = strtok_r(NULL, " \n", &save)) {
+        if (strcmp(token, name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * cgroup_init - 建立 shell 的 cgroup 子树
+ *
+ * 功能：找到 shell 所在的 cgroup（需要已委派写权限），在其下创建
+ *       myshell-<pid> 子树，并把 shell 移入其中的 shell 叶子。
+ *       “无内部进程”规则要求有进程的 cgroup 不能向子 cgroup 开启控制器，
+ *       shell 移走后才能在原来的 cgroup 和子树根依次开启 cpu、memory、io；
+ *       作业 cgroup 与 shell 叶子同级。没有可用的控制器时只提示一次
+ * 返回：0 表示成功，-1 表示当前环境不支持（已打印原因）
+ */
+static int cgroup_init() {
+    char line[MAX_PATH];
+    char self[MAX_PATH - 128] = "";
+    char leaf[MAX_PATH];
+    char enable[32];
+    char missing[64] = "";
+    FILE *fp;
+    size_t i;
+
+    if (cgroup_base[0] != '\0') {
+        return 0;
+    }
+
+    if (access(CGROUP_ROOT "/cgroup.controllers", F_OK) < 0) {
+        fprintf(stderr, "cgroup: 系统未挂载 cgroup v2，不启用资源隔离\n");
+        return -1;
+    }
+
+    /* cgroup v2 的条目形如 "0::/user.slice/..." */
+    fp = fopen("/proc/self/cgroup", "r");
+    if (fp == NULL) {
+        perror("cgroup");
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (strncmp(line, "0::", 3) == 0) {
+            line[strcspn(line, "\n")] = '\0';
+            snprintf(self, sizeof(self), "%s", line + 3);
+            break;
+        }
+    }
+    fclose(fp);
+
+    snprintf(cgroup_parent, sizeof(cgroup_parent), CGROUP_ROOT "%s",
+             strcmp(self, "/") == 0 ? "" : self);
+    if (access(cgroup_parent, W_OK) < 0) {
+        fprintf(stderr, "cgroup: 没有 %s 的写权限（未委派），不启用资源隔离\n",
+                cgroup_parent);
+        return -1;
+    }
+
+    snprintf(cgroup_base, sizeof(cgroup_base), "%s/myshell-%d",
+             cgroup_parent, (int)getpid());
+    snprintf(leaf, sizeof(leaf), "%s/shell", cgroup_base);
+    if ((mkdir(cgroup_base, 0755) < 0 && errno != EEXIST) ||
+        (mkdir(leaf, 0755) < 0 && errno != EEXIST) ||
+        cgroup_write(leaf, "cgroup.procs", "0") < 0) {
+        fprintf(stderr, "cgroup: 无法把 shell 移入 %s: %s\n", leaf, strerror(errno));
+        rmdir(leaf);
+        rmdir(cgroup_base);
+        cgroup_base[0] = '\0';
+        return -1;
+    }
+
+    /* 开启控制器：原来的 cgroup 中已没有 shell，其他进程也不在时才能开启 */
+    for (i = 0; i < CGROUP_LIMIT_COUNT; i++) {
+        snprintf(enable, sizeof(enable), "+%s", cgroup_limits[i].controller);
+        if (!cgroup_has_controller(cgroup_base, cgroup_limits[i].controller) &&
+            cgroup_has_controller(cgroup_parent, cgroup_limits[i].controller) &&
+            cgroup_write(cgroup_parent, "cgroup.subtree_control", enable) == 0) {
+            cgroup_limits[i].borrowed = 1;
+        }
+        cgroup_limits[i].enabled =
+            cgroup_has_controller(cgroup_base, cgroup_limits[i].controller) &&
+            cgroup_write(cgroup_base, "cgroup.subtree_control", enable) == 0;
+        if (!cgroup_limits[i].enabled) {
+            snprintf(missing + strlen(missing), sizeof(missing) - strlen(missing),
+                     " %s", cgroup_limits[i].controller);
+        }
+    }
+    if (missing[0] != '\0') {
+        fprintf(stderr, "cgroup: 控制器不可用:%s，对应的限制不会生效\n", missing);
+    }
+
+    return 0;
+}
+
+/**
+ * cgroup_create - 创建一个作业 cgroup 并写入限制
+ *
+ * 参数：path - 新 cgroup 的目录
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int cgroup_create(const char *path) {
+    size_t i;
+
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        return -1;
+    }
+
+    /* 控制器不可用的限制在 cgroup_init 和设置时已提示过，这里跳过 */
+    for (i = 0; i < CGROUP_LIMIT_COUNT; i++) {
+        if (cgroup_limits[i].value[0] == '\0' || !cgroup_limits[i].enabled) {
+            continue;
+        }
+        if (cgroup_write(path, cgroup_limits[i].file, cgroup_limits[i].value) < 0) {
+            fprintf(stderr, "cgroup: 无法设置 %s: %s\n",
+                    cgroup_limits[i].file, strerror(errno));
+        }
+    }
+    return 0;
+}
+
+/**
+ * cgroup_open_procs - 打开 cgroup 的 cgroup.procs 文件
+ *
+ * 参数：path - cgroup 目录
+ * 返回：文件描述符（带 O_CLOEXEC，不会泄漏给被执行的程序），失败返回 -1
+ */
+static int cgroup_open_procs(const char *path) {
+    char procs[MAX_PATH];
+
+    snprintf(procs, sizeof(procs), "%s/cgroup.procs", path);
+    return open(procs, O_WRONLY | O_CLOEXEC);
+}
+
+/**
+ * cgroup_prepare_job - 为即将启动的作业准备 cgroup
+ *
+ * 功能：作业模式下每次创建 job-<n> 子目录；批处理模式下首次调用时
+ *       创建 batch 子目录，之后所有作业共用。任何一步失败都退化为
+ *       不隔离，只提示一次
+ * 参数：path - 输出参数，作业独占的 cgroup 目录，size - 缓冲区大小
+ * 返回：cgroup.procs 的文件描述符，未开启或失败时返回 -1
+ */
+int cgroup_prepare_job(char *path, size_t size) {
+    static int warned = 0;
+    char dir[MAX_PATH];
+    int fd;
+
+    path[0] = '\0';
+    if (cgroup_mode == CGROUP_OFF) {
+        return -1;
+    }
+
+    if (cgroup_mode == CGROUP_BATCH) {
+        if (cgroup_batch[0] == '\0') {
+            snprintf(dir, sizeof(dir), "%s/batch", cgroup_base);
+            if (cgroup_create(dir) == 0) {
+                snprintf(cgroup_batch, sizeof(cgroup_batch), "%s", dir);
+            }
+        }
+        fd = cgroup_batch[0] != '\0' ? cgroup_open_procs(cgroup_batch) : -1;
+    } else {
+        snprintf(dir, sizeof(dir), "%s/job-%d", cgroup_base, ++cgroup_seq);
+        fd = cgroup_create(dir) == 0 ? cgroup_open_procs(dir) : -1;
+        if (fd >= 0) {
+            snprintf(path, size, "%s", dir);
+        } else {
+            rmdir(dir);
+        }
+    }
+
+    if (fd < 0 && !warned) {
+        fprintf(stderr, "cgroup: 无法创建作业 cgroup，命令将不受隔离: %s\n",
+                strerror(errno));
+        warned = 1;
+    }
+    return fd;
+}
+
+/**
+ * cgroup_enter - 在子进程中加入 cgroup
+ *
+ * 功能：向 cgroup.procs 写入 0 表示移动写入者自身
+ * 参数：procs_fd - cgroup.procs 的文件描述符
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cgroup_enter(int procs_fd) {
+    if (write(procs_fd, "0", 1) != 1) {
+        return -1;
+    }
+    close(procs_fd);
+    return 0;
+}
+
+/**
+ * child_enter_job - 在子进程中加入作业 cgroup，应用资源限制和 CPU/NUMA 放置
+ *
+ * 功能：执行外部程序的子进程在 exec 之前调用，包括 execute_external
+ *       和管道的各段。加入 cgroup 失败时不隔离，继续执行
+ * 参数：cgroup_fd - cgroup_prepare_job 返回的描述符，-1 表示不隔离，
+ *       pl - affinity_choose 选择的放置方案
+ * 返回：0 表示成功，-1 表示资源限制或放置无法应用
+ */
+int child_enter_job(int cgroup_fd, Placement *pl) {
+    if (cgroup_fd >= 0 && cgroup_enter(cgroup_fd) < 0) {
+        perror("cgroup");
+    }
+    if (apply_child_limits() < 0 || affinity_apply(pl) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * cgroup_read_pressure - 读取压力文件中 some 行的累计停顿时间
+ *
+ * 参数：dir - cgroup 目录，file - 压力文件名
+ * 返回：累计停顿微秒数，不可用返回 -1
+ */
+static long long cgroup_read_pressure(const char *dir, const char *file) {
+    char buf[512];
+    char *total;
+
+    /* 格式："some avg10=0.00 avg60=0.00 avg300=0.00 total=123" */
+    if (cgroup_read(dir, file, buf, sizeof(buf)) < 0 ||
+        strncmp(buf, "some", 4) != 0 ||
+        (total = strstr(buf, "total=")) == NULL) {
+        return -1;
+    }
+    return atoll(total + 6);
+}
+
+/**
+ * cgroup_read_stats - 读取 cgroup 的资源统计
+ *
+ * 参数：dir - cgroup 目录，stats - 输出参数
+ */
+static void cgroup_read_stats(const char *dir, CgroupStats *stats) {
+    char buf[1024];
+    char *usage;
+
+    stats->cpu_usage_us = -1;
+    stats->memory_peak = -1;
+
+    if (cgroup_read(dir, "cpu.stat", buf, sizeof(buf)) > 0 &&
+        (usage = strstr(buf, "usage_usec ")) != NULL) {
+        stats->cpu_usage_us = atoll(usage + 11);
+    }
+    if (cgroup_read(dir, "memory.peak", buf, sizeof(buf)) > 0) {
+        stats->memory_peak = atoll(buf);
+    }
+
+    stats->cpu_stall_us = cgroup_read_pressure(dir, "cpu.pressure");
+    stats->memory_stall_us = cgroup_read_pressure(dir, "memory.pressure");
+    stats->io_stall_us = cgroup_read_pressure(dir, "io.pressure");
+}
+
+/**
+ * cgroup_collect - 读取作业 cgroup 的统计并删除该 cgroup
+ *
+ * 功能：作业的进程已全部退出时目录可以删除；若还有残留的子进程，
+ *       目录保留到 shell 退出时再尝试删除
+ * 参数：path - cgroup 目录，stats - 输出参数
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cgroup_collect(const char *path, CgroupStats *stats) {
+    cgroup_read_stats(path, stats);
+    rmdir(path);
+    return 0;
+}
+
+/**
+ * format_stat - 格式化一项统计值
+ *
+ * 参数：value - 统计值，-1 表示不可用，buf - 缓冲区，size - 缓冲区大小
+ * 返回：buf
+ */
+static const char* format_stat(long long value, char *buf, size_t size) {
+    if (value < 0) {
+        return "-";
+    }
+    snprintf(buf, size, "%lld", value);
+    return buf;
+}
+
+/**
+ * cgroup_shutdown - 退出时清理 cgroup
+ *
+ * 功能：批处理模式下报告整个运行过程的统计；删除残留的作业目录，
+ *       关闭在原来的 cgroup 中开启的控制器，shell 回到原来的 cgroup
+ *       后删除 shell 叶子和子树根
+ */
+void cgroup_shutdown() {
+    CgroupStats stats;
+    char a[32], b[32], c[32], d[32], e[32];
+    char path[MAX_PATH + 256];
+    char disable[32];
+    DIR *dir;
+    struct dirent *entry;
+    size_t i;
+
+    if (cgroup_base[0] == '\0') {
+        return;
+    }
+
+    if (cgroup_batch[0] != '\0') {
+        cgroup_read_stats(cgroup_batch, &stats);
+        if (acct_is_enabled()) {
+            fprintf(stderr, "[acct] cgroup=batch cg_cpu_us=%s cg_mem_peak=%s "
+                    "cg_cpu_stall_us=%s cg_mem_stall_us=%s cg_io_stall_us=%s\n",
+                    format_stat(stats.cpu_usage_us, a, sizeof(a)),
+                    format_stat(stats.memory_peak, b, sizeof(b)),
+                    format_stat(stats.cpu_stall_us, c, sizeof(c)),
+                    format_stat(stats.memory_stall_us, d, sizeof(d)),
+                    format_stat(stats.io_stall_us, e, sizeof(e)));
+        }
+    }
+
+    /* 删除残留的作业目录，再删除子树根 */
+    dir = opendir(cgroup_base);
+    if (dir != NULL) {
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, "batch") == 0 ||
+                strncmp(entry->d_name, "job-", 4) == 0) {
+                snprintf(path, sizeof(path), "%s/%s", cgroup_base, entry->d_name);
+                rmdir(path);
+            }
+        }
+        closedir(dir);
+    }
+
+    /* 开启了控制器的 cgroup 不能有进程，先关闭 shell 开启的控制器 */
+    for (i = 0; i < CGROUP_LIMIT_COUNT; i++) {
+        if (cgroup_limits[i].borrowed) {
+            snprintf(disable, sizeof(disable), "-%s", cgroup_limits[i].controller);
+            cgroup_write(cgroup_base, "cgroup.subtree_control", disable);
+            cgroup_write(cgroup_parent, "cgroup.subtree_control", disable);
+            cgroup_limits[i].borrowed = 0;
+        }
+        cgroup_limits[i].enabled = 0;
+    }
+    cgroup_write(cgroup_parent, "cgroup.procs", "0");
+    snprintf(path, sizeof(path), "%s/shell", cgroup_base);
+    rmdir(path);
+    rmdir(cgroup_base);
+    cgroup_base[0] = '\0';
+    cgroup_batch[0] = '\0';
+}
+
+/**
+ * cmd_cgroup - cgroup 资源隔离命令
+ *
+ * 功能：cgroup                       显示当前设置
+ *       cgroup on [job|batch]        开启隔离，默认每个作业一个 cgroup
+ *       cgroup off                   关闭隔离
+ *       cgroup cpu.max|memory.max|io.weight <value...>  设置限制
+ *       不支持 cgroup v2 委派时给出原因并保持关闭
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_cgroup(Command *cmd) {
+    static const char *mode_names[] = { "off", "job", "batch" };
+    size_t i, len;
+    int j;
+
+    if (cmd->argc == 1) {
+        printf("mode: %s\n", mode_names[cgroup_mode]);
+        for (i = 0; i < CGROUP_LIMIT_COUNT; i++) {
+            printf("%s: %s\n", cgroup_limits[i].file,
+                   cgroup_limits[i].value[0] ? cgroup_limits[i].value : "(默认)");
+        }
+        return 0;
+    }
+
+    if (strcmp(cmd->args[1], "on") == 0) {
+        int mode = CGROUP_JOB;
+
+        if (cmd->argc > 2 && strcmp(cmd->args[2], "batch") == 0) {
+            mode = CGROUP_BATCH;
+        } else if (cmd->argc > 2 && strcmp(cmd->args[2], "job") != 0) {
+            fprintf(stderr, "用法: cgroup on [job|batch]\n");
+            return -1;
+        }
+        if (cgroup_init() < 0) {
+            return -1;
+        }
+        cgroup_mode = mode;
+        return 0;
+    }
+
+    if (strcmp(cmd->args[1], "off") == 0) {
+        cgroup_mode = CGROUP_OFF;
+        return 0;
+    }
+
+    for (i = 0; i < CGROUP_LIMIT_COUNT; i++) {
+        if (strcmp(cmd->args[1], cgroup_limits[i].file) == 0) {
+            break;
+        }
+    }
+    if (i == CGROUP_LIMIT_COUNT || cmd->argc < 3) {
+        fprintf(stderr, "用法: cgroup [on [job|batch]|off]\n"
+                        "      cgroup cpu.max|memory.max|io.weight <value>\n");
+        return -1;
+    }
+
+    /* 其余参数以空格连接，例如 cpu.max 50000 100000 */
+    cgroup_limits[i].value[0] = '\0';
+    for (j = 2, len = 0; j < cmd->argc; j++) {
+        len += snprintf(cgroup_limits[i].value + len,
+                        sizeof(cgroup_limits[i].value) - len,
+                        j > 2 ? " %s" : "%s", cmd->args[j]);
+        if (len >= sizeof(cgroup_limits[i].value)) {
+            fprintf(stderr, "cgroup: 设置值过长\n");
+            cgroup_limits[i].value[0] = '\0';
+            return -1;
+        }
+    }
+    if (cgroup_base[0] != '\0' && !cgroup_limits[i].enabled) {
+        fprintf(stderr, "cgroup: %s 控制器不可用，%s 不会生效\n",
+                cgroup_limits[i].controller, cgroup_limits[i].file);
+    }
+
+    return 0;
+}
+
+/* ========== CPU/NUMA 亲和性 ========== */
+
+/* NUMA 拓扑所在目录 */
+#define NODE_ROOT "/sys/devices/system/node"
+
+/* 支持的最大 NUMA 节点数 */
+#define MAX_NODES 64
+
+/* 放置策略 */
+#define AFFINITY_OFF     0  /* 不绑定 */
+#define AFFINITY_COMPACT 1  /* 每个作业一个 CPU，按节点顺序依次填满 */
+#define AFFINITY_SPREAD  2  /* 每个作业一个节点的全部 CPU，节点间轮转 */
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1    /* 优先从指定节点分配内存 */
+#endif
+
+/* 当前放置策略 */
+static int affinity_policy = AFFINITY_OFF;
+
+/* 已分配的作业序号，用于轮转 */
+static unsigned long affinity_seq = 0;
+
+/* NUMA 拓扑：只包含 shell 允许使用的 CPU，节点按编号排序 */
+static int topology_loaded = 0;
+static int node_count = 0;
+static int node_ids[MAX_NODES];
+static cpu_set_t node_cpus[MAX_NODES];
+
+/* 按节点顺序排列的全部可用 CPU */
+static int cpu_order[CPU_SETSIZE];
+static int cpu_total = 0;
+
+/**
+ * parse_cpulist - 解析 CPU 列表字符串
+ *
+ * 功能：支持 "0-3,8,10-11" 格式
+ * 参数：text - CPU 列表，set - 输出参数
+ * 返回：0 表示成功，-1 表示格式错误
+ */
+static int parse_cpulist(const char *text, cpu_set_t *set) {
+    const char *p = text;
+    char *end;
+    long first, last, cpu;
+
+    CPU_ZERO(set);
+    while (*p != '\0' && *p != '\n') {
+        first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return -1;
+        }
+        last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        if (last >= CPU_SETSIZE) {
+            return -1;
+        }
+        for (cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0' && *p != '\n') {
+            return -1;
+        }
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/**
+ * parse_cpumask - 解析十六进制 CPU 掩码
+ *
+ * 参数：text - 掩码字符串，如 0x3 或 f0，set - 输出参数
+ * 返回：0 表示成功，-1 表示格式错误
+ */
+static int parse_cpumask(const char *text, cpu_set_t *set) {
+    int len, i, bit, digit;
+
+    if (strncmp(text, "0x", 2) == 0 || strncmp(text, "0X", 2) == 0) {
+        text += 2;
+    }
+    len = strlen(text);
+    if (len == 0 || len * 4 > CPU_SETSIZE) {
+        return -1;
+    }
+
+    CPU_ZERO(set);
+    for (i = 0; i < len; i++) {
+        char c = text[len - 1 - i];
+
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        for (bit = 0; bit < 4; bit++) {
+            if (digit & (1 << bit)) {
+                CPU_SET(i * 4 + bit, set);
+            }
+        }
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+/**
+ * format_cpulist - 把 CPU 集合格式化为列表字符串
+ *
+ * 参数：set - CPU 集合，buf - 缓冲区，size - 缓冲区大小
+ */
+static void format_cpulist(cpu_set_t *set, char *buf, size_t size) {
+    size_t len = 0;
+    int cpu, last;
+
+    buf[0] = '\0';
+    for (cpu = 0; cpu < CPU_SETSIZE && len < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) {
+            continue;
+        }
+        last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) {
+            last++;
+        }
+        if (last == cpu) {
+            len += snprintf(buf + len, size - len, len ? ",%d" : "%d", cpu);
+        } else {
+            len += snprintf(buf + len, size - len, len ? ",%d-%d" : "%d-%d",
+                            cpu, last);
+        }
+        cpu = last;
+    }
+}
+
+/**
+ * load_topology - 读取 NUMA 拓扑
+ *
+ * 功能：从 sysfs 读取每个节点的 CPU 列表，并与 shell 当前允许的
+ *       CPU 取交集；没有 NUMA 信息时视为一个节点（编号 -1，不设内存策略）
+ */
+static void load_topology() {
+    cpu_set_t allowed, cpus;
+    char path[MAX_PATH];
+    char buf[1024];
+    DIR *dir;
+    struct dirent *entry;
+    int id, i, j, fd;
+    ssize_t len;
+
+    if (topology_loaded) {
+        return;
+    }
+    topology_loaded = 1;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+        CPU_ZERO(&allowed);
+        CPU_SET(0, &allowed);
+    }
+
+    dir = opendir(NODE_ROOT);
+    while (dir != NULL && (entry = readdir(dir)) != NULL && node_count < MAX_NODES) {
+        if (sscanf(entry->d_name, "node%d", &id) != 1) {
+            continue;
+        }
+        snprintf(path, sizeof(path), NODE_ROOT "/node%d/cpulist", id);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        len = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (len <= 0) {
+            continue;
+        }
+        buf[len] = '\0';
+        if (parse_cpulist(buf, &cpus) < 0) {
+            continue;
+        }
+        CPU_AND(&cpus, &cpus, &allowed);
+        if (CPU_COUNT(&cpus) == 0) {
+            continue;
+        }
+
+        /* 按节点编号插入排序 */
+        for (i = node_count; i > 0 && node_ids[i - 1] > id; i--) {
+            node_ids[i] = node_ids[i - 1];
+            node_cpus[i] = node_cpus[i - 1];
+        }
+        node_ids[i] = id;
+        node_cpus[i] = cpus;
+        node_count++;
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    if (node_count == 0) {
+        node_ids[0] = -1;
+        node_cpus[0] = allowed;
+        node_count = 1;
+    }
+
+    /* 按节点顺序展开所有 CPU */
+    for (i = 0; i < node_count; i++) {
+        for (j = 0; j < CPU_SETSIZE; j++) {
+            if (CPU_ISSET(j, &node_cpus[i])) {
+                cpu_order[cpu_total++] = j;
+            }
+        }
+    }
+}
+
+/**
+ * node_of_cpus - 查找完全包含一组 CPU 的 NUMA 节点
+ *
+ * 参数：cpus - CPU 集合
+ * 返回：节点编号，跨节点或未知时返回 -1
+ */
+static int node_of_cpus(cpu_set_t *cpus) {
+    cpu_set_t common;
+    int i;
+
+    for (i = 0; i < node_count; i++) {
+        CPU_AND(&common, cpus, &node_cpus[i]);
+        if (CPU_EQUAL(&common, cpus)) {
+            return node_ids[i];
+        }
+    }
+    return -1;
+}
+
+/**
+ * affinity_choose - 为即将启动的作业选择放置方案
+ *
+ * 功能：taskset 指定的 CPU 集合优先；否则 compact 策略依次分配单个 CPU，
+ *       spread 策略在 NUMA 节点之间轮转，每个作业使用一个节点的全部 CPU
+ * 参数：cmd - Command 结构体指针（NULL 表示没有 taskset，如管道的一段），
+ *       pl - 输出参数
+ */
+void affinity_choose(Command *cmd, Placement *pl) {
+    char list[96];
+    int n;
+
+    pl->active = 0;
+    pl->node = -1;
+    pl->desc[0] = '\0';
+
+    if ((cmd == NULL || !cmd->has_cpus) && affinity_policy == AFFINITY_OFF) {
+        return;
+    }
+    load_topology();
+
+    if (cmd != NULL && cmd->has_cpus) {
+        pl->cpus = cmd->cpus;
+        pl->node = node_of_cpus(&pl->cpus);
+    } else if (affinity_policy == AFFINITY_COMPACT) {
+        n = cpu_order[affinity_seq++ % cpu_total];
+        CPU_ZERO(&pl->cpus);
+        CPU_SET(n, &pl->cpus);
+        pl->node = node_of_cpus(&pl->cpus);
+    } else {
+        n = affinity_seq++ % node_count;
+        pl->cpus = node_cpus[n];
+        pl->node = node_ids[n];
+    }
+    pl->active = 1;
+
+    format_cpulist(&pl->cpus, list, sizeof(list));
+    if (pl->node >= 0) {
+        snprintf(pl->desc, sizeof(pl->desc), "cpus=%s node=%d", list, pl->node);
+    } else {
+        snprintf(pl->desc, sizeof(pl->desc), "cpus=%s", list);
+    }
+}
+
+/**
+ * affinity_apply - 在子进程中应用放置方案
+ *
+ * 功能：设置 CPU 亲和性；放置在单个节点上时再把内存策略设为
+ *       优先从该节点分配（内核不支持 NUMA 时忽略）
+ * 参数：pl - 放置方案
+ * 返回：0 表示成功，-1 表示失败
+ */
+int affinity_apply(Placement *pl) {
+    unsigned long nodemask[MAX_NODES / (8 * sizeof(unsigned long)) + 1];
+
+    if (!pl->active) {
+        return 0;
+    }
+
+    if (sched_setaffinity(0, sizeof(pl->cpus), &pl->cpus) < 0) {
+        perror("taskset");
+        return -1;
+    }
+
+#ifdef SYS_set_mempolicy
+    if (pl->node >= 0 && pl->node < MAX_NODES) {
+        memset(nodemask, 0, sizeof(nodemask));
+        nodemask[pl->node / (8 * sizeof(unsigned long))] |=
+            1UL << (pl->node % (8 * sizeof(unsigned long)));
+        syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodemask,
+                sizeof(nodemask) * 8);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * cmd_taskset - 指定 CPU 亲和性执行命令
+ *
+ * 功能：taskset -c CPULIST command [args...]
+ *       taskset MASK command [args...]
+ *       去掉前缀后继续按普通命令执行，可以与 timeout 等前缀组合
+ * 参数：cmd - Command 结构体指针
+ * 返回：命令的执行结果，参数错误返回 -1
+ */
+int cmd_taskset(Command *cmd) {
+    int shift;
+    int ret;
+    int i;
+
+    if (cmd->argc > 3 && strcmp(cmd->args[1], "-c") == 0) {
+        ret = parse_cpulist(cmd->args[2], &cmd->cpus);
+        shift = 3;
+    } else if (cmd->argc > 2 && cmd->args[1][0] != '-') {
+        ret = parse_cpumask(cmd->args[1], &cmd->cpus);
+        shift = 2;
+    } else {
+        fprintf(stderr, "用法: taskset -c CPULIST command [args...]\n"
+                        "      taskset MASK command [args...]\n");
+        return -1;
+    }
+
+    if (ret < 0) {
+        fprintf(stderr, "taskset: 无效的 CPU 集合 '%s'\n", cmd->args[shift - 1]);
+        return -1;
+    }
+    cmd->has_cpus = 1;
+
+    /* CPU 集合在 execute_external 的子进程中应用，在 shell 进程中执行的
+     * 函数和内部命令无法绑定 */
+    if (runs_in_shell(cmd->args[shift])) {
+        fprintf(stderr, "taskset: %s: 只能绑定外部程序\n", cmd->args[shift]);
+        return -1;
+    }
+
+    /* 去掉的单词由 build_command 分配，command_release 不再看到它们 */
+    for (i = 0; i < shift; i++) {
+        free(cmd->args[i]);
+    }
+    memmove(cmd->args, cmd->args + shift,
+            (cmd->argc - shift + 1) * sizeof(char *));
+    cmd->argc -= shift;
+
+    return execute_command(cmd);
+}
+
+/**
+ * cmd_affinity - CPU/NUMA 放置策略命令
+ *
+ * 功能：affinity                  显示策略和 NUMA 拓扑
+ *       affinity off|compact|spread  设置策略，之后启动的作业自动绑定
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_affinity(Command *cmd) {
+    static const char *policy_names[] = { "off", "compact", "spread" };
+    char list[256];
+    int i;
+
+    if (cmd->argc == 1) {
+        load_topology();
+        printf("policy: %s\n", policy_names[affinity_policy]);
+        for (i = 0; i < node_count; i++) {
+            format_cpulist(&node_cpus[i], list, sizeof(list));
+            if (node_ids[i] >= 0) {
+                printf("node %d: cpus=%s\n", node_ids[i], list);
+            } else {
+                printf("cpus=%s\n", list);
+            }
+        }
+        return 0;
+    }
+
+    for (i = 0; i < 3; i++) {
+        if (strcmp(cmd->args[1], policy_names[i]) == 0) {
+            affinity_policy = i;
+            affinity_seq = 0;
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "用法: affinity [off|compact|spread]\n");
+    return -1;
+}
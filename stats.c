@@ -0,0 +1,345 @@
+/*
+ * stats.c - MyShell 运行统计
+ *
+ * 功能：一直开启的计数器，记录 shell 自身做了多少工作：解析的命令数、
+ *       内部命令和外部程序的执行次数、fork 次数、回收的子进程数、
+ *       打开的重定向数、内部命令输出的字节数，以及 fork 和等待子进程的
+ *       耗时分布（平均值、p99、最大值）。计数只是数组元素加一，
+ *       耗时用固定大小的对数直方图统计，不分配内存。
+ *       stats 命令显示统计，--stats 文件 在退出时把统计写成 JSON
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+#include <stdio_ext.h>
+
+/* 耗时直方图：每个 2 的幂区间再分为 4 格，误差不超过 25% */
+#define LATENCY_SUB_BITS 2
+#define LATENCY_BUCKETS  256
+
+/**
+ * Latency 结构体 - 一类操作的耗时分布
+ *
+ * 字段说明：
+ *   count    - 次数
+ *   total    - 总耗时（纳秒）
+ *   max      - 最大耗时（纳秒）
+ *   buckets  - 直方图，下标由 latency_bucket 计算
+ */
+typedef struct {
+    long long count;
+    long long total;
+    long long max;
+    long long buckets[LATENCY_BUCKETS];
+} Latency;
+
+/* 计数器名称（JSON 键）和说明，下标为 STAT_* */
+static const char *counter_names[STAT_COUNT][2] = {
+    { "commands_parsed",   "解析的命令行" },
+    { "builtins",          "内部命令" },
+    { "functions",         "函数调用" },
+    { "externals",         "外部程序" },
+    { "forks",             "fork 次数" },
+    { "reaped",            "回收的子进程" },
+    { "redirections",      "重定向" },
+    { "builtin_bytes",     "内部命令输出字节" },
+};
+
+/* 耗时名称和说明，下标为 LATENCY_* */
+static const char *latency_names[LATENCY_COUNT][2] = {
+    { "spawn",  "fork 耗时" },
+    { "wait",   "等待子进程" },
+};
+
+static long long counters[STAT_COUNT];
+static Latency latencies[LATENCY_COUNT];
+
+/* 正在执行的内部命令的嵌套层数，以及被计数流替换的 stdout */
+static int builtin_depth = 0;
+static FILE *builtin_stdout = NULL;
+
+/* --stats 指定的 JSON 文件，NULL 表示退出时不输出 */
+static const char *dump_path = NULL;
+
+/* ========== 计数 ========== */
+
+/**
+ * stats_add - 增加计数器
+ *
+ * 参数：counter - STAT_* 之一，n - 增加的数量
+ */
+void stats_add(int counter, long long n) {
+    counters[counter] += n;
+}
+
+/**
+ * stats_clock - 获取单调时钟的当前时间
+ *
+ * 返回：纳秒
+ */
+long long stats_clock() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * latency_bucket - 计算耗时所在的直方图格
+ *
+ * 功能：小于 4 纳秒的各占一格；其余按最高位所在的 2 的幂区间分组，
+ *       再按最高位之后的 2 位分为 4 格
+ */
+static int latency_bucket(long long ns) {
+    int bits;
+
+    if (ns < (1 << LATENCY_SUB_BITS)) {
+        return ns < 0 ? 0 : (int)ns;
+    }
+    bits = 63 - __builtin_clzll((unsigned long long)ns);
+    return ((bits - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+           (int)((ns >> (bits - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1));
+}
+
+/**
+ * latency_upper - 直方图格的上界（纳秒）
+ */
+static long long latency_upper(int bucket) {
+    int shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    int sub = bucket & ((1 << LATENCY_SUB_BITS) - 1);
+
+    if (bucket < (1 << LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+    return ((long long)((1 << LATENCY_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+/**
+ * stats_latency - 记录一次操作的耗时
+ *
+ * 参数：which - LATENCY_* 之一，ns - 耗时（纳秒）
+ */
+void stats_latency(int which, long long ns) {
+    Latency *lat = &latencies[which];
+
+    lat->count++;
+    lat->total += ns;
+    if (ns > lat->max) {
+        lat->max = ns;
+    }
+    lat->buckets[latency_bucket(ns)]++;
+}
+
+/**
+ * latency_percentile - 估计耗时的百分位数
+ *
+ * 返回：百分位数所在格的上界，不超过最大值（纳秒）
+ */
+static long long latency_percentile(const Latency *lat, int percent) {
+    long long rank = (lat->count * percent + 99) / 100;
+    long long seen = 0;
+    int i;
+
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += lat->buckets[i];
+        if (seen >= rank && seen > 0) {
+            return latency_upper(i) < lat->max ? latency_upper(i) : lat->max;
+        }
+    }
+    return lat->max;
+}
+
+/**
+ * stats_fork - fork 并记录次数和耗时
+ *
+ * 功能：耗时在父进程中记录，包括复制页表等内核开销
+ * 返回：同 fork
+ */
+pid_t stats_fork() {
+    long long start = stats_clock();
+    pid_t pid = fork();
+
+    if (pid > 0) {
+        counters[STAT_FORKS]++;
+        stats_latency(LATENCY_SPAWN, stats_clock() - start);
+    }
+    return pid;
+}
+
+/* ========== 内部命令的输出 ========== */
+
+/**
+ * counting_write - 计数流的写函数，写到描述符 1 并累计字节数
+ */
+static ssize_t counting_write(void *cookie, const char *data, size_t len) {
+    size_t done = 0;
+    ssize_t n;
+
+    (void)cookie;
+    while (done < len) {
+        n = write(STDOUT_FILENO, data + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        done += n;
+    }
+    counters[STAT_BUILTIN_BYTES] += done;
+    return done > 0 ? (ssize_t)done : -1;
+}
+
+/**
+ * counting_stream - 取得与 stdout 缓冲方式相同的计数流
+ *
+ * 功能：行缓冲和全缓冲各一个，第一次使用时创建，之后一直复用
+ * 返回：计数流，无法创建时返回 NULL
+ */
+static FILE* counting_stream(int line_buffered) {
+    static FILE *streams[2];
+    cookie_io_functions_t io = { NULL, counting_write, NULL, NULL };
+    FILE *fp = streams[line_buffered];
+
+    if (fp == NULL && (fp = fopencookie(NULL, "w", io)) != NULL) {
+        setvbuf(fp, NULL, line_buffered ? _IOLBF : _IOFBF, BUFSIZ);
+        streams[line_buffered] = fp;
+    }
+    return fp;
+}
+
+/**
+ * stats_builtin_begin - 内部命令开始执行，stdout 换成计数流
+ *
+ * 功能：在内部命令的重定向生效之后调用。先刷新原来的 stdout，再让
+ *       stdout 指向写描述符 1 的计数流，内部命令经 stdio 写出的字节
+ *       在写出时计入；cat 等直接写描述符的由它们自己计入。
+ *       只在内部命令执行期间替换，嵌套执行的内部命令沿用最外层的计数流
+ */
+void stats_builtin_begin() {
+    FILE *fp;
+
+    if (builtin_depth++ > 0) {
+        return;
+    }
+    fp = counting_stream(__flbf(stdout) != 0);
+    if (fp != NULL) {
+        fflush(stdout);
+        builtin_stdout = stdout;
+        stdout = fp;
+    }
+}
+
+/**
+ * stats_builtin_end - 内部命令执行结束，恢复原来的 stdout
+ *
+ * 功能：刷新计数流，缓冲区中剩余的输出在恢复之前写出并计入
+ */
+void stats_builtin_end() {
+    if (builtin_depth == 0 || --builtin_depth > 0 || builtin_stdout == NULL) {
+        return;
+    }
+    fflush(stdout);
+    stdout = builtin_stdout;
+    builtin_stdout = NULL;
+}
+
+/* ========== 输出 ========== */
+
+/**
+ * stats_print - 以表格形式输出统计
+ */
+static void stats_print(FILE *fp) {
+    const Latency *lat;
+    int i;
+
+    for (i = 0; i < STAT_COUNT; i++) {
+        fprintf(fp, "%s: %lld\n", counter_names[i][1], counters[i]);
+    }
+    for (i = 0; i < LATENCY_COUNT; i++) {
+        lat = &latencies[i];
+        fprintf(fp, "%s: %lld 次，平均 %.1f us，p99 %.1f us，最大 %.1f us\n",
+                latency_names[i][1], lat->count,
+                lat->count ? lat->total / 1000.0 / lat->count : 0.0,
+                latency_percentile(lat, 99) / 1000.0, lat->max / 1000.0);
+    }
+}
+
+/**
+ * stats_json - 以 JSON 输出统计
+ *
+ * 功能：计数器为整数；耗时为对象，单位为纳秒
+ */
+static void stats_json(FILE *fp) {
+    const Latency *lat;
+    int i;
+
+    fprintf(fp, "{\n  \"pid\": %d", (int)getpid());
+    for (i = 0; i < STAT_COUNT; i++) {
+        fprintf(fp, ",\n  \"%s\": %lld", counter_names[i][0], counters[i]);
+    }
+    for (i = 0; i < LATENCY_COUNT; i++) {
+        lat = &latencies[i];
+        fprintf(fp, ",\n  \"%s_ns\": { \"count\": %lld, \"avg\": %lld, \"p99\": %lld, \"max\": %lld }",
+                latency_names[i][0], lat->count, lat->count ? lat->total / lat->count : 0,
+                latency_percentile(lat, 99), lat->max);
+    }
+    fprintf(fp, "\n}\n");
+}
+
+/**
+ * stats_dump_at_exit - 设置退出时写入统计的 JSON 文件
+ *
+ * 参数：path - 文件路径，"-" 表示标准错误
+ */
+void stats_dump_at_exit(const char *path) {
+    dump_path = path;
+}
+
+/**
+ * stats_shutdown - 退出时按 --stats 写入 JSON
+ */
+void stats_shutdown() {
+    FILE *fp;
+
+    if (dump_path == NULL) {
+        return;
+    }
+    if (strcmp(dump_path, "-") == 0) {
+        stats_json(stderr);
+        return;
+    }
+    fp = fopen(dump_path, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "myshell: 无法写入统计文件 '%s': %s\n", dump_path, strerror(errno));
+        return;
+    }
+    stats_json(fp);
+    fclose(fp);
+}
+
+/**
+ * cmd_stats - 显示 shell 的运行统计
+ *
+ * 功能：stats 以表格显示；stats -j 以 JSON 显示；stats -r 清零
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示参数错误
+ */
+int cmd_stats(Command *cmd) {
+    if (cmd->argc == 1) {
+        stats_print(stdout);
+        return 0;
+    }
+    if (cmd->argc == 2 && strcmp(cmd->args[1], "-j") == 0) {
+        stats_json(stdout);
+        return 0;
+    }
+    if (cmd->argc == 2 && strcmp(cmd->args[1], "-r") == 0) {
+        memset(counters, 0, sizeof(counters));
+        memset(latencies, 0, sizeof(latencies));
+        return 0;
+    }
+    fprintf(stderr, "用法: stats [-j | -r]\n");
+    return -1;
+}
@@ -0,0 +1,29 @@
+#!/bin/sh
+# builtin_redirect.sh - 输出到标准输出的内部命令的重定向
+#
+# 用法：sh tests/builtin_redirect.sh [myshell 路径]
+
+SHELL_BIN=${1:-./myshell}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+fail=0
+
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FAIL: $1: 期望 '$3'，实际 '$2'"
+        fail=1
+    fi
+}
+
+for cmd in environ "help cd" history jobs ulimit acct affinity cgroup; do
+    rm -f "$dir/out"
+    "$SHELL_BIN" -c "$cmd > $dir/out" > "$dir/tty" 2>/dev/null
+    check "$cmd > 文件 创建文件" "$(test -f "$dir/out" && echo yes)" yes
+    check "$cmd > 文件 不输出到终端" "$(cat "$dir/tty")" ""
+done
+
+"$SHELL_BIN" -c "printf 'x\\n' > $dir/a; history >> $dir/a; jobs >> $dir/a"
+check "内部命令 >> 文件 追加" "$(cat "$dir/a")" "x"
+
+[ $fail -eq 0 ] && echo "builtin_redirect: OK"
+exit $fail
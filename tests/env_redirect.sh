@@ -0,0 +1,36 @@
+#!/bin/sh
+# env_redirect.sh - env 命令的输出重定向
+#
+# 用法：sh tests/env_redirect.sh [myshell 路径]
+
+SHELL_BIN=${1:-./myshell}
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+fail=0
+
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FAIL: $1: 期望 '$3'，实际 '$2'"
+        fail=1
+    fi
+}
+
+"$SHELL_BIN" -c "env > $dir/out" > "$dir/tty"
+check "env > 文件 创建文件" "$(test -s "$dir/out" && echo yes)" yes
+check "env > 文件 不输出到终端" "$(cat "$dir/tty")" ""
+
+"$SHELL_BIN" -c "env -i A=1 > $dir/a; env -i B=2 >> $dir/a" > "$dir/tty"
+check "env 名字=值 > 文件" "$(cat "$dir/a")" "A=1
+B=2"
+check "env 名字=值 不输出到终端" "$(cat "$dir/tty")" ""
+
+"$SHELL_BIN" -c "env -i C=3 env > $dir/c"
+check "env 执行命令时的重定向" "$(cat "$dir/c")" "C=3"
+
+printf 'x\n' > "$dir/in"
+"$SHELL_BIN" -c "env -i D=4 /bin/cat < $dir/in >> $dir/c"
+check "env 执行命令时的输入重定向" "$(cat "$dir/c")" "C=3
+x"
+
+[ $fail -eq 0 ] && echo "env_redirect: OK"
+exit $fail
@@ -0,0 +1,82 @@
+/*
+ * trace.c - MyShell 跟踪标记文件
+ *
+ * 功能：--trace 文件 运行时，trace.h 中的跟踪点把带时间戳的标记写入文件。
+ *       时间为 CLOCK_MONOTONIC 纳秒，与 perf record -k CLOCK_MONOTONIC
+ *       记录的采样使用同一时钟。每个标记用一次 write 追加，shell 异常终止
+ *       时已写入的标记不会丢失，fork 出的子进程也不会重复输出缓冲的内容
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+
+/* 标记中文本的最大长度，多行命令只保留第一行 */
+#define TRACE_TEXT_MAX 200
+
+/* 标记文件描述符，-1 表示没有开启 */
+static int trace_fd = -1;
+
+/**
+ * trace_open - 开启标记文件
+ *
+ * 功能：清空文件并写入说明行
+ * 参数：path - 文件路径
+ * 返回：0 表示成功，-1 表示失败
+ */
+int trace_open(const char *path) {
+    static const char header[] = "# myshell trace: 单调时钟(ns) 跟踪点 数值 文本\n";
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (trace_fd < 0) {
+        fprintf(stderr, "myshell: 无法打开跟踪文件 '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (write(trace_fd, header, sizeof(header) - 1) < 0) {
+        perror("myshell: trace");
+    }
+    return 0;
+}
+
+/**
+ * trace_active - 判断是否开启了标记文件
+ *
+ * 返回：1 表示开启，0 表示没有
+ */
+int trace_active() {
+    return trace_fd >= 0;
+}
+
+/**
+ * trace_mark - 写入一个标记
+ *
+ * 功能：文本中的换行之后的部分被截去，制表符和回车替换为空格
+ * 参数：event - 跟踪点名称，num - 整数参数，text - 文本参数
+ */
+void trace_mark(const char *event, long long num, const char *text) {
+    char entry[TRACE_TEXT_MAX + 96];
+    int len, i;
+
+    len = snprintf(entry, sizeof(entry), "%lld %s %lld ", stats_clock(), event, num);
+    for (i = 0; text != NULL && text[i] != '\0' && text[i] != '\n' &&
+                i < TRACE_TEXT_MAX; i++) {
+        entry[len++] = (text[i] == '\t' || text[i] == '\r') ? ' ' : text[i];
+    }
+    entry[len++] = '\n';
+
+    if (write(trace_fd, entry, len) < 0) {
+        perror("myshell: trace");
+        close(trace_fd);
+        trace_fd = -1;
+    }
+}
+
+/**
+ * trace_close - 关闭标记文件
+ */
+void trace_close() {
+    if (trace_fd >= 0) {
+        close(trace_fd);
+        trace_fd = -1;
+    }
+}
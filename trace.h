@@ -0,0 +1,59 @@
+/*
+ * trace.h - MyShell 跟踪点
+ *
+ * 功能：在读入、解析、执行命令和启动外部程序的位置放置跟踪点，
+ *       perf 和 bpftrace 可以据此把时间归到 shell 的各个阶段和批处理中的
+ *       每条命令，不需要重新编译：
+ *         - 编译时找到 <sys/sdt.h>（systemtap-sdt-dev）时，跟踪点为 USDT
+ *           静态探针（提供者 myshell），没有被跟踪时只是一条 nop 指令：
+ *               perf buildid-cache --add ./myshell
+ *               perf record -e sdt_myshell:command_start -a
+ *               bpftrace -e 'usdt:./myshell:myshell:line_start { ... }'
+ *         - --trace 文件 运行时，跟踪点同时写入标记文件，每行为
+ *           "单调时钟纳秒 跟踪点 数值 文本"，可与 perf record -k CLOCK_MONOTONIC
+ *           的采样按时间对齐
+ *       每个跟踪点有两个参数：一个整数和一个字符串
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ *
+ * 跟踪点：
+ *   read_start      (0, "")                 读取一行输入之前
+ *   read_done       (长度, 行)              读取一行输入之后
+ *   parse_start     (0, 命令文本)           解析之前
+ *   parse_done      (结果, 命令文本)        解析之后，结果为 PARSE_*
+ *   line_start      (序号, 命令文本)        执行一条命令（一行或一个复合命令）之前
+ *   line_done       (退出状态, 命令文本)    执行之后
+ *   command_start   (参数个数, 命令名)      执行简单命令之前
+ *   command_done    (退出状态, 命令名)      执行简单命令之后
+ *   exec_spawn      (进程号, 程序名)        外部程序的子进程创建之后
+ *   exec_done       (退出状态, 程序名)      外部程序结束之后
+ */
+
+#ifndef MYSHELL_TRACE_H
+#define MYSHELL_TRACE_H
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define MYSHELL_HAVE_SDT 1
+#endif
+#endif
+
+#ifdef MYSHELL_HAVE_SDT
+#define TRACE_SDT(name, num, text) DTRACE_PROBE2(myshell, name, (long long)(num), (text))
+#else
+#define TRACE_SDT(name, num, text) do { } while (0)
+#endif
+
+/* 跟踪点：USDT 探针，开启 --trace 时同时写标记文件。
+ * 参数只求值一次，探针和标记文件看到的值相同 */
+#define TRACE(name, num, text) do {                         \
+        long long trace_num_ = (long long)(num);            \
+        const char *trace_text_ = (text);                   \
+        TRACE_SDT(name, trace_num_, trace_text_);           \
+        if (trace_active()) {                               \
+            trace_mark(#name, trace_num_, trace_text_);     \
+        }                                                   \
+    } while (0)
+
+#endif /* MYSHELL_TRACE_H */
@@ -1,12 +1,19 @@
 /*
  * utility.c - MyShell 工具函数
  * 
- * 功能：实现工具类内部命令和外部程序执行功能
+ * 功能：实现工具类内部命令、cat/head/tail/wc 的进程内快速路径
+ *       和外部程序执行功能
  * 作者：操作系统课程项目
  * 日期：2024-12-19
  */
 
 #include "myshell.h"
+#include "trace.h"
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* 外部环境变量数组 */
 extern char **environ;
@@ -100,60 +107,730 @@ int cmd_echo(Command *cmd) {
     return 0;
 }
 
+/* ========== 文件工具快速路径（cat、head、tail、wc） ========== */
+
+/* 内核复制一次请求的最大字节数 */
+#define FAST_CHUNK (1 << 30)
+
+/* read/write 退回路径和按行扫描使用的缓冲区大小 */
+#define FAST_BUFFER_SIZE (128 * 1024)
+
 /**
- * cmd_help - 显示帮助命令
- * 
- * 功能：显示用户手册，使用 more 命令分页
+ * fastpath_usable - 判断能否在 shell 进程内执行文件工具
+ *
+ * 功能：后台、限时和绑定 CPU 的命令需要独立的进程，交给外部程序执行；
+ *       环境变量 MYSHELL_FASTPATH=0 时关闭快速路径
  * 参数：cmd - Command 结构体指针
+ * 返回：1 表示可以，0 表示应执行外部程序
+ */
+static int fastpath_usable(Command *cmd) {
+    const char *env = getenv("MYSHELL_FASTPATH");
+
+    if (env != NULL && strcmp(env, "0") == 0) {
+        return 0;
+    }
+    return !cmd->background && cmd->timeout_ms == 0 && !cmd->has_cpus;
+}
+
+/**
+ * write_all - 写出全部数据
+ *
+ * 参数：fd - 描述符，data - 数据，len - 长度
  * 返回：0 表示成功，-1 表示失败
  */
-int cmd_help(Command *cmd) {
-    FILE *readme_file;
-    FILE *more_pipe;
-    char buffer[MAX_LINE];
-    
-    /* 打开 readme 文件 */
-    readme_file = fopen("readme", "r");
-    if (readme_file == NULL) {
-        /* readme 文件不存在，显示简短帮助信息 */
-        printf("MyShell - 简单的命令行解释器\n\n");
-        printf("内部命令：\n");
-        printf("  cd [directory]  - 改变当前目录\n");
-        printf("  clr             - 清屏\n");
-        printf("  dir [directory] - 列出目录内容\n");
-        printf("  environ         - 列出所有环境变量\n");
-        printf("  echo <text>     - 显示文本\n");
-        printf("  help            - 显示帮助信息\n");
-        printf("  pause           - 暂停直到按回车\n");
-        printf("  quit            - 退出 shell\n\n");
-        printf("支持 I/O 重定向：<, >, >>\n");
-        printf("支持后台执行：&\n");
+static int write_all(int fd, const char *data, size_t len) {
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * copy_fd - 把数据从一个描述符复制到另一个描述符
+ *
+ * 功能：按描述符类型选择不经过用户空间的方式：两端都是普通文件时用
+ *       copy_file_range（可在文件系统内完成，如 reflink），一端是管道时
+ *       用 splice，源是普通文件时用 sendfile。内核不支持当前方式时
+ *       依次退回下一种，最后使用 read/write
+ * 参数：in - 源描述符，out - 目标描述符，limit - 最多复制的字节数（-1 表示不限）
+ * 返回：0 表示成功，-1 表示失败
+ */
+int copy_fd(int in, int out, long long limit) {
+    struct stat si, so;
+    char *buffer = NULL;
+    size_t chunk;
+    ssize_t n;
+    int method;     /* 0 copy_file_range，1 splice，2 sendfile，3 read/write */
+
+    if (fstat(in, &si) < 0 || fstat(out, &so) < 0) {
+        perror("fstat");
+        return -1;
+    }
+    if (S_ISREG(si.st_mode) && S_ISREG(so.st_mode)) {
+        method = 0;
+    } else if (S_ISFIFO(si.st_mode) || S_ISFIFO(so.st_mode)) {
+        method = 1;
+    } else {
+        method = S_ISREG(si.st_mode) ? 2 : 3;
+    }
+
+    while (limit != 0) {
+        chunk = (limit < 0 || limit > FAST_CHUNK) ? FAST_CHUNK : (size_t)limit;
+        switch (method) {
+        case 0:
+            n = copy_file_range(in, NULL, out, NULL, chunk, 0);
+            break;
+        case 1:
+            n = splice(in, NULL, out, NULL, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+            break;
+        case 2:
+            n = sendfile(out, in, NULL, chunk);
+            break;
+        default:
+            if (buffer == NULL && (buffer = malloc(FAST_BUFFER_SIZE)) == NULL) {
+                perror("malloc");
+                return -1;
+            }
+            n = read(in, buffer, chunk < FAST_BUFFER_SIZE ? chunk : FAST_BUFFER_SIZE);
+            if (n > 0 && write_all(out, buffer, n) < 0) {
+                n = -1;
+            }
+            break;
+        }
+
+        if (n < 0) {
+            if (errno == EINTR && !job_interrupted()) {
+                continue;
+            }
+            /* 文件系统、文件类型或 O_APPEND 不支持当前方式：换下一种 */
+            if (method < 3 && (errno == EINVAL || errno == ENOSYS || errno == EXDEV ||
+                               errno == EOPNOTSUPP || errno == EBADF)) {
+                method = (method < 2 && S_ISREG(si.st_mode)) ? 2 : 3;
+                continue;
+            }
+            free(buffer);
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (out == STDOUT_FILENO) {
+            stats_add(STAT_BUILTIN_BYTES, n);
+        }
+        if (limit > 0) {
+            limit -= n;
+        }
+    }
+
+    free(buffer);
+    return 0;
+}
+
+/**
+ * count_newlines - 统计缓冲区中的换行符个数
+ *
+ * 功能：支持 SSE2 时每次比较 64 字节，用比较掩码的位数累加
+ * 参数：data - 数据，len - 长度
+ * 返回：换行符个数
+ */
+static size_t count_newlines(const char *data, size_t len) {
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+
+    for (; i + 64 <= len; i += 64) {
+        __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i)), newline);
+        __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 16)), newline);
+        __m128i c = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 32)), newline);
+        __m128i d = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + 48)), newline);
+        unsigned long long mask = (unsigned long long)(unsigned)_mm_movemask_epi8(a) |
+                                  (unsigned long long)(unsigned)_mm_movemask_epi8(b) << 16 |
+                                  (unsigned long long)(unsigned)_mm_movemask_epi8(c) << 32 |
+                                  (unsigned long long)(unsigned)_mm_movemask_epi8(d) << 48;
+        count += __builtin_popcountll(mask);
+    }
+#endif
+
+    for (; i < len; i++) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+/**
+ * open_input - 打开文件工具的输入文件
+ *
+ * 功能："-" 表示标准输入
+ * 参数：tool - 命令名（用于错误信息），name - 文件名
+ * 返回：描述符，失败返回 -1
+ */
+static int open_input(const char *tool, const char *name) {
+    int fd;
+
+    if (strcmp(name, "-") == 0) {
+        return STDIN_FILENO;
+    }
+    fd = open(name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s: %s\n", tool, name, strerror(errno));
+    }
+    return fd;
+}
+
+/**
+ * close_input - 关闭 open_input 打开的描述符
+ */
+static void close_input(int fd) {
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+}
+
+/**
+ * parse_count - 解析 head/tail 的行数或字节数
+ *
+ * 功能：只接受非负十进制整数，其他写法（如 -5、1K）交给外部程序
+ * 参数：text - 参数，value - 输出参数，保存数值
+ * 返回：0 表示成功，-1 表示不支持
+ */
+static int parse_count(const char *text, long long *value) {
+    char *end;
+
+    if (text == NULL || *text < '0' || *text > '9') {
+        return -1;
+    }
+    errno = 0;
+    *value = strtoll(text, &end, 10);
+    return (*end != '\0' || errno != 0) ? -1 : 0;
+}
+
+/**
+ * parse_head_tail - 解析 head/tail 的选项
+ *
+ * 功能：支持 -n N、-nN、-N、-c N、-cN
+ * 参数：cmd - Command 结构体指针，count - 输出参数，保存数量（默认 10 行），
+ *       bytes - 输出参数，1 表示按字节计数，first - 输出参数，第一个文件参数的下标
+ * 返回：0 表示成功，-1 表示有不支持的选项
+ */
+static int parse_head_tail(Command *cmd, long long *count, int *bytes, int *first) {
+    const char *arg;
+    int i;
+
+    *count = 10;
+    *bytes = 0;
+    for (i = 1; i < cmd->argc; i++) {
+        arg = cmd->args[i];
+        if (arg[0] != '-' || arg[1] == '\0') {
+            break;
+        }
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        }
+        if (arg[1] == 'n' || arg[1] == 'c') {
+            *bytes = arg[1] == 'c';
+            if (parse_count(arg[2] ? arg + 2 : (i + 1 < cmd->argc ? cmd->args[++i] : NULL), count) < 0) {
+                return -1;
+            }
+        } else if (parse_count(arg + 1, count) < 0) {
+            return -1;
+        }
+    }
+    *first = i;
+    return 0;
+}
+
+/**
+ * print_file_header - 多个文件时输出 "==> 文件名 <==" 标题
+ *
+ * 参数：name - 文件名，index - 第几个文件（从 0 开始）
+ */
+static void print_file_header(const char *name, int index) {
+    printf("%s==> %s <==\n", index > 0 ? "\n" : "",
+           strcmp(name, "-") == 0 ? "standard input" : name);
+    fflush(stdout);
+}
+
+/**
+ * is_output_file - 判断输入是否就是标准输出所写的普通文件
+ *
+ * 功能：cat f >> f 会不断读到刚追加的内容而永不结束，与 GNU cat 相同，
+ *       这样的输入报错并跳过
+ * 参数：fd - 输入描述符，name - 输入名（用于错误信息）
+ * 返回：1 表示是同一个文件（已输出错误信息），0 表示不是
+ */
+static int is_output_file(int fd, const char *name) {
+    struct stat si, so;
+
+    if (fstat(fd, &si) < 0 || fstat(STDOUT_FILENO, &so) < 0 || !S_ISREG(so.st_mode) ||
+        si.st_dev != so.st_dev || si.st_ino != so.st_ino) {
         return 0;
     }
-    
-    /* 打开管道到 more 命令 */
-    more_pipe = popen("more", "w");
-    if (more_pipe == NULL) {
-        /* more 命令不可用，直接输出到标准输出 */
-        while (fgets(buffer, MAX_LINE, readme_file) != NULL) {
-            printf("%s", buffer);
-        }
-        fclose(readme_file);
+    fprintf(stderr, "cat: %s: 输入文件就是输出文件\n", name);
+    return 1;
+}
+
+/**
+ * cmd_cat - 连接并输出文件
+ *
+ * 功能：在 shell 进程内把文件复制到标准输出（见 copy_fd）。
+ *       使用 -n 等选项时执行外部 cat，
+ *       输入与输出是同一个普通文件时报错并跳过该输入
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_cat(Command *cmd) {
+    int result = 0;
+    int fd;
+    int i;
+
+    for (i = 1; i < cmd->argc; i++) {
+        if (cmd->args[i][0] == '-' && cmd->args[i][1] != '\0' && strcmp(cmd->args[i], "-u") != 0) {
+            return execute_external(cmd);
+        }
+    }
+    if (!fastpath_usable(cmd)) {
+        return execute_external(cmd);
+    }
+
+    fflush(stdout);
+    if (cmd->argc == 1) {
+        if (is_output_file(STDIN_FILENO, "-")) {
+            return -1;
+        }
+        return copy_fd(STDIN_FILENO, STDOUT_FILENO, -1) < 0 ? (perror("cat"), -1) : 0;
+    }
+    for (i = 1; i < cmd->argc; i++) {
+        if (strcmp(cmd->args[i], "-u") == 0) {
+            continue;
+        }
+        fd = open_input("cat", cmd->args[i]);
+        if (fd < 0) {
+            result = -1;
+            continue;
+        }
+        if (is_output_file(fd, cmd->args[i])) {
+            result = -1;
+        } else if (copy_fd(fd, STDOUT_FILENO, -1) < 0) {
+            fprintf(stderr, "cat: %s: %s\n", cmd->args[i], strerror(errno));
+            result = -1;
+        }
+        close_input(fd);
+    }
+    return result;
+}
+
+/**
+ * head_lines - 输出前 n 行
+ *
+ * 功能：可定位的输入在输出后把读取位置退回到第 n 行之后，
+ *       同一输入上的后续命令能接着读取
+ * 参数：fd - 输入描述符，lines - 行数
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int head_lines(int fd, long long lines) {
+    char *buffer;
+    char *p, *end;
+    ssize_t n;
+    int result = 0;
+
+    if (lines == 0) {
         return 0;
     }
-    
-    /* 逐行读取 readme 并写入 more 管道 */
-    while (fgets(buffer, MAX_LINE, readme_file) != NULL) {
-        fprintf(more_pipe, "%s", buffer);
+    buffer = malloc(FAST_BUFFER_SIZE);
+    if (buffer == NULL) {
+        perror("malloc");
+        return -1;
     }
-    
-    /* 关闭文件和管道 */
-    fclose(readme_file);
-    pclose(more_pipe);
-    
+
+    while (lines > 0) {
+        n = read(fd, buffer, FAST_BUFFER_SIZE);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            result = n < 0 ? -1 : 0;
+            break;
+        }
+        end = buffer + n;
+        for (p = buffer; lines > 0 && (p = memchr(p, '\n', end - p)) != NULL; p++) {
+            lines--;
+        }
+        if (lines > 0) {
+            p = end;
+        }
+        if (write_all(STDOUT_FILENO, buffer, p - buffer) < 0) {
+            result = -1;
+            break;
+        }
+        stats_add(STAT_BUILTIN_BYTES, p - buffer);
+        if (p < end) {
+            lseek(fd, p - end, SEEK_CUR);
+        }
+    }
+
+    free(buffer);
+    return result;
+}
+
+/**
+ * cmd_head - 输出文件开头部分
+ *
+ * 功能：head [-n 行数 | -c 字节数] [文件...]。按字节时用 copy_fd 复制，
+ *       按行时扫描换行符。其他选项执行外部 head
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_head(Command *cmd) {
+    long long count;
+    int bytes, first;
+    int result = 0;
+    int files, fd, i;
+    char *stdin_name = "-";
+    char **names;
+
+    if (!fastpath_usable(cmd) || parse_head_tail(cmd, &count, &bytes, &first) < 0) {
+        return execute_external(cmd);
+    }
+
+    files = cmd->argc - first;
+    names = files > 0 ? cmd->args + first : &stdin_name;
+    if (files == 0) {
+        files = 1;
+    }
+
+    fflush(stdout);
+    for (i = 0; i < files; i++) {
+        fd = open_input("head", names[i]);
+        if (fd < 0) {
+            result = -1;
+            continue;
+        }
+        if (files > 1) {
+            print_file_header(names[i], i);
+        }
+        if ((bytes ? copy_fd(fd, STDOUT_FILENO, count) : head_lines(fd, count)) < 0) {
+            fprintf(stderr, "head: %s: %s\n", names[i], strerror(errno));
+            result = -1;
+        }
+        close_input(fd);
+    }
+    return result;
+}
+
+/**
+ * tail_start - 计算最后 n 行的起始位置
+ *
+ * 功能：从文件末尾向前分块读取并统计换行符，不读取文件的其余部分。
+ *       文件末尾的换行符不算作新的一行
+ * 参数：fd - 输入描述符（普通文件），size - 文件大小，lines - 行数
+ * 返回：起始偏移，失败返回 -1
+ */
+static off_t tail_start(int fd, off_t size, long long lines) {
+    char *buffer;
+    off_t pos = size;
+    off_t block;
+    ssize_t n;
+    char *p;
+    int skip_last = 1;
+
+    if (lines == 0) {
+        return size;
+    }
+    buffer = malloc(FAST_BUFFER_SIZE);
+    if (buffer == NULL) {
+        perror("malloc");
+        return -1;
+    }
+
+    while (pos > 0) {
+        block = pos < FAST_BUFFER_SIZE ? pos : FAST_BUFFER_SIZE;
+        n = pread(fd, buffer, block, pos - block);
+        if (n != block) {
+            free(buffer);
+            return -1;
+        }
+        p = buffer + n;
+        if (skip_last) {
+            /* 文件最后一个字符是换行符时从它之前开始统计 */
+            if (p[-1] == '\n') {
+                p--;
+            }
+            skip_last = 0;
+        }
+        while ((p = memrchr(buffer, '\n', p - buffer)) != NULL) {
+            if (--lines == 0) {
+                pos = pos - block + (p - buffer) + 1;
+                free(buffer);
+                return pos;
+            }
+        }
+        pos -= block;
+    }
+
+    free(buffer);
     return 0;
 }
 
+/**
+ * cmd_tail - 输出文件末尾部分
+ *
+ * 功能：tail [-n 行数 | -c 字节数] [文件...]。输入为普通文件时从末尾
+ *       向前定位，再用 copy_fd 输出；管道输入和 -f 等选项执行外部 tail
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_tail(Command *cmd) {
+    struct stat st;
+    long long count;
+    int bytes, first;
+    int result = 0;
+    int files, fd, i;
+    char *stdin_name = "-";
+    char **names;
+    off_t start;
+
+    if (!fastpath_usable(cmd) || parse_head_tail(cmd, &count, &bytes, &first) < 0) {
+        return execute_external(cmd);
+    }
+
+    files = cmd->argc - first;
+    names = files > 0 ? cmd->args + first : &stdin_name;
+    if (files == 0) {
+        files = 1;
+    }
+
+    /* 只处理可以定位的普通文件 */
+    for (i = 0; i < files; i++) {
+        if (strcmp(names[i], "-") == 0 ? fstat(STDIN_FILENO, &st) < 0 || !S_ISREG(st.st_mode)
+                                       : stat(names[i], &st) == 0 && !S_ISREG(st.st_mode)) {
+            return execute_external(cmd);
+        }
+    }
+
+    fflush(stdout);
+    for (i = 0; i < files; i++) {
+        fd = open_input("tail", names[i]);
+        if (fd < 0) {
+            result = -1;
+            continue;
+        }
+        if (files > 1) {
+            print_file_header(names[i], i);
+        }
+        if (fstat(fd, &st) < 0) {
+            start = -1;
+        } else if (bytes) {
+            start = count < st.st_size ? st.st_size - count : 0;
+        } else {
+            start = tail_start(fd, st.st_size, count);
+        }
+        if (start < 0 || lseek(fd, start, SEEK_SET) < 0 || copy_fd(fd, STDOUT_FILENO, -1) < 0) {
+            fprintf(stderr, "tail: %s: %s\n", names[i], strerror(errno));
+            result = -1;
+        }
+        close_input(fd);
+    }
+    return result;
+}
+
+/**
+ * WcCounts 结构体 - wc 的统计结果
+ *
+ * 字段说明：
+ *   lines  - 行数（换行符个数）
+ *   words  - 单词数
+ *   bytes  - 字节数
+ */
+typedef struct {
+    long long lines;
+    long long words;
+    long long bytes;
+} WcCounts;
+
+/**
+ * wc_count - 统计一个输入的行数、单词数和字节数
+ *
+ * 功能：只统计字节数且输入为普通文件时直接取文件大小，不读取内容
+ * 参数：fd - 输入描述符，counts - 输出参数，want_lines - 是否需要统计行数，
+ *       want_words - 是否需要统计单词
+ * 返回：0 表示成功，-1 表示失败
+ */
+static int wc_count(int fd, WcCounts *counts, int want_lines, int want_words) {
+    static char buffer[FAST_BUFFER_SIZE];
+    struct stat st;
+    off_t offset;
+    ssize_t n;
+    int in_word = 0;
+    ssize_t i;
+
+    memset(counts, 0, sizeof(*counts));
+    if (!want_lines && !want_words && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        (offset = lseek(fd, 0, SEEK_CUR)) >= 0) {
+        counts->bytes = st.st_size > offset ? st.st_size - offset : 0;
+        return 0;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (;;) {
+        n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? -1 : 0;
+        }
+        counts->bytes += n;
+        counts->lines += count_newlines(buffer, n);
+        if (want_words) {
+            for (i = 0; i < n; i++) {
+                unsigned char c = buffer[i];
+                int space = c == ' ' || (c >= '\t' && c <= '\r');
+                counts->words += !space && !in_word;
+                in_word = !space;
+            }
+        }
+    }
+}
+
+/**
+ * wc_print - 按 wc 的格式输出一行统计结果
+ */
+static void wc_print(const WcCounts *counts, int lines, int words, int bytes, int width, const char *name) {
+    const char *sep = "";
+
+    if (lines) {
+        printf("%*lld", width, counts->lines);
+        sep = " ";
+    }
+    if (words) {
+        printf("%s%*lld", sep, width, counts->words);
+        sep = " ";
+    }
+    if (bytes) {
+        printf("%s%*lld", sep, width, counts->bytes);
+    }
+    if (name != NULL) {
+        printf(" %s", name);
+    }
+    printf("\n");
+}
+
+/**
+ * cmd_wc - 统计行数、单词数和字节数
+ *
+ * 功能：wc [-lwc] [文件...]。换行符用 SIMD 统计（见 count_newlines），
+ *       -c 对普通文件直接取文件大小。-m、-L 等选项执行外部 wc
+ * 参数：cmd - Command 结构体指针
+ * 返回：0 表示成功，-1 表示失败
+ */
+int cmd_wc(Command *cmd) {
+    WcCounts *counts;
+    WcCounts total = { 0, 0, 0 };
+    struct stat st;
+    int lines = 0, words = 0, bytes = 0;
+    int result = 0;
+    int files, fd, i;
+    int width = 1;
+    int digits;
+    long long size_sum = 0;
+    char *stdin_name = "-";
+    char **names;
+    const char *p;
+    int *ok;
+
+    for (i = 1; i < cmd->argc && cmd->args[i][0] == '-' && cmd->args[i][1] != '\0'; i++) {
+        for (p = cmd->args[i] + 1; *p != '\0'; p++) {
+            if (*p == 'l') {
+                lines = 1;
+            } else if (*p == 'w') {
+                words = 1;
+            } else if (*p == 'c') {
+                bytes = 1;
+            } else {
+                return execute_external(cmd);
+            }
+        }
+    }
+    if (!fastpath_usable(cmd)) {
+        return execute_external(cmd);
+    }
+    if (!lines && !words && !bytes) {
+        lines = words = bytes = 1;
+    }
+
+    files = cmd->argc - i;
+    names = files > 0 ? cmd->args + i : &stdin_name;
+    counts = calloc(files > 0 ? files : 1, sizeof(WcCounts));
+    ok = calloc(files > 0 ? files : 1, sizeof(int));
+    if (counts == NULL || ok == NULL) {
+        perror("wc");
+        free(counts);
+        free(ok);
+        return -1;
+    }
+
+    for (i = 0; i < (files > 0 ? files : 1); i++) {
+        fd = open_input("wc", names[i]);
+        if (fd < 0) {
+            result = -1;
+            continue;
+        }
+        /* 列宽：普通文件取总大小的位数，有管道等输入时至少 7 位 */
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size_sum += st.st_size;
+        } else {
+            width = 7;
+        }
+        if (wc_count(fd, &counts[i], lines, words) < 0) {
+            fprintf(stderr, "wc: %s: %s\n", names[i], strerror(errno));
+            result = -1;
+        } else {
+            ok[i] = 1;
+            total.lines += counts[i].lines;
+            total.words += counts[i].words;
+            total.bytes += counts[i].bytes;
+        }
+        close_input(fd);
+    }
+
+    if (lines + words + bytes == 1 && files <= 1) {
+        width = 1;
+    } else {
+        for (digits = 1; size_sum >= 10; size_sum /= 10) {
+            digits++;
+        }
+        if (digits > width) {
+            width = digits;
+        }
+    }
+
+    for (i = 0; i < (files > 0 ? files : 1); i++) {
+        if (ok[i]) {
+            wc_print(&counts[i], lines, words, bytes, width, files > 0 ? names[i] : NULL);
+        }
+    }
+    if (files > 1) {
+        wc_print(&total, lines, words, bytes, width, "total");
+    }
+
+    free(counts);
+    free(ok);
+    return result;
+}
+
 /* ========== 外部程序执行和 I/O 重定向 ========== */
 
 /**
@@ -218,63 +895,315 @@ int setup_redirection(Command *cmd) {
     return 0;
 }
 
+/* 环境中没有 PATH 时查找程序的目录，与 execvp 相同 */
+#define DEFAULT_PATH "/bin:/usr/bin"
+
+/**
+ * env_name_length - 环境项中变量名的长度
+ *
+ * 参数：entry - "NAME=value" 或 "NAME"
+ */
+static int env_name_length(const char *entry) {
+    const char *eq = strchr(entry, '=');
+
+    return eq != NULL ? (int)(eq - entry) : (int)strlen(entry);
+}
+
+/**
+ * env_overridden - 判断变量是否被 cmd->env 中 from 之后的项设置或删除
+ */
+static int env_overridden(Command *cmd, const char *entry, int from) {
+    int len = env_name_length(entry);
+    int i;
+
+    for (i = from; i < cmd->env_count; i++) {
+        if (env_name_length(cmd->env[i]) == len &&
+            strncmp(cmd->env[i], entry, len) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * env_build - 构造子进程的环境
+ *
+ * 功能：数组只引用 environ 和 cmd->env 中的字符串，不复制也不修改
+ *       shell 自己的环境。被设置或删除的变量不从 environ 中取；
+ *       cmd->env 中同名的项以最后一个为准，删除项不放入结果
+ * 参数：cmd - Command 结构体指针
+ * 返回：以 NULL 结尾的数组，由调用者 free（字符串不需要释放），失败返回 NULL
+ */
+char** env_build(Command *cmd) {
+    char **envp;
+    int count = 0;
+    int n = 0;
+    int i;
+
+    if (!cmd->env_clear) {
+        while (environ[count] != NULL) {
+            count++;
+        }
+    }
+    envp = malloc((count + cmd->env_count + 1) * sizeof(char*));
+    if (envp == NULL) {
+        perror("myshell");
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!env_overridden(cmd, environ[i], 0)) {
+            envp[n++] = environ[i];
+        }
+    }
+    for (i = 0; i < cmd->env_count; i++) {
+        if (strchr(cmd->env[i], '=') != NULL && !env_overridden(cmd, cmd->env[i], i + 1)) {
+            envp[n++] = cmd->env[i];
+        }
+    }
+    envp[n] = NULL;
+    return envp;
+}
+
+/**
+ * exec_file - 用指定的环境执行程序文件
+ *
+ * 功能：没有 #! 行的脚本（ENOEXEC）交给 /bin/sh 执行，与 execvp 相同
+ * 参数：path - 程序路径，args - 参数数组，envp - 环境
+ */
+static void exec_file(const char *path, char **args, char **envp) {
+    char *argv[MAX_ARGS + 1];
+    int i;
+
+    execve(path, args, envp);
+    if (errno != ENOEXEC) {
+        return;
+    }
+    argv[0] = "sh";
+    argv[1] = (char *)path;
+    for (i = 1; args[i] != NULL; i++) {
+        argv[i + 1] = args[i];
+    }
+    argv[i + 1] = NULL;
+    execve("/bin/sh", argv, envp);
+    errno = ENOEXEC;
+}
+
+/**
+ * exec_command - 在子进程中执行外部程序
+ *
+ * 功能：没有 VAR=val 前缀或 env 设置时直接 execvp；否则用 env_build
+ *       构造的环境 execve，程序名不含 / 时按新环境中的 PATH 查找，
+ *       与 env 命令相同。shell 的环境在 fork 前后都不被修改
+ * 参数：cmd - Command 结构体指针
+ * 返回：只在失败时返回，errno 为失败原因（找不到为 ENOENT）
+ */
+void exec_command(Command *cmd) {
+    char path[MAX_PATH];
+    const char *dirs = DEFAULT_PATH;
+    const char *end;
+    char **envp;
+    int denied = 0;
+    int len, i;
+
+    if (cmd->env_count == 0 && !cmd->env_clear) {
+        execvp(cmd->args[0], cmd->args);
+        return;
+    }
+
+    envp = env_build(cmd);
+    if (envp == NULL) {
+        errno = ENOMEM;
+        return;
+    }
+    if (strchr(cmd->args[0], '/') != NULL) {
+        exec_file(cmd->args[0], cmd->args, envp);
+        return;
+    }
+
+    for (i = 0; envp[i] != NULL; i++) {
+        if (strncmp(envp[i], "PATH=", 5) == 0) {
+            dirs = envp[i] + 5;
+            break;
+        }
+    }
+    for (;;) {
+        end = strchr(dirs, ':');
+        len = end != NULL ? (int)(end - dirs) : (int)strlen(dirs);
+        /* 空的目录项表示当前目录 */
+        if (snprintf(path, sizeof(path), "%.*s%s%s", len, dirs, len > 0 ? "/" : "",
+                     cmd->args[0]) < (int)sizeof(path)) {
+            exec_file(path, cmd->args, envp);
+            if (errno == EACCES) {
+                denied = 1;
+            } else if (errno != ENOENT && errno != ENOTDIR) {
+                return;
+            }
+        }
+        if (end == NULL) {
+            break;
+        }
+        dirs = end + 1;
+    }
+    errno = denied ? EACCES : ENOENT;
+}
+
+/**
+ * exec_failed - 在子进程中报告 exec 失败
+ *
+ * 功能：输出错误信息，返回子进程的退出状态：找不到命令为 127，
+ *       找到但不能执行（没有权限、格式错误等）为 126
+ * 参数：name - 命令名
+ * 返回：退出状态
+ */
+int exec_failed(const char *name) {
+    int err = errno;
+
+    perror(name);
+    return err == ENOENT ? 127 : 126;
+}
+
 /**
  * execute_external - 执行外部程序
  *
  * 功能：使用 fork/exec 执行外部程序，支持后台执行
+ *       子进程登记到作业表中，通过 pidfd 等待和回收
  * 参数：cmd - Command 结构体指针
  * 返回：0 表示成功，-1 表示失败
  */
 int execute_external(Command *cmd) {
     pid_t pid;
     int status;
+    int ret;
+    int cgroup_fd;
+    char cgroup_path[MAX_PATH];
+    Placement placement;
+    int mux[4];
+    int muxed;
+    Job *job;
+
+    /* 开启 cgroup 隔离时，在 fork 之前准备好作业的 cgroup */
+    cgroup_fd = cgroup_prepare_job(cgroup_path, sizeof(cgroup_path));
+
+    /* 选择 CPU/NUMA 放置方案（taskset 或 affinity 策略） */
+    affinity_choose(cmd, &placement);
+
+    /* jobout 开启时，后台作业的输出经过 shell 持有的管道 */
+    muxed = cmd->background && mux_pipes(mux);
+
+    /* 刷新输出缓冲区，避免子进程继承未输出的内容 */
+    fflush(stdout);
 
     /* 创建子进程 */
-    pid = fork();
+    stats_add(STAT_EXTERNALS, 1);
+    pid = stats_fork();
 
     if (pid < 0) {
         /* fork 失败 */
         perror("fork");
+        if (muxed) {
+            mux_abort(mux);
+        }
+        if (cgroup_fd >= 0) {
+            close(cgroup_fd);
+            rmdir(cgroup_path);
+        }
         return -1;
     } else if (pid == 0) {
         /* 子进程 */
 
+        /* 加入作业 cgroup（失败时不隔离，继续执行），应用 ulimit 设置的
+         * 资源限制和 CPU/NUMA 放置 */
+        if (child_enter_job(cgroup_fd, &placement) < 0) {
+            _exit(1);
+        }
+
+        /* 交互时自成进程组，前台命令取得终端，信号处理恢复默认 */
+        job_child_setup(0, !cmd->background);
+
+        /* 限时命令自成进程组，超时时可以终止它派生的所有进程 */
+        if (cmd->timeout_ms > 0) {
+            setpgid(0, 0);
+        }
+
+        /* 先接上输出管道，显式的 > 重定向仍然优先 */
+        if (muxed) {
+            mux_child(mux);
+        }
+
         /* 设置 I/O 重定向 */
         if (setup_redirection(cmd) < 0) {
-            exit(1);
+            _exit(1);
         }
 
-        /* 执行外部程序 */
-        execvp(cmd->args[0], cmd->args);
+        /* 执行外部程序，VAR=val 前缀只出现在子进程的环境中 */
+        exec_command(cmd);
 
-        /* 如果 execvp 返回，说明执行失败 */
-        perror(cmd->args[0]);
-        exit(1);
+        /* 如果 exec 返回，说明执行失败；
+         * 使用 _exit 避免刷新从父进程继承的 stdio 缓冲区（会回退批处理文件的读取位置） */
+        _exit(exec_failed(cmd->args[0]));
     } else {
-        /* 父进程 */
+        /* 父进程：同样设置进程组，避免与子进程竞争 */
+        TRACE(exec_spawn, pid, cmd->args[0]);
+        job_set_group(pid, 0, !cmd->background);
+        if (cmd->timeout_ms > 0) {
+            setpgid(pid, pid);
+        }
+
+        /* 登记到作业表，作业结束时读取并删除其 cgroup */
+        job = job_add(pid, cmd);
+        if (job != NULL) {
+            snprintf(job->placement, sizeof(job->placement), "%s", placement.desc);
+        }
+        if (cgroup_fd >= 0) {
+            close(cgroup_fd);
+            if (job != NULL) {
+                snprintf(job->cgroup, sizeof(job->cgroup), "%s", cgroup_path);
+            }
+        }
 
         if (cmd->background) {
             /* 后台执行 */
-            printf("[后台进程] PID: %d\n", pid);
-        } else {
-            /* 前台执行，等待子进程结束 */
-            if (waitpid(pid, &status, 0) < 0) {
-                perror("waitpid");
-                return -1;
+            if (muxed) {
+                mux_attach(job ? job->id : 0, job ? job->cmdline : cmd->args[0], mux);
             }
+            printf("[后台进程] [%d] PID: %d\n", job ? job->id : 0, pid);
+            return 0;
+        }
 
-            /* 检查子进程退出状态 */
-            if (WIFEXITED(status)) {
-                /* 正常退出 */
-                int exit_status = WEXITSTATUS(status);
-                if (exit_status != 0) {
-                    /* 非零退出状态 */
-                    return -1;
-                }
-            } else {
-                /* 异常退出 */
+        /* 前台执行，通过 pidfd 等待子进程结束 */
+        if (job != NULL) {
+            ret = job_wait(job, &status);
+            if (ret < 0) {
+                return -1;
+            }
+            if (ret == 2) {
+                /* 被 Ctrl-Z 挂起转入后台 */
+                status_set(status_from_wait(status));
+                return -1;
+            }
+            if (ret > 0) {
+                fprintf(stderr, "timeout: 命令 '%s' 执行超时，已终止\n",
+                        cmd->args[0]);
+                /* 与 GNU timeout 相同：宽限期后被 SIGKILL 终止时为 128+9 */
+                status_set(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL ?
+                           128 + SIGKILL : 124);
                 return -1;
             }
+        } else if (job_wait_pid(pid, &status) < 0) {
+            /* 作业表内存不足时直接等待子进程 */
+            perror("waitpid");
+            job_foreground_done(0);
+            return -1;
+        } else {
+            job_foreground_done(status);
+        }
+
+        /* 记录子进程的退出状态：正常退出为退出码，被信号终止为 128+信号 */
+        status_set(status_from_wait(status));
+        TRACE(exec_done, status_get(), cmd->args[0]);
+        if (status_get() != 0) {
+            return -1;
         }
     }
 
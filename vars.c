@@ -0,0 +1,274 @@
+/*
+ * vars.c - MyShell 变量
+ *
+ * 功能：维护 shell 变量表和位置参数。shell 变量保存在哈希表中，
+ *       只在 shell 内部可见；对已在环境中的变量赋值时同时更新环境，
+ *       使子进程能看到新值
+ * 作者：操作系统课程项目
+ * 日期：2024-12-19
+ */
+
+#include "myshell.h"
+
+/* 哈希表桶数（2 的幂） */
+#define VAR_BUCKETS 256
+
+/**
+ * Var 结构体 - 一个 shell 变量
+ *
+ * 字段说明：
+ *   name   - 变量名
+ *   value  - 变量值
+ *   next   - 同一个桶中的下一个变量
+ */
+typedef struct Var {
+    char *name;
+    char *value;
+    struct Var *next;
+} Var;
+
+/* 变量哈希表 */
+static Var *var_table[VAR_BUCKETS];
+
+/* 位置参数：pos_args[0] 为 $0，pos_args[1..pos_count] 为 $1.. */
+static char *default_args[] = { "myshell", NULL };
+static char **pos_args = default_args;
+static int pos_count = 0;
+
+/* ========== 变量表 ========== */
+
+/**
+ * var_hash - 计算变量名的哈希值（FNV-1a）
+ */
+static unsigned int var_hash(const char *name) {
+    unsigned int hash = 2166136261u;
+
+    while (*name != '\0') {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash & (VAR_BUCKETS - 1);
+}
+
+/**
+ * var_find - 在哈希表中查找变量
+ *
+ * 参数：name - 变量名，link - 输出参数，保存指向该变量的链接（可为 NULL）
+ * 返回：变量，不存在返回 NULL
+ */
+static Var* var_find(const char *name, Var ***link) {
+    Var **p;
+
+    for (p = &var_table[var_hash(name)]; *p != NULL; p = &(*p)->next) {
+        if (strcmp((*p)->name, name) == 0) {
+            break;
+        }
+    }
+    if (link != NULL) {
+        *link = p;
+    }
+    return *p;
+}
+
+/**
+ * var_valid_name - 检查变量名是否合法
+ *
+ * 功能：变量名由字母、数字和下划线组成，不以数字开头
+ * 参数：name - 变量名，len - 长度（-1 表示到字符串结尾）
+ * 返回：1 表示合法，0 表示不合法
+ */
+int var_valid_name(const char *name, int len) {
+    int i;
+
+    if (len < 0) {
+        len = strlen(name);
+    }
+    if (len == 0 || (name[0] >= '0' && name[0] <= '9')) {
+        return 0;
+    }
+    for (i = 0; i < len; i++) {
+        char c = name[i];
+        if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+              (c >= '0' && c <= '9'))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * var_get - 获取变量值
+ *
+ * 功能：先查 shell 变量，再查环境变量
+ * 参数：name - 变量名
+ * 返回：变量值，未定义返回 NULL
+ */
+const char* var_get(const char *name) {
+    Var *var = var_find(name, NULL);
+
+    if (var != NULL) {
+        return var->value;
+    }
+    return getenv(name);
+}
+
+/**
+ * var_set - 设置变量
+ *
+ * 功能：变量已在环境中时直接更新环境，否则保存为 shell 变量
+ * 参数：name - 变量名，value - 变量值
+ * 返回：0 表示成功，-1 表示失败
+ */
+int var_set(const char *name, const char *value) {
+    Var **link;
+    Var *var;
+    char *copy;
+
+    if (!var_valid_name(name, -1)) {
+        fprintf(stderr, "myshell: '%s': 不是合法的变量名\n", name);
+        return -1;
+    }
+
+    if (getenv(name) != NULL) {
+        if (setenv(name, value, 1) < 0) {
+            perror("setenv");
+            return -1;
+        }
+        return 0;
+    }
+
+    var = var_find(name, &link);
+    copy = strdup(value);
+    if (copy == NULL) {
+        perror("myshell");
+        return -1;
+    }
+    if (var != NULL) {
+        free(var->value);
+        var->value = copy;
+        return 0;
+    }
+
+    var = malloc(sizeof(Var));
+    if (var == NULL || (var->name = strdup(name)) == NULL) {
+        perror("myshell");
+        free(var);
+        free(copy);
+        return -1;
+    }
+    var->value = copy;
+    var->next = NULL;
+    *link = var;
+    return 0;
+}
+
+/**
+ * var_unset - 删除变量
+ *
+ * 功能：同时删除同名的 shell 变量和环境变量
+ * 参数：name - 变量名
+ */
+void var_unset(const char *name) {
+    Var **link;
+    Var *var = var_find(name, &link);
+
+    if (var != NULL) {
+        *link = var->next;
+        free(var->name);
+        free(var->value);
+        free(var);
+    }
+    unsetenv(name);
+}
+
+/**
+ * var_export - 把变量放入环境
+ *
+ * 功能：value 为 NULL 时使用 shell 变量的当前值（未定义则为空串）。
+ *       放入环境后删除同名 shell 变量，此后的赋值直接更新环境
+ * 参数：name - 变量名，value - 新值（可为 NULL）
+ * 返回：0 表示成功，-1 表示失败
+ */
+int var_export(const char *name, const char *value) {
+    Var **link;
+    Var *var;
+
+    if (!var_valid_name(name, -1)) {
+        fprintf(stderr, "export: '%s': 不是合法的变量名\n", name);
+        return -1;
+    }
+
+    var = var_find(name, &link);
+    if (value == NULL) {
+        value = var != NULL ? var->value : getenv(name);
+    }
+    if (setenv(name, value != NULL ? value : "", 1) < 0) {
+        perror("setenv");
+        return -1;
+    }
+
+    if (var != NULL) {
+        *link = var->next;
+        free(var->name);
+        free(var->value);
+        free(var);
+    }
+    return 0;
+}
+
+/* ========== 位置参数 ========== */
+
+/**
+ * positional_get - 获取位置参数
+ *
+ * 参数：n - 序号，0 为 $0
+ * 返回：参数值，超出范围返回 NULL
+ */
+const char* positional_get(int n) {
+    if (n < 0 || n > pos_count) {
+        return NULL;
+    }
+    return pos_args[n];
+}
+
+/**
+ * positional_count - 获取位置参数个数（$#）
+ *
+ * 返回：参数个数，不含 $0
+ */
+int positional_count() {
+    return pos_count;
+}
+
+/**
+ * positional_swap - 交换位置参数
+ *
+ * 功能：用于调用函数时设置参数，返回后再交换回来。
+ *       数组为 args[0..count]，以 NULL 结尾，由调用者分配和释放
+ * 参数：args - 输入输出参数，新的参数数组/原参数数组，
+ *       count - 输入输出参数，新的参数个数/原参数个数
+ */
+void positional_swap(char ***args, int *count) {
+    char **old_args = pos_args;
+    int old_count = pos_count;
+
+    pos_args = *args;
+    pos_count = *count;
+    *args = old_args;
+    *count = old_count;
+}
+
+/**
+ * positional_shift - 左移位置参数（shift 命令）
+ *
+ * 参数：n - 移动的个数
+ * 返回：0 表示成功，-1 表示参数不足
+ */
+int positional_shift(int n) {
+    if (n < 0 || n > pos_count) {
+        return -1;
+    }
+    /* 参数数组由调用者所有，这里只移动指针，$0 保持不变 */
+    memmove(pos_args + 1, pos_args + 1 + n, (pos_count - n + 1) * sizeof(char *));
+    pos_count -= n;
+    return 0;
+}